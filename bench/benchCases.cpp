@@ -0,0 +1,57 @@
+#include <stdlib.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "framework/Bench.hpp"
+
+#include "rendering/render_target_bench.cpp"
+#include "rendering/column_sampler_bench.cpp"
+#include "rendering/dda_bench.cpp"
+#include "rendering/qsp_bench.cpp"
+#include "rendering/sprite_bench.cpp"
+#include "rendering/mipmap_bench.cpp"
+#include "rendering/palette_bench.cpp"
+#include "rendering/texture_layout_bench.cpp"
+#include "rendering/frame_bench.cpp"
+#include "pathfinding/astar_bench.cpp"
+#include "hashing/hashtable_bench.cpp"
+#include "io/png_bench.cpp"
+#include "io/json_bench.cpp"
+
+using namespace std;
+
+///
+/// Benchmark entry point
+///
+/// @param int argc: Call value
+/// @param char argv: [filter] [repetitions] [--json <file>], filter matches case names or tags
+///
+/// @return int
+///
+int main(int argc, char* argv[]) {
+    vector<string> positional;
+    string json_file;
+    for (int i = 1; i < argc; i++) {
+        if (string(argv[i]) == "--json" && i + 1 < argc) {
+            json_file = argv[++i];
+        } else {
+            positional.push_back(argv[i]);
+        }
+    }
+    string filter = positional.size() > 0 ? positional[0] : "";
+    int repetitions = positional.size() > 1 ? atoi(positional[1].c_str()) : BENCH_DEFAULT_REPETITIONS;
+    if (repetitions < 1) {
+        cerr << "Repetitions must be a positive number, got [" << positional[1] << "]" << endl
+            << "Usage: " << argv[0] << " [filter] [repetitions] [--json <file>]" << endl;
+        return 1;
+    }
+
+    // Benchmarks construct engine objects that log, keep that off the timings
+    loggingCfg.hide_infos = true;
+    debugContext = GLDebugContext(&loggingCfg);
+
+    int ran = Bench::runAll(filter, BENCH_DEFAULT_WARMUP, repetitions, json_file);
+    return ran > 0 ? 0 : 1;
+}
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <math.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace Bench {
+
+#define BENCH_DEFAULT_WARMUP 3
+#define BENCH_DEFAULT_REPETITIONS 15
+
+typedef chrono::steady_clock Clock;
+
+///
+/// Result of timing one benchmark body
+///
+struct Result {
+    // Case the body was timed in
+    string case_name;
+    string name;
+    double median_ms;
+    // Median absolute deviation from the median, the spread that one slow run can not skew
+    double mad_ms;
+    double min_ms;
+    double max_ms;
+    int repetitions;
+};
+
+///
+/// Handed to every benchmark case, times bodies and prints their results
+///
+class Runner {
+    public:
+        Runner(int warmup, int repetitions);
+
+        Result run(const string& name, const function<void()>& body);
+        const vector<Result>& results() const;
+        bool writeJSON(const string& filename) const;
+
+        string case_name;
+    private:
+        int warmup;
+        int repetitions;
+        vector<Result> collected;
+};
+
+typedef void (*CaseFunc)(Runner&);
+
+struct Case {
+    string name;
+    string tags;
+    CaseFunc func;
+};
+
+inline vector<Case>& registry() {
+    static vector<Case> cases;
+    return cases;
+}
+
+struct Registrar {
+    Registrar(const string& name, const string& tags, CaseFunc func) {
+        registry().push_back(Case{name, tags, func});
+    }
+};
+
+///
+/// Keep the optimiser from discarding a value computed only for timing
+///
+/// @param T value: Value to keep alive
+///
+/// @return void
+///
+template <typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+///
+/// @param string text: Text to write inside a JSON string
+///
+/// @return string: Text with quotes and backslashes escaped
+///
+inline string jsonEscape(const string& text) {
+    string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+// The median and MAD need at least one sample
+Runner::Runner(int warmup, int repetitions):
+    warmup(warmup),
+    repetitions(max(repetitions, 1))
+{};
+
+///
+/// Time a body, discarding the first warmup runs
+///
+/// @param string name: Label printed with the result
+/// @param function body: Work to time, must be repeatable
+///
+/// @return Result
+///
+Result Runner::run(const string& name, const function<void()>& body) {
+    for (int i = 0; i < this->warmup; i++) {
+        body();
+    }
+    vector<double> samples(this->repetitions);
+    for (int i = 0; i < this->repetitions; i++) {
+        Clock::time_point start = Clock::now();
+        body();
+        samples[i] = chrono::duration<double, milli>(Clock::now() - start).count();
+    }
+    sort(samples.begin(), samples.end());
+    double median = samples[samples.size() / 2];
+    vector<double> deviations(samples.size());
+    for (size_t i = 0; i < samples.size(); i++) {
+        deviations[i] = fabs(samples[i] - median);
+    }
+    nth_element(deviations.begin(), deviations.begin() + deviations.size() / 2, deviations.end());
+    Result result{this->case_name, name, median, deviations[deviations.size() / 2], samples.front(), samples.back(), this->repetitions};
+    printf("  %-56s median %10.3f ms | mad %8.3f ms | min %10.3f ms | max %10.3f ms\n",
+        name.c_str(), result.median_ms, result.mad_ms, result.min_ms, result.max_ms);
+    this->collected.push_back(result);
+    return result;
+};
+
+const vector<Result>& Runner::results() const {
+    return this->collected;
+};
+
+///
+/// Write every result so far as a JSON array, for comparing runs with other tools
+///
+/// @param string filename: Output file path
+///
+/// @return bool: False if the file could not be written
+///
+bool Runner::writeJSON(const string& filename) const {
+    FILE* file = fopen(filename.c_str(), "w");
+    if (file == nullptr) {
+        return false;
+    }
+    fprintf(file, "[\n");
+    for (size_t i = 0; i < this->collected.size(); i++) {
+        const Result& result = this->collected[i];
+        fprintf(file, "    {\"case\": \"%s\", \"name\": \"%s\", \"median_ms\": %.6f, \"mad_ms\": %.6f, \"min_ms\": %.6f, \"max_ms\": %.6f, \"repetitions\": %d}%s\n",
+            jsonEscape(result.case_name).c_str(), jsonEscape(result.name).c_str(), result.median_ms, result.mad_ms, result.min_ms, result.max_ms, result.repetitions,
+            i + 1 < this->collected.size() ? "," : "");
+    }
+    fprintf(file, "]\n");
+    return fclose(file) == 0;
+};
+
+///
+/// Run every registered case whose name or tags contain the filter
+///
+/// @param string filter: Substring to select cases by, empty runs all
+/// @param int warmup: Untimed runs per body
+/// @param int repetitions: Timed runs per body
+/// @param string json_file: Also write the results to this file as JSON, empty writes none
+///
+/// @return int: Number of cases run
+///
+inline int runAll(const string& filter, int warmup = BENCH_DEFAULT_WARMUP, int repetitions = BENCH_DEFAULT_REPETITIONS,
+    const string& json_file = "") {
+    Runner runner(warmup, repetitions);
+    int ran = 0;
+    for (const Case& c : registry()) {
+        if (!filter.empty() && c.name.find(filter) == string::npos && c.tags.find(filter) == string::npos) {
+            continue;
+        }
+        printf("%s %s\n", c.name.c_str(), c.tags.c_str());
+        runner.case_name = c.name;
+        c.func(runner);
+        ran++;
+    }
+    if (!json_file.empty() && !runner.writeJSON(json_file)) {
+        fprintf(stderr, "Unable to write benchmark results: %s\n", json_file.c_str());
+    }
+    return ran;
+}
+}
+
+#define BENCH_CONCAT_(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_(a, b)
+#define BENCH_CASE_(func, name, tags) \
+    static void func(Bench::Runner& bench); \
+    static Bench::Registrar BENCH_CONCAT(func, _registrar)(name, tags, &func); \
+    static void func(Bench::Runner& bench)
+
+///
+/// Declare a benchmark case, the body receives a Bench::Runner named bench
+///
+#define BENCH_CASE(name, tags) BENCH_CASE_(BENCH_CONCAT(bench_case_, __COUNTER__), name, tags)
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#ifdef __linux__
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace Bench {
+
+#define BENCH_L1_BYTES 32768
+#define BENCH_L1_WAYS 8
+#define BENCH_CACHE_LINE 64
+
+///
+/// Hardware count of L1 data cache read misses on this thread, through
+/// perf_event_open. Unavailable off Linux, in most VMs and containers, and
+/// wherever perf_event_paranoid forbids it, so callers check available()
+///
+class CacheCounter {
+    public:
+        CacheCounter();
+        ~CacheCounter();
+
+        bool available() const;
+        void start();
+        uint64_t stop();
+    private:
+        int fd;
+};
+
+CacheCounter::CacheCounter():
+    fd(-1)
+{
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    this->fd = (int) syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+};
+
+CacheCounter::~CacheCounter() {
+#ifdef __linux__
+    if (this->fd >= 0) {
+        close(this->fd);
+    }
+#endif
+};
+
+bool CacheCounter::available() const {
+    return this->fd >= 0;
+};
+
+void CacheCounter::start() {
+#ifdef __linux__
+    if (this->fd >= 0) {
+        ioctl(this->fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(this->fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+};
+
+///
+/// @return uint64_t: Misses since start(), 0 if unavailable
+///
+uint64_t CacheCounter::stop() {
+    uint64_t count = 0;
+#ifdef __linux__
+    if (this->fd >= 0) {
+        ioctl(this->fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(this->fd, &count, sizeof(count)) != sizeof(count)) {
+            count = 0;
+        }
+    }
+#endif
+    return count;
+};
+
+///
+/// Set associative LRU model of an L1 data cache, fed addresses one load at a
+/// time. Gives a repeatable miss count for an access pattern where hardware
+/// counters are unavailable, though it knows nothing of prefetching
+///
+class CacheModel {
+    public:
+        CacheModel(size_t bytes = BENCH_L1_BYTES, int ways = BENCH_L1_WAYS);
+
+        inline void access(const void* address);
+        void reset();
+
+        size_t accesses;
+        size_t misses;
+    private:
+        int ways;
+        size_t sets;
+        // Line tags of each set, most recently used first
+        vector<uintptr_t> tags;
+};
+
+CacheModel::CacheModel(size_t bytes, int ways):
+    accesses(0),
+    misses(0),
+    ways(ways),
+    sets(bytes / BENCH_CACHE_LINE / ways),
+    tags(bytes / BENCH_CACHE_LINE, 0)
+{};
+
+inline void CacheModel::access(const void* address) {
+    uintptr_t line = (uintptr_t) address / BENCH_CACHE_LINE;
+    uintptr_t* set = &this->tags[(line % this->sets) * this->ways];
+    // Tags are stored plus one so an empty way never matches
+    uintptr_t tag = line + 1;
+    int way = 0;
+    while (way < this->ways && set[way] != tag) {
+        way++;
+    }
+    this->accesses++;
+    if (way == this->ways) {
+        this->misses++;
+        way = this->ways - 1;
+    }
+    for (; way > 0; way--) {
+        set[way] = set[way - 1];
+    }
+    set[0] = tag;
+};
+
+void CacheModel::reset() {
+    fill(this->tags.begin(), this->tags.end(), 0);
+    this->accesses = 0;
+    this->misses = 0;
+};
+}
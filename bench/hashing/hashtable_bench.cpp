@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "../../src/logic/hashing/HashTable.cpp"
+#include "../framework/Bench.hpp"
+
+using namespace std;
+
+///
+/// @param int count: Keys to make
+///
+/// @return vector<string>: Distinct keys the length of texture names
+///
+static vector<string> hashTableBenchKeys(int count) {
+    vector<string> keys;
+    for (int i = 0; i < count; i++) {
+        keys.push_back("texture_" + to_string(i));
+    }
+    return keys;
+}
+
+BENCH_CASE("11.1: HashTable insert and get, by element count", "[hashing]") {
+    for (int count : {100, 1000, 5000}) {
+        vector<string> keys = hashTableBenchKeys(count);
+        bench.run("insert " + to_string(count) + " keys into " + to_string(HASH_TABLE_MAX_SIZE) + " buckets", [&]() {
+            HashTable<int> table(HASH_TABLE_MAX_SIZE);
+            for (int i = 0; i < count; i++) {
+                table.insert(keys[i], i);
+            }
+            Bench::doNotOptimize(table.size());
+        });
+        HashTable<int> table(HASH_TABLE_MAX_SIZE);
+        for (int i = 0; i < count; i++) {
+            table.insert(keys[i], i);
+        }
+        bench.run("get " + to_string(count) + " keys from " + to_string(HASH_TABLE_MAX_SIZE) + " buckets", [&]() {
+            int found = 0, value;
+            for (int i = 0; i < count; i++) {
+                found += table.get(keys[i], value);
+            }
+            Bench::doNotOptimize(found);
+        });
+    }
+}
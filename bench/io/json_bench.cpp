@@ -0,0 +1,72 @@
+#pragma once
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "../../src/io/resource_management/JSONParser.hpp"
+#include "../../src/rendering/Globals.hpp"
+#include "../framework/Bench.hpp"
+
+using namespace std;
+
+///
+/// Map JSON with every cell written out the way the shipped maps are, walls
+/// around the border and open cells inside
+///
+/// @param int size: Cells along each side
+///
+/// @return string
+///
+static string jsonBenchMap(int size) {
+    ostringstream out;
+    out << "{\"Params\": {\"Name\": \"bench\", \"Width\": " << size << ", \"Height\": " << size
+        << ", \"Start\": {\"x\": 1, \"y\": 1}, \"End\": {\"x\": " << size - 2 << ", \"y\": " << size - 2 << "}},"
+        << " \"Ceiling\": \"wood\", \"Floor\": \"greystone\", \"Sprites\": [], \"Walls\": [";
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            bool border = x == 0 || y == 0 || x == size - 1 || y == size - 1;
+            string face = string("{\"Colour\": \"0xFFFFFF\", \"Texture\": \"") + (border ? "colorstone" : "") + "\"}";
+            out << (x == 0 && y == 0 ? "" : ", ") << "{\"x\": " << x << ", \"y\": " << y
+                << ", \"Type\": \"" << (border ? "Wall" : "None") << "\", \"Left\": " << face << ", \"Right\": " << face
+                << ", \"Up\": " << face << ", \"Down\": " << face << "}";
+        }
+    }
+    out << "]}";
+    return out.str();
+}
+
+///
+/// Parse a map and read every wall field World::readMapFromJSON reads
+///
+/// @param string text: Map JSON
+///
+/// @return int: Sum of the wall coordinates, so the reads are kept
+///
+static int jsonBenchParse(const string& text) {
+    ResourceManager::RSJresource map(text);
+    int sum = map["Params"]["Width"].as<int>() + map["Params"]["Height"].as<int>();
+    for (ResourceManager::RSJresource wall : map["Walls"].as_array()) {
+        sum += wall["x"].as<int>() + wall["y"].as<int>();
+        sum += wall["Type"].as<string>().size();
+        for (const char* face : {"Left", "Right", "Up", "Down"}) {
+            ResourceManager::RSJobject side = wall[face].as<ResourceManager::RSJobject>();
+            sum += side["Colour"].as<string>().size() + side["Texture"].as<string>().size();
+        }
+    }
+    return sum;
+}
+
+BENCH_CASE("13.1: RSJresource parsing of maps, by map size", "[json]") {
+    ifstream file(MAPS_DIR + "map2.json");
+    stringstream shipped;
+    shipped << file.rdbuf();
+    string map2 = shipped.str();
+    bench.run("map2.json, 24x24", [&]() { Bench::doNotOptimize(jsonBenchParse(map2)); });
+    for (int size : {32, 64}) {
+        string text = jsonBenchMap(size);
+        bench.run("generated " + to_string(size) + "x" + to_string(size) + " map", [&]() {
+            Bench::doNotOptimize(jsonBenchParse(text));
+        });
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "../../src/io/resource_management/PNGReader.hpp"
+#include "../../src/rendering/Globals.hpp"
+#include "../framework/Bench.hpp"
+
+using namespace std;
+
+BENCH_CASE("12.1: PNG::decodePNG of the shipped textures", "[png]") {
+    const vector<string> files = {
+        "surfaces/bluestone.png", "surfaces/colorstone.png", "surfaces/eagle.png", "surfaces/greystone.png",
+        "surfaces/mossy.png", "surfaces/purplestone.png", "surfaces/redbrick.png", "surfaces/wood.png",
+        "sprites/barrel.png", "sprites/greenlight.png", "sprites/pillar.png"
+    };
+    // Read up front so only decoding is timed
+    vector<vector<unsigned char>> encoded(files.size());
+    for (size_t i = 0; i < files.size(); i++) {
+        ResourceManager::PNG::loadFile(encoded[i], TEX_DIR + files[i]);
+    }
+    bench.run("decode " + to_string(files.size()) + " textures", [&]() {
+        vector<unsigned char> image;
+        unsigned long width, height;
+        for (const vector<unsigned char>& png : encoded) {
+            Bench::doNotOptimize(ResourceManager::PNG::decodePNG(image, width, height, png));
+        }
+        Bench::doNotOptimize(image.data());
+    });
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../../src/environment/world/World.cpp"
+#include "../../src/logic/pathfinding/AStar.cpp"
+#include "../framework/Bench.hpp"
+
+using namespace std;
+
+///
+/// Bordered map with pillars scattered over a fraction of the inner cells, and
+/// the open cell furthest from the top left one to find a path to
+///
+struct AStarBenchScene {
+    World world;
+    Coords start;
+    Coords goal;
+
+    AStarBenchScene(int size, double density) {
+        mt19937 gen(7);
+        uniform_real_distribution<double> unit(0, 1);
+        vector<Constructs::AABB> walls;
+        for (int y = 0; y < size; y++) {
+            for (int x = 0; x < size; x++) {
+                bool border = x == 0 || y == 0 || x == size - 1 || y == size - 1;
+                bool solid = border || (!(x == 1 && y == 1) && unit(gen) < density);
+                // AStar tells walls apart by their texture
+                walls.push_back(Constructs::AABB(x, y, solid ? TEX_HANDLE_MISSING : TEX_HANDLE_NONE,
+                    solid ? Constructs::WallType::WALL : Constructs::WallType::NONE));
+            }
+        }
+        this->world = World(walls, size, size);
+        this->start = Coords(1, 1);
+        this->goal = furthestReachable(size);
+    }
+
+    // AStar::find does not return when the goal can not be reached, so the goal is found by walking out from the start
+    Coords furthestReachable(int size) {
+        vector<bool> seen(size * size, false);
+        queue<Coords> open;
+        open.push(this->start);
+        seen[this->start.y * size + this->start.x] = true;
+        Coords last = this->start;
+        while (!open.empty()) {
+            last = open.front();
+            open.pop();
+            const int dx[4] = {1, -1, 0, 0};
+            const int dy[4] = {0, 0, 1, -1};
+            for (int i = 0; i < 4; i++) {
+                int x = last.x + dx[i], y = last.y + dy[i];
+                if (!seen[y * size + x] && this->world.getAt(x, y).type == Constructs::WallType::NONE) {
+                    seen[y * size + x] = true;
+                    open.push(Coords(x, y));
+                }
+            }
+        }
+        return last;
+    }
+};
+
+BENCH_CASE("10.1: AStar::find across the map, by map size", "[astar]") {
+    for (int size : {16, 32, 64}) {
+        AStarBenchScene scene(size, 0.2);
+        AStar astar(scene.world);
+        bench.run(to_string(size) + "x" + to_string(size) + " map, 20% pillars", [&]() {
+            vector<Coords>* path = astar.find(scene.start, scene.goal);
+            Bench::doNotOptimize(path->size());
+            delete path;
+        });
+    }
+}
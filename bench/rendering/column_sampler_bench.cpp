@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+
+#include "../../src/rendering/texturing/ColumnSampler.hpp"
+#include "../framework/Bench.hpp"
+
+using namespace std;
+
+#define COLUMN_BENCH_TEX_SHIFT 6
+#define COLUMN_BENCH_COLUMNS 1024
+
+///
+/// Sample a screen's worth of wall columns of one height, alternating shade
+/// and texture column per x the way the wall pass does
+///
+static void sampleColumns(Rendering::ColumnSampler sampler, const vector<uint32_t>& texels, vector<uint32_t>& out, int height) {
+    Rendering::ColumnSpan span;
+    span.width_shift = COLUMN_BENCH_TEX_SHIFT;
+    span.row_shift = 32 - COLUMN_BENCH_TEX_SHIFT;
+    span.v_step = 0u - Rendering::toColumnV(double(1 << COLUMN_BENCH_TEX_SHIFT) / height, COLUMN_BENCH_TEX_SHIFT);
+    for (int x = 0; x < COLUMN_BENCH_COLUMNS; x++) {
+        span.texels = texels.data() + (x & ((1 << COLUMN_BENCH_TEX_SHIFT) - 1));
+        span.v = span.v_step * x;
+        span.shade_shift = x & 1;
+        span.shade_mask = x & 1 ? 0x7F7F7F : 0xFFFFFFFF;
+        sampler(span, out.data(), height);
+        Bench::doNotOptimize(out[height - 1]);
+    }
+}
+
+BENCH_CASE("2.1: Wall column sampler, scalar vs SIMD across line heights", "[column-sampler]") {
+    vector<uint32_t> texels(1 << (2 * COLUMN_BENCH_TEX_SHIFT));
+    for (size_t i = 0; i < texels.size(); i++) {
+        texels[i] = 0xFF000000 | (uint32_t) (i * 2654435761u);
+    }
+    const int heights[] = {8, 16, 32, 64, 128, 256, 512, 1000, 2000, 4000};
+    for (int height : heights) {
+        vector<uint32_t> out(height);
+        string label = to_string(COLUMN_BENCH_COLUMNS) + " columns of " + to_string(height) + " px";
+        bench.run(label + ": scalar", [&]() {
+            sampleColumns(Rendering::sampleColumnScalar, texels, out, height);
+        });
+#ifdef COLUMN_SAMPLER_X86
+        bench.run(label + ": SSE2", [&]() {
+            sampleColumns(Rendering::sampleColumnSSE2, texels, out, height);
+        });
+        if (__builtin_cpu_supports("avx2")) {
+            bench.run(label + ": AVX2", [&]() {
+                sampleColumns(Rendering::sampleColumnAVX2, texels, out, height);
+            });
+        }
+#endif
+    }
+}
@@ -0,0 +1,253 @@
+#pragma once
+
+#include <math.h>
+
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "../../src/rendering/raycaster/DDA.hpp"
+#include "../../src/rendering/raycaster/OccupancyGrid.cpp"
+#include "../../src/rendering/raycaster/RayPacket.hpp"
+#include "../framework/Bench.hpp"
+
+using namespace std;
+
+#define DDA_BENCH_MAP_SIZE 64
+#define DDA_BENCH_RAYS 100000
+// One room per this many cells of a generated dungeon, leaving open ground between them
+#define DDA_BENCH_CELLS_PER_ROOM 4096
+// Screen columns per view of a camera fan
+#define DDA_BENCH_COLUMNS 640
+
+///
+/// Bordered grid with scattered pillars and rays from open cells, in the
+/// range of directions the camera produces
+///
+struct DDABenchScene {
+    vector<char> cells;
+    vector<double> origin_x, origin_y, dir_x, dir_y;
+
+    DDABenchScene(double density) : cells(DDA_BENCH_MAP_SIZE * DDA_BENCH_MAP_SIZE) {
+        mt19937 gen(7);
+        uniform_real_distribution<double> unit(0, 1);
+        for (int y = 0; y < DDA_BENCH_MAP_SIZE; y++) {
+            for (int x = 0; x < DDA_BENCH_MAP_SIZE; x++) {
+                bool border = x == 0 || y == 0 || x == DDA_BENCH_MAP_SIZE - 1 || y == DDA_BENCH_MAP_SIZE - 1;
+                this->cells[y * DDA_BENCH_MAP_SIZE + x] = border || unit(gen) < density;
+            }
+        }
+        for (int i = 0; i < DDA_BENCH_RAYS; i++) {
+            double x, y;
+            do {
+                x = 1 + unit(gen) * (DDA_BENCH_MAP_SIZE - 2);
+                y = 1 + unit(gen) * (DDA_BENCH_MAP_SIZE - 2);
+            } while ((*this)((int) x, (int) y));
+            double angle = unit(gen) * 2 * M_PI;
+            double length = 1 + unit(gen) * 0.2;
+            this->origin_x.push_back(x);
+            this->origin_y.push_back(y);
+            this->dir_x.push_back(cos(angle) * length);
+            this->dir_y.push_back(sin(angle) * length);
+        }
+    }
+
+    inline bool operator()(int x, int y) const {
+        return this->cells[y * DDA_BENCH_MAP_SIZE + x] != 0;
+    }
+};
+
+template <typename Scene, typename Cast>
+static void castAll(const Scene& scene, Cast cast) {
+    double total = 0;
+    for (int i = 0; i < DDA_BENCH_RAYS; i++) {
+        total += cast(scene.origin_x[i], scene.origin_y[i], scene.dir_x[i], scene.dir_y[i]).perp_wall_dist;
+    }
+    Bench::doNotOptimize(total);
+}
+
+static void benchDDA(Bench::Runner& bench, double density, const string& label,
+    double max_dist = numeric_limits<double>::infinity()) {
+    DDABenchScene scene(density);
+    string name = to_string(DDA_BENCH_RAYS) + " rays, " + label;
+    bench.run(name + ": double", [&]() {
+        castAll(scene, [&](double ox, double oy, double dx, double dy) {
+            return Rendering::castRayDouble(ox, oy, dx, dy, scene, max_dist);
+        });
+    });
+    bench.run(name + ": 16.16 fixed", [&]() {
+        castAll(scene, [&](double ox, double oy, double dx, double dy) {
+            return Rendering::castRayFixed<Rendering::Fixed16>(ox, oy, dx, dy, scene, max_dist);
+        });
+    });
+    bench.run(name + ": 32.32 fixed", [&]() {
+        castAll(scene, [&](double ox, double oy, double dx, double dy) {
+            return Rendering::castRayFixed<Rendering::Fixed32>(ox, oy, dx, dy, scene, max_dist);
+        });
+    });
+}
+
+BENCH_CASE("3.1: DDA traversal, double vs fixed point, short rays", "[dda]") {
+    benchDDA(bench, 0.15, "15% walls");
+}
+
+BENCH_CASE("3.2: DDA traversal, double vs fixed point, long rays", "[dda]") {
+    benchDDA(bench, 0.01, "1% walls");
+}
+
+BENCH_CASE("3.3: DDA traversal, double vs fixed point, long rays capped at 8 cells", "[dda]") {
+    benchDDA(bench, 0.01, "1% walls, 8 cells", 8.0);
+}
+
+///
+/// Dungeon in the style of test/case_generator/dungeon_gen.py: walled rooms
+/// with a doorway on each side scattered over open ground inside a border wall
+///
+struct DungeonBenchScene {
+    int size;
+    vector<char> cells;
+    vector<double> origin_x, origin_y, dir_x, dir_y;
+
+    DungeonBenchScene(int size) : size(size), cells((size_t) size * size, 0) {
+        mt19937 gen(11);
+        uniform_int_distribution<int> room_size(5, 12);
+        uniform_real_distribution<double> unit(0, 1);
+        for (int i = 0; i < size; i++) {
+            this->set(i, 0);
+            this->set(i, size - 1);
+            this->set(0, i);
+            this->set(size - 1, i);
+        }
+        int rooms = max(1, size * size / DDA_BENCH_CELLS_PER_ROOM);
+        for (int r = 0; r < rooms; r++) {
+            int w = room_size(gen), h = room_size(gen);
+            int x0 = 1 + (int) (unit(gen) * (size - w - 2));
+            int y0 = 1 + (int) (unit(gen) * (size - h - 2));
+            for (int x = x0; x < x0 + w; x++) {
+                if (x != x0 + w / 2) {
+                    this->set(x, y0);
+                    this->set(x, y0 + h - 1);
+                }
+            }
+            for (int y = y0; y < y0 + h; y++) {
+                if (y != y0 + h / 2) {
+                    this->set(x0, y);
+                    this->set(x0 + w - 1, y);
+                }
+            }
+        }
+        for (int i = 0; i < DDA_BENCH_RAYS; i++) {
+            double x, y;
+            do {
+                x = 1 + unit(gen) * (size - 2);
+                y = 1 + unit(gen) * (size - 2);
+            } while ((*this)((int) x, (int) y));
+            double angle = unit(gen) * 2 * M_PI;
+            double length = 1 + unit(gen) * 0.2;
+            this->origin_x.push_back(x);
+            this->origin_y.push_back(y);
+            this->dir_x.push_back(cos(angle) * length);
+            this->dir_y.push_back(sin(angle) * length);
+        }
+    }
+
+    inline void set(int x, int y) {
+        this->cells[(size_t) y * this->size + x] = 1;
+    }
+
+    inline bool operator()(int x, int y) const {
+        return this->cells[(size_t) y * this->size + x] != 0;
+    }
+};
+
+template <typename Scene, typename Cast>
+static double meanSteps(const Scene& scene, Cast cast) {
+    double steps = 0;
+    for (int i = 0; i < DDA_BENCH_RAYS; i++) {
+        steps += cast(scene.origin_x[i], scene.origin_y[i], scene.dir_x[i], scene.dir_y[i]).steps;
+    }
+    return steps / DDA_BENCH_RAYS;
+}
+
+BENCH_CASE("3.4: DDA traversal, cell by cell vs occupancy pyramid, generated dungeons", "[dda]") {
+    const int sizes[] = {64, 256, 1024, 4096};
+    for (int size : sizes) {
+        DungeonBenchScene scene(size);
+        Rendering::OccupancyGrid grid;
+        grid.rebuild(size, size, scene);
+        auto cell_dda = [&](double ox, double oy, double dx, double dy) {
+            return Rendering::castRayDouble(ox, oy, dx, dy, scene);
+        };
+        auto hierarchical = [&](double ox, double oy, double dx, double dy) {
+            return Rendering::castRayHierarchical(ox, oy, dx, dy, grid);
+        };
+        string name = to_string(DDA_BENCH_RAYS) + " rays, " + to_string(size) + "^2";
+        printf("  %s: mean steps per ray, cell DDA %.1f, occupancy pyramid %.1f (%zu bytes)\n",
+            name.c_str(), meanSteps(scene, cell_dda), meanSteps(scene, hierarchical), grid.bytes());
+        bench.run(name + ": cell DDA", [&]() {
+            castAll(scene, cell_dda);
+        });
+        bench.run(name + ": occupancy pyramid", [&]() {
+            castAll(scene, hierarchical);
+        });
+    }
+}
+
+BENCH_CASE("3.5: DDA traversal, one ray at a time vs ray packets, camera fans", "[dda]") {
+    const double densities[] = {0.05, 0.2};
+    for (double density : densities) {
+        // Whole screens of adjacent columns, as the renderer casts them
+        DDABenchScene scene(density);
+        const int views = DDA_BENCH_RAYS / DDA_BENCH_COLUMNS;
+        vector<Rendering::CameraRay> rays((size_t) views * DDA_BENCH_COLUMNS);
+        for (int view = 0; view < views; view++) {
+            for (int column = 0; column < DDA_BENCH_COLUMNS; column++) {
+                double camera_x = 2 * column / double(DDA_BENCH_COLUMNS) - 1;
+                rays[view * DDA_BENCH_COLUMNS + column] = Rendering::CameraRay{
+                    scene.origin_x[view], scene.origin_y[view],
+                    scene.dir_x[view] - scene.dir_y[view] * 0.66 * camera_x,
+                    scene.dir_y[view] + scene.dir_x[view] * 0.66 * camera_x
+                };
+            }
+        }
+        Rendering::RayHitBuffer hits;
+        hits.resize((int) rays.size());
+        string name = to_string(rays.size()) + " rays, density " + to_string(density).substr(0, 4);
+        // Rays per second from a run's median, in millions
+        auto rate = [&](const Bench::Result& result) {
+            return rays.size() / result.median_ms / 1000;
+        };
+        double single = rate(bench.run(name + ": one ray at a time", [&]() {
+            double total = 0;
+            for (const Rendering::CameraRay& ray : rays) {
+                total += Rendering::castRayDouble(ray.origin_x, ray.origin_y, ray.dir_x, ray.dir_y, scene).perp_wall_dist;
+            }
+            Bench::doNotOptimize(total);
+        }));
+        printf("  %s: one ray at a time %.1f Mrays/s\n", name.c_str(), single);
+        const Rendering::RayPacketLevel levels[] = {
+            Rendering::RayPacketLevel::RAY_PACKET_NONE,
+            Rendering::RayPacketLevel::RAY_PACKET_SSE2,
+            Rendering::RayPacketLevel::RAY_PACKET_AVX2
+        };
+        const char* level_names[] = {"scalar", "SSE2", "AVX2"};
+        // The occupancy grid lets the AVX2 packets look up all their cells at once
+        Rendering::OccupancyGrid grid;
+        grid.rebuild(DDA_BENCH_MAP_SIZE, DDA_BENCH_MAP_SIZE, scene);
+        for (int i = 0; i < 3; i++) {
+            if (!Rendering::rayPacketLevelSupported(levels[i])) {
+                continue;
+            }
+            double packets = rate(bench.run(name + ": packets, " + level_names[i], [&]() {
+                Rendering::castRays(rays, 0, (int) rays.size(), scene, hits, numeric_limits<double>::infinity(), levels[i]);
+                Bench::doNotOptimize(hits.perp_wall_dist[0]);
+            }));
+            double packets_grid = rate(bench.run(name + ": packets, " + level_names[i] + ", occupancy grid", [&]() {
+                Rendering::castRays(rays, 0, (int) rays.size(), grid, hits, numeric_limits<double>::infinity(), levels[i]);
+                Bench::doNotOptimize(hits.perp_wall_dist[0]);
+            }));
+            printf("  %s: %s packets %.1f Mrays/s (x%.2f), through the occupancy grid %.1f Mrays/s (x%.2f)\n", name.c_str(),
+                level_names[i], packets, packets / single, packets_grid, packets_grid / single);
+        }
+    }
+}
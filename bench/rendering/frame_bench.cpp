@@ -0,0 +1,126 @@
+#pragma once
+
+#include <math.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../src/io/configuration/ConfigInit.cpp"
+#include "../../src/io/resource_management/TextureLoader.cpp"
+#include "../../src/environment/world/World.cpp"
+#include "../../src/environment/player/Player.cpp"
+#include "../../src/rendering/viewmodel/CameraPath.hpp"
+#include "../../src/rendering/raycaster/FrameRenderer.cpp"
+#include "../framework/Bench.hpp"
+
+using namespace std;
+
+#define FRAME_BENCH_MAP MAPS_DIR + "map2.json"
+#define FRAME_BENCH_WIDTH 1024
+#define FRAME_BENCH_HEIGHT 512
+#define FRAME_BENCH_POSES 16
+
+///
+/// map2 set up for the frame stages with the config the engine runs with, the
+/// same as a headless run, and the poses of the headless spin around the map
+/// start, each with the depth its walls leave behind for the sprites to be
+/// drawn against
+///
+struct FrameBenchScene {
+    World world;
+    Rendering::TextureAtlas atlas;
+    Rendering::PBO target;
+    WorkerPool pool;
+    Rendering::FrameRenderer frame;
+    vector<ViewModel::Camera> views;
+    vector<Rendering::ZBuffer> depths;
+    vector<Rendering::HiZBuffer> hiZs;
+
+    FrameBenchScene() {
+        // The config logs as it loads, keep the benchmarks quiet after it
+        bool hide_infos = loggingCfg.hide_infos;
+        ResourceManager::ConfigInit().initAll(playerCfg, minimapCfg, loggingCfg, renderCfg);
+        loggingCfg.hide_infos = hide_infos;
+
+        map<string, Texture> textures;
+        ResourceManager::TextureLoader().loadTextures(textures);
+        this->atlas.build(textures, renderCfg.texture_width, renderCfg.texture_height, renderCfg.mipmaps);
+        this->world.readMapFromJSON(FRAME_BENCH_MAP, this->atlas);
+        this->pool.start(renderCfg.render_threads > 0
+            ? renderCfg.render_threads
+            : max(1, (int) thread::hardware_concurrency()));
+
+        this->frame.world = &this->world;
+        this->frame.atlas = &this->atlas;
+        this->frame.target = &this->target;
+        this->frame.pool = &this->pool;
+        this->frame.occupancy.rebuild(this->world.map_width, this->world.map_height, [this](int x, int y) {
+            return this->world.getAt(x, y).type != Constructs::WallType::NONE;
+        });
+        this->frame.skip_empty_space = renderCfg.occupancy_grid_min_size > 0
+            && max(this->world.map_width, this->world.map_height) >= renderCfg.occupancy_grid_min_size;
+        if (renderCfg.wall_query == ConfigSection::WallQuery::QSP) {
+            this->frame.qsp_tree = QSPTree(this->world);
+            this->frame.qsp_tree.buildTree(&this->pool);
+        }
+        this->frame.fog = Rendering::FogTable(renderCfg.fog_start, renderCfg.render_distance, 0xFF000000 | (uint32_t) renderCfg.fog_colour);
+        if (renderCfg.indexed_colour) {
+            this->frame.palette.build(this->atlas.allTexels().data(), this->atlas.allTexels().size(), this->frame.fog.colour);
+            this->atlas.quantize(this->frame.palette);
+            this->frame.palette.buildColormaps(this->frame.fog);
+        }
+        this->target = Rendering::PBO(FRAME_BENCH_WIDTH, FRAME_BENCH_HEIGHT, renderCfg.column_major_target);
+        if (renderCfg.indexed_colour) {
+            this->target.setPalette(this->frame.palette.colours());
+        }
+        this->frame.resize(FRAME_BENCH_WIDTH, FRAME_BENCH_HEIGHT);
+
+        Player player(this->world.start.x, this->world.start.y, -playerCfg.fov, 0.0, 0);
+        ViewModel::CameraPath path = ViewModel::CameraPath::spin(
+            player.location.x, player.location.y,
+            atan2(player.camera.frustrum.getFovY(), player.camera.frustrum.getFovX())
+        );
+        for (int pose = 0; pose < FRAME_BENCH_POSES; pose++) {
+            ViewModel::CameraPose sample = path.sample(pose, FRAME_BENCH_POSES);
+            player.setView(sample.x, sample.y, sample.angle);
+            this->views.push_back(player.view());
+            renderWalls(pose);
+            this->depths.push_back(this->frame.z_buffer);
+            this->hiZs.push_back(this->frame.hi_z);
+        }
+    }
+
+    void renderWalls(int pose) {
+        this->target.beginFrame();
+        if (!renderCfg.render_floor_ceiling) {
+            this->target.blankOut();
+        }
+        this->frame.renderWallsFloorCeiling(this->views[pose]);
+    }
+
+    void renderSprites(int pose) {
+        // Copying a row of depths back is a small share of drawing the sprites over it
+        this->frame.z_buffer = this->depths[pose];
+        this->frame.hi_z = this->hiZs[pose];
+        this->frame.renderSprites(this->views[pose]);
+    }
+};
+
+BENCH_CASE("9.1: Frame stages on map2 at 1024x512, walls/floor/ceiling and sprites", "[frame]") {
+    FrameBenchScene scene;
+    bench.run("renderWallsFloorCeiling, 16 views", [&]() {
+        for (int pose = 0; pose < FRAME_BENCH_POSES; pose++) {
+            scene.renderWalls(pose);
+        }
+        Bench::doNotOptimize(scene.target.data()[0]);
+    });
+    bench.run("renderSprites, 16 views", [&]() {
+        for (int pose = 0; pose < FRAME_BENCH_POSES; pose++) {
+            scene.renderSprites(pose);
+        }
+        Bench::doNotOptimize(scene.target.data()[0]);
+    });
+}
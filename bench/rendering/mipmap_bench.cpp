@@ -0,0 +1,187 @@
+#pragma once
+
+#include <math.h>
+#include <stdio.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../../src/rendering/texturing/ColumnSampler.hpp"
+#include "../../src/rendering/texturing/TextureAtlas.cpp"
+#include "../framework/Bench.hpp"
+#include "../framework/Cache.hpp"
+
+using namespace std;
+
+#define MIPMAP_BENCH_WIDTH 1280
+#define MIPMAP_BENCH_HEIGHT 800
+#define MIPMAP_BENCH_CORRIDOR 64.0
+#define MIPMAP_BENCH_PLANE 0.66
+// Cells beyond which geometry counts as far in the miss breakdown
+#define MIPMAP_BENCH_FAR 4.0
+
+///
+/// Texel fetches of one frame looking down a corridor one cell wide: wall
+/// columns either side shrinking into the distance, the end wall, and the floor
+/// and ceiling rows between them. Built with the wall and floor passes' maths
+///
+struct CorridorView {
+    vector<Rendering::ColumnSpan> spans;
+    vector<int> span_heights;
+    vector<int> span_tops;
+    vector<uint32_t> row_x, row_y, row_step_x, row_step_y;
+    vector<const Rendering::AtlasEntry*> row_tex;
+    vector<const uint32_t*> row_texels;
+
+    CorridorView(const Rendering::TextureAtlas& atlas, Rendering::TexHandle handle) {
+        const int w = MIPMAP_BENCH_WIDTH;
+        const int h = MIPMAP_BENCH_HEIGHT;
+        const Rendering::AtlasEntry& full = atlas.entry(handle);
+        // Camera in the middle of the corridor's first cell, looking along it
+        const double origin = 0.5;
+        for (int x = 0; x < w; x++) {
+            double dir_y = MIPMAP_BENCH_PLANE * (2 * x / double(w) - 1);
+            double perp = dir_y == 0 ? numeric_limits<double>::infinity() : 0.5 / fabs(dir_y);
+            double wall_x;
+            if (origin + perp < MIPMAP_BENCH_CORRIDOR) {
+                wall_x = origin + perp;
+            } else {
+                perp = MIPMAP_BENCH_CORRIDOR - origin;
+                wall_x = origin + perp * dir_y;
+            }
+            wall_x -= floor(wall_x);
+            int line_height = (int) (h / perp);
+            int top = max(-line_height / 2 + h / 2, 0);
+            int bottom = min(line_height / 2 + h / 2, h - 1);
+            const Rendering::AtlasEntry& tex = atlas.level(handle,
+                Rendering::TextureAtlas::mipLevel(full, double(full.height) / line_height));
+            double step = 1.0 * tex.height / line_height;
+            Rendering::ColumnSpan span;
+            span.texels = atlas.texels(tex) + (int) (wall_x * tex.width);
+            span.width_shift = tex.width_shift;
+            span.row_shift = 32 - tex.height_shift;
+            span.v_step = Rendering::toColumnV(step, tex.height_shift);
+            span.v = Rendering::toColumnV((top - h / 2 + line_height / 2) * step, tex.height_shift);
+            span.shade_shift = 0;
+            span.shade_mask = 0xFFFFFFFF;
+            this->spans.push_back(span);
+            this->span_tops.push_back(top);
+            this->span_heights.push_back(max(bottom - top, 0));
+        }
+        // Floor rows below the horizon, the ceiling mirrors them
+        const double row_span = 2 * MIPMAP_BENCH_PLANE;
+        for (int y = h / 2 + 1; y < h; y++) {
+            double dist = 0.5 * w / (y - h / 2);
+            double step_scale = dist / w;
+            double footprint = step_scale * sqrt(2 * dist * row_span);
+            const Rendering::AtlasEntry& tex = atlas.level(handle,
+                Rendering::TextureAtlas::mipLevel(full, footprint * max(full.width, full.height)));
+            this->row_x.push_back((uint32_t) (int64_t) ((origin + dist) * 16777216.0));
+            this->row_y.push_back((uint32_t) (int64_t) ((origin - dist * MIPMAP_BENCH_PLANE) * 16777216.0));
+            this->row_step_x.push_back(0);
+            this->row_step_y.push_back((uint32_t) (int64_t) (step_scale * row_span * 16777216.0));
+            this->row_tex.push_back(&tex);
+            this->row_texels.push_back(atlas.texels(tex));
+        }
+    }
+
+    inline static uint32_t flatOffset(const Rendering::AtlasEntry& tex, uint32_t world_x, uint32_t world_y) {
+        return (((world_y >> (24 - tex.height_shift)) & tex.height_mask) << tex.width_shift)
+            + ((world_x >> (24 - tex.width_shift)) & tex.width_mask);
+    }
+
+    ///
+    /// Fetch every texel of the frame, columns with the wall sampler and
+    /// rows skipping the pixels the walls cover
+    ///
+    void render(vector<uint32_t>& column, vector<uint32_t>& row) const {
+        for (size_t x = 0; x < this->spans.size(); x++) {
+            Rendering::sampleColumn(this->spans[x], column.data(), this->span_heights[x]);
+        }
+        for (size_t i = 0; i < this->row_tex.size(); i++) {
+            int y = MIPMAP_BENCH_HEIGHT / 2 + 1 + (int) i;
+            uint32_t world_x = this->row_x[i];
+            uint32_t world_y = this->row_y[i];
+            for (int x = 0; x < MIPMAP_BENCH_WIDTH; x++, world_x += this->row_step_x[i], world_y += this->row_step_y[i]) {
+                if (y < this->span_tops[x] + this->span_heights[x]) {
+                    continue;
+                }
+                row[x] = this->row_texels[i][flatOffset(*this->row_tex[i], world_x, world_y)] * 2;
+            }
+        }
+        Bench::doNotOptimize(row[0]);
+    }
+
+    ///
+    /// Feed the same fetches, in the same order, through a model of L1, counting
+    /// the misses of fetches for geometry nearer and further than a distance
+    ///
+    void trace(Bench::CacheModel& cache, double far, size_t& near_misses, size_t& far_misses) const {
+        size_t before;
+        near_misses = 0;
+        far_misses = 0;
+        for (size_t x = 0; x < this->spans.size(); x++) {
+            const Rendering::ColumnSpan& span = this->spans[x];
+            uint32_t v = span.v;
+            before = cache.misses;
+            for (int i = 0; i < this->span_heights[x]; i++, v += span.v_step) {
+                cache.access(span.texels + ((uint32_t) ((uint64_t) v >> span.row_shift) << span.width_shift));
+            }
+            (MIPMAP_BENCH_HEIGHT / double(this->span_heights[x] + 1) > far ? far_misses : near_misses) += cache.misses - before;
+        }
+        for (size_t i = 0; i < this->row_tex.size(); i++) {
+            int y = MIPMAP_BENCH_HEIGHT / 2 + 1 + (int) i;
+            uint32_t world_x = this->row_x[i];
+            uint32_t world_y = this->row_y[i];
+            before = cache.misses;
+            for (int x = 0; x < MIPMAP_BENCH_WIDTH; x++, world_x += this->row_step_x[i], world_y += this->row_step_y[i]) {
+                if (y < this->span_tops[x] + this->span_heights[x]) {
+                    continue;
+                }
+                cache.access(this->row_texels[i] + flatOffset(*this->row_tex[i], world_x, world_y));
+            }
+            (0.5 * MIPMAP_BENCH_WIDTH / (y - MIPMAP_BENCH_HEIGHT / 2) > far ? far_misses : near_misses) += cache.misses - before;
+        }
+    }
+};
+
+BENCH_CASE("6.1: Long corridor texel fetches, full size textures vs mip levels", "[textures]") {
+    const unsigned long sizes[] = {64, 256};
+    Bench::CacheCounter counter;
+    if (!counter.available()) {
+        printf("  No hardware cache counters, L1 misses are from a %d KiB %d way LRU model\n",
+            BENCH_L1_BYTES / 1024, BENCH_L1_WAYS);
+    }
+    vector<uint32_t> column(MIPMAP_BENCH_HEIGHT), row(MIPMAP_BENCH_WIDTH);
+    for (unsigned long size : sizes) {
+        map<string, Texture> textures;
+        Texture& tex = textures["corridor"];
+        tex.width = size;
+        tex.height = size;
+        tex.texture.resize(size * size);
+        for (size_t i = 0; i < tex.texture.size(); i++) {
+            tex.texture[i] = 0xFF000000 | (uint32_t) (i * 2654435761u);
+        }
+        for (bool mipmaps : {false, true}) {
+            Rendering::TextureAtlas atlas;
+            atlas.build(textures, 8, 8, mipmaps);
+            CorridorView view(atlas, atlas.handle("corridor"));
+            string name = to_string(size) + "x" + to_string(size) + (mipmaps ? ", mip levels" : ", full size");
+            bench.run(name, [&]() {
+                view.render(column, row);
+            });
+            Bench::CacheModel cache;
+            size_t near_misses, far_misses;
+            view.trace(cache, MIPMAP_BENCH_FAR, near_misses, far_misses);
+            printf("  %s: %zu of %zu modelled texel loads miss L1, %zu nearer than %d cells, %zu further",
+                name.c_str(), cache.misses, cache.accesses, near_misses, (int) MIPMAP_BENCH_FAR, far_misses);
+            if (counter.available()) {
+                counter.start();
+                view.render(column, row);
+                printf(", %llu hardware L1D read misses", (unsigned long long) counter.stop());
+            }
+            printf("\n");
+        }
+    }
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <math.h>
+
+#include <vector>
+
+#include "../../src/rendering/buffering/PBO.cpp"
+#include "../../src/rendering/colour/FogTable.cpp"
+#include "../../src/rendering/colour/Palette.cpp"
+#include "../../src/rendering/texturing/ColumnSampler.hpp"
+#include "../framework/Bench.hpp"
+
+using namespace std;
+
+#define PALETTE_BENCH_WIDTH 1920
+#define PALETTE_BENCH_HEIGHT 1080
+#define PALETTE_BENCH_TEX_SHIFT 6
+
+///
+/// A 64x64 texture of smooth gradients with some noise, so median cut has
+/// more colours than it can keep
+///
+static vector<uint32_t> paletteBenchTexture() {
+    vector<uint32_t> texels(1 << (2 * PALETTE_BENCH_TEX_SHIFT));
+    for (size_t i = 0; i < texels.size(); i++) {
+        uint32_t x = i & ((1 << PALETTE_BENCH_TEX_SHIFT) - 1), y = (uint32_t) i >> PALETTE_BENCH_TEX_SHIFT;
+        uint32_t noise = (uint32_t) (i * 2654435761u) >> 28;
+        texels[i] = 0xFF000000 | (x * 4 + noise) << 16 | (y * 3 + noise) << 8 | ((x + y) * 2);
+    }
+    return texels;
+}
+
+///
+/// Floor rows across the whole frame: constant distance per row, one fixed point
+/// step per pixel, shaded dark and fogged by row the way the floor kernel does
+///
+template <typename Pixel, typename Shade>
+static void paletteBenchRows(Pixel* out, const Pixel* texels, Shade shade) {
+    const uint32_t mask = (1 << PALETTE_BENCH_TEX_SHIFT) - 1;
+    for (int y = 1; y < PALETTE_BENCH_HEIGHT; y++) {
+        double dist = PALETTE_BENCH_HEIGHT / (2.0 * y);
+        uint32_t world_x = (uint32_t) (int64_t) (dist * 16777216.0);
+        uint32_t world_y = 0;
+        uint32_t step = (uint32_t) (int64_t) (dist * 1.32 / PALETTE_BENCH_WIDTH * 16777216.0);
+        Pixel* row = out + y * PALETTE_BENCH_WIDTH;
+        for (int x = 0; x < PALETTE_BENCH_WIDTH; x++, world_y += step) {
+            row[x] = shade(y, texels[(((world_y >> (24 - PALETTE_BENCH_TEX_SHIFT)) & mask) << PALETTE_BENCH_TEX_SHIFT)
+                + ((world_x >> (24 - PALETTE_BENCH_TEX_SHIFT)) & mask)]);
+        }
+    }
+}
+
+BENCH_CASE("7.1: Frame of walls and floor rows, packed texels vs palette indices", "[palette]") {
+    vector<uint32_t> texels = paletteBenchTexture();
+    Rendering::FogTable fog(4, 16, 0xFF000000);
+    Rendering::Palette palette;
+    palette.build(texels.data(), texels.size(), fog.colour);
+    palette.buildColormaps(fog);
+    vector<uint8_t> indices(texels.size());
+    palette.quantize(texels.data(), texels.size(), indices.data());
+
+    Rendering::PBO true_colour(PALETTE_BENCH_WIDTH, PALETTE_BENCH_HEIGHT, true);
+    Rendering::PBO indexed(PALETTE_BENCH_WIDTH, PALETTE_BENCH_HEIGHT, true);
+    indexed.setPalette(palette.colours());
+
+    // Wall columns of every height, sampled straight into the column major targets
+    auto column_span = [&](int x, const uint32_t* texel_column, Rendering::ColumnSpan& span) {
+        int line_height = PALETTE_BENCH_HEIGHT * 2 / (1 + x % 16);
+        span.texels = texel_column;
+        span.width_shift = PALETTE_BENCH_TEX_SHIFT;
+        span.row_shift = 32 - PALETTE_BENCH_TEX_SHIFT;
+        span.v_step = Rendering::toColumnV(double(1 << PALETTE_BENCH_TEX_SHIFT) / line_height, PALETTE_BENCH_TEX_SHIFT);
+        span.v = 0;
+        span.shade_shift = x & 1;
+        span.shade_mask = x & 1 ? 0x7F7F7F : 0xFFFFFFFF;
+    };
+    bench.run("Wall columns, packed texels + fog", [&]() {
+        Rendering::ColumnSpan span;
+        for (int x = 0; x < PALETTE_BENCH_WIDTH; x++) {
+            column_span(x, texels.data() + (x & 63), span);
+            uint32_t* out = true_colour.column(x);
+            Rendering::sampleColumn(span, out, PALETTE_BENCH_HEIGHT);
+            fog.blendSpan(out, PALETTE_BENCH_HEIGHT, fog.weight(x % 16));
+        }
+        Bench::doNotOptimize(true_colour.column(0)[0]);
+    });
+    bench.run("Wall columns, palette indices through colormaps", [&]() {
+        Rendering::ColumnSpan span;
+        for (int x = 0; x < PALETTE_BENCH_WIDTH; x++) {
+            column_span(x, texels.data(), span);
+            Rendering::sampleIndexedColumn(span, indices.data() + (x & 63),
+                palette.colormap(x & 1, fog.weight(x % 16)), indexed.indexedColumn(x), PALETTE_BENCH_HEIGHT);
+        }
+        Bench::doNotOptimize(indexed.indexedColumn(0)[0]);
+    });
+
+    vector<uint32_t> row_pixels(PALETTE_BENCH_WIDTH * PALETTE_BENCH_HEIGHT);
+    vector<uint8_t> row_indices(PALETTE_BENCH_WIDTH * PALETTE_BENCH_HEIGHT);
+    // Fog weights and colormaps are looked up once per row, as the floor kernel does
+    vector<uint32_t> row_fog(PALETTE_BENCH_HEIGHT);
+    vector<const uint8_t*> row_colormap(PALETTE_BENCH_HEIGHT);
+    for (int y = 1; y < PALETTE_BENCH_HEIGHT; y++) {
+        row_fog[y] = fog.weight(PALETTE_BENCH_HEIGHT / (2.0 * y));
+        row_colormap[y] = palette.colormap(PALETTE_SHADE_DARK, row_fog[y]);
+    }
+    bench.run("Floor rows, packed texels + fog", [&]() {
+        paletteBenchRows(row_pixels.data(), texels.data(), [&](int y, uint32_t texel) {
+            uint32_t weight = row_fog[y];
+            uint32_t colour = (texel >> 1) & 0x7F7F7F;
+            return weight ? fog.blend(colour, weight) : colour;
+        });
+        Bench::doNotOptimize(row_pixels[PALETTE_BENCH_WIDTH]);
+    });
+    bench.run("Floor rows, palette indices through colormaps", [&]() {
+        paletteBenchRows(row_indices.data(), indices.data(), [&](int y, uint8_t index) {
+            return row_colormap[y][index];
+        });
+        Bench::doNotOptimize(row_indices[PALETTE_BENCH_WIDTH]);
+    });
+
+    bench.run("Palette expand of the frame", [&]() {
+        Rendering::expandPalette(row_indices.data(), row_pixels.data(), row_pixels.size(), palette.colours());
+        Bench::doNotOptimize(row_pixels[0]);
+    });
+    bench.run("Palette expand of the frame, scalar", [&]() {
+        Rendering::expandPaletteScalar(row_indices.data(), row_pixels.data(), row_pixels.size(), palette.colours());
+        Bench::doNotOptimize(row_pixels[0]);
+    });
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <math.h>
+#include <stdio.h>
+
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "../../src/environment/world/World.cpp"
+#include "../../src/rendering/partitioning/QSPTree.cpp"
+#include "../../src/rendering/raycaster/DDA.hpp"
+#include "../framework/Bench.hpp"
+
+using namespace std;
+
+#define QSP_BENCH_VIEWS 64
+#define QSP_BENCH_COLUMNS 640
+
+///
+/// Bordered map with a fraction of the inner cells solid, and a camera's worth
+/// of column rays from each of a set of open cells
+///
+struct QSPBenchScene {
+    World world;
+    Rendering::RayBuffer rays;
+
+    QSPBenchScene(int size, double density) {
+        mt19937 gen(5);
+        uniform_real_distribution<double> unit(0, 1);
+        vector<Constructs::AABB> walls;
+        for (int y = 0; y < size; y++) {
+            for (int x = 0; x < size; x++) {
+                bool border = x == 0 || y == 0 || x == size - 1 || y == size - 1;
+                walls.push_back(Constructs::AABB(x, y, TEX_HANDLE_MISSING,
+                    border || unit(gen) < density ? Constructs::WallType::WALL : Constructs::WallType::NONE));
+            }
+        }
+        this->world = World(walls, size, size);
+        for (int view = 0; view < QSP_BENCH_VIEWS; view++) {
+            double x, y;
+            do {
+                x = 1 + unit(gen) * (size - 2);
+                y = 1 + unit(gen) * (size - 2);
+            } while (this->world.getAt((int) x, (int) y).type != Constructs::WallType::NONE);
+            double angle = unit(gen) * 2 * M_PI;
+            for (int column = 0; column < QSP_BENCH_COLUMNS; column++) {
+                double camera_x = 2 * column / double(QSP_BENCH_COLUMNS) - 1;
+                this->rays.push_back(Rendering::CameraRay{
+                    x, y,
+                    cos(angle) - sin(angle) * 0.66 * camera_x,
+                    sin(angle) + cos(angle) * 0.66 * camera_x
+                });
+            }
+        }
+    }
+};
+
+static void benchWallQuery(Bench::Runner& bench, int size, double density) {
+    QSPBenchScene scene(size, density);
+    QSPTree tree(scene.world);
+    tree.buildTree();
+    vector<Rendering::RayHit> hits(scene.rays.size());
+    auto is_wall = [&](int x, int y) {
+        return scene.world.getAt(x, y).type != Constructs::WallType::NONE;
+    };
+
+    double dda_steps = 0, qsp_steps = 0;
+    for (size_t i = 0; i < scene.rays.size(); i++) {
+        const Rendering::CameraRay& ray = scene.rays[i];
+        dda_steps += Rendering::castRayDouble(ray.origin_x, ray.origin_y, ray.dir_x, ray.dir_y, is_wall).steps;
+    }
+    for (int view = 0; view < QSP_BENCH_VIEWS; view++) {
+        tree.queryWalls(scene.rays, view * QSP_BENCH_COLUMNS, (view + 1) * QSP_BENCH_COLUMNS, hits);
+    }
+    for (const Rendering::RayHit& hit : hits) {
+        qsp_steps += hit.steps;
+    }
+    string name = to_string(size) + "^2, " + to_string((int) (density * 100)) + "% walls";
+    printf("  %s: per ray, DDA %.1f cells, QSP %.1f nodes\n",
+        name.c_str(), dda_steps / scene.rays.size(), qsp_steps / scene.rays.size());
+
+    bench.run(name + ": DDA", [&]() {
+        double total = 0;
+        for (const Rendering::CameraRay& ray : scene.rays) {
+            total += Rendering::castRayDouble(ray.origin_x, ray.origin_y, ray.dir_x, ray.dir_y, is_wall).perp_wall_dist;
+        }
+        Bench::doNotOptimize(total);
+    });
+    bench.run(name + ": QSP", [&]() {
+        for (int view = 0; view < QSP_BENCH_VIEWS; view++) {
+            tree.queryWalls(scene.rays, view * QSP_BENCH_COLUMNS, (view + 1) * QSP_BENCH_COLUMNS, hits);
+        }
+        Bench::doNotOptimize(hits[0].perp_wall_dist);
+    });
+}
+
+BENCH_CASE("4.1: Wall queries, DDA vs QSP tree, by map density", "[qsp]") {
+    const double densities[] = {0.01, 0.05, 0.15, 0.30};
+    for (double density : densities) {
+        benchWallQuery(bench, 64, density);
+    }
+    benchWallQuery(bench, 256, 0.01);
+}
+
+BENCH_CASE("4.2: QSP tree build and teardown, and loading a saved tree", "[qsp]") {
+    const int sizes[] = {64, 256, 1024};
+    WorkerPool pool;
+    pool.start(max(1, (int) thread::hardware_concurrency()));
+    for (int size : sizes) {
+        QSPBenchScene scene(size, 0.15);
+        bench.run(to_string(size) + "^2, 15% walls: build and teardown", [&]() {
+            QSPTree tree(scene.world);
+            tree.buildTree();
+            Bench::doNotOptimize(tree);
+        });
+        bench.run(to_string(size) + "^2, 15% walls: build on " + to_string(pool.size()) + " workers", [&]() {
+            QSPTree tree(scene.world);
+            tree.buildTree(&pool);
+            Bench::doNotOptimize(tree);
+        });
+        QSPTree built(scene.world);
+        built.buildTree();
+        const string filename = "qsp_bench_tree" QSP_FILE_EXTENSION;
+        built.save(filename);
+        bench.run(to_string(size) + "^2, 15% walls: map saved tree", [&]() {
+            QSPTree tree;
+            tree.load(filename, scene.world);
+            Bench::doNotOptimize(tree);
+        });
+        remove(filename.c_str());
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+
+#include "../../src/rendering/buffering/PBO.cpp"
+#include "../framework/Bench.hpp"
+
+using namespace std;
+
+///
+/// Fill every column of the target top to bottom the way the wall and floor
+/// kernels do, from a texel column that varies per x so stores can't be merged
+///
+static void writeAllColumns(Rendering::PBO& pbo, const vector<uint32_t>& texels) {
+    for (int x = 0; x < pbo.width; x++) {
+        pbo.writeColumn(x, 0, pbo.height, texels.data() + (x & 63));
+    }
+}
+
+static void benchRenderTarget(Bench::Runner& bench, int width, int height) {
+    string res = to_string(width) + "x" + to_string(height);
+    vector<uint32_t> texels(height + 64);
+    for (size_t i = 0; i < texels.size(); i++) {
+        texels[i] = 0xFF000000 | (uint32_t) (i * 2654435761u);
+    }
+
+    Rendering::PBO row_major(width, height, false);
+    bench.run(res + " row major: column writes", [&]() {
+        writeAllColumns(row_major, texels);
+        Bench::doNotOptimize(row_major.data()[0]);
+    });
+
+    Rendering::PBO column_major(width, height, true);
+    bench.run(res + " column major: column writes", [&]() {
+        writeAllColumns(column_major, texels);
+        Bench::doNotOptimize(column_major.column(0)[0]);
+    });
+    bench.run(res + " column major: transpose", [&]() {
+        column_major.resolve();
+        Bench::doNotOptimize(column_major.data()[0]);
+    });
+    bench.run(res + " column major: column writes + transpose", [&]() {
+        writeAllColumns(column_major, texels);
+        column_major.resolve();
+        Bench::doNotOptimize(column_major.data()[0]);
+    });
+}
+
+BENCH_CASE("1.1: Row vs column major render target at 1080p", "[render-target]") {
+    benchRenderTarget(bench, 1920, 1080);
+}
+
+BENCH_CASE("1.2: Row vs column major render target at 4K", "[render-target]") {
+    benchRenderTarget(bench, 3840, 2160);
+}
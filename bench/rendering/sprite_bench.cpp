@@ -0,0 +1,178 @@
+#pragma once
+
+#include <math.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "../../src/environment/world/World.cpp"
+#include "../../src/rendering/raycaster/SpriteQueue.cpp"
+#include "../../src/rendering/raycaster/HiZBuffer.cpp"
+#include "../framework/Bench.hpp"
+
+using namespace std;
+
+#define SPRITE_BENCH_MAP_SIZE 256
+#define SPRITE_BENCH_FRAMES 64
+#define SPRITE_BENCH_OCCLUSION_SPRITES 4096
+
+///
+/// Sprites scattered over a map, and a camera walking and turning through it
+/// a frame at a time
+///
+struct SpriteBenchScene {
+    vector<Constructs::Sprite> sprites;
+    vector<double> x, y;
+    vector<ViewModel::Camera> cameras;
+
+    SpriteBenchScene(int count) {
+        mt19937 gen(17);
+        uniform_real_distribution<double> unit(0, 1);
+        for (int i = 0; i < count; i++) {
+            this->sprites.push_back(Constructs::Sprite(unit(gen) * SPRITE_BENCH_MAP_SIZE, unit(gen) * SPRITE_BENCH_MAP_SIZE, gen() % 8));
+        }
+        double x = SPRITE_BENCH_MAP_SIZE / 2.0;
+        double y = SPRITE_BENCH_MAP_SIZE / 2.0;
+        double angle = 0;
+        for (int frame = 0; frame < SPRITE_BENCH_FRAMES; frame++) {
+            angle += 0.03;
+            x += cos(angle) * 0.08;
+            y += sin(angle) * 0.08;
+            ViewModel::Camera camera;
+            camera.frustrum.setFovX(cos(angle));
+            camera.frustrum.setFovY(sin(angle));
+            camera.clip_plane_x = -0.66 * sin(angle);
+            camera.clip_plane_y = 0.66 * cos(angle);
+            this->x.push_back(x);
+            this->y.push_back(y);
+            this->cameras.push_back(camera);
+        }
+    }
+};
+
+///
+/// Per frame work of the renderer before this queue: square every sprite's distance,
+/// sort them all from scratch and project each one, including those out of view
+///
+struct SpriteBenchFullSort {
+    struct Entry {
+        double distance;
+        uint32_t sprite;
+
+        inline bool operator<(const Entry& other) const {
+            return this->distance > other.distance;
+        }
+    };
+    vector<Entry> entries;
+
+    double frame(const SpriteBenchScene& scene, int frame) {
+        const ViewModel::Camera& camera = scene.cameras[frame];
+        this->entries.resize(scene.sprites.size());
+        for (size_t i = 0; i < scene.sprites.size(); i++) {
+            this->entries[i].distance = pow(scene.sprites[i].location.x - scene.x[frame], 2) + pow(scene.sprites[i].location.y - scene.y[frame], 2);
+            this->entries[i].sprite = (uint32_t) i;
+        }
+        sort(this->entries.begin(), this->entries.end());
+        double dir_x = camera.frustrum.getFovX();
+        double dir_y = camera.frustrum.getFovY();
+        double inverse_det = 1.0 / (camera.clip_plane_x * dir_y - dir_x * camera.clip_plane_y);
+        double total = 0;
+        for (const Entry& entry : this->entries) {
+            double dx = scene.sprites[entry.sprite].location.x - scene.x[frame];
+            double dy = scene.sprites[entry.sprite].location.y - scene.y[frame];
+            double transform_x = inverse_det * (dir_y * dx - dir_x * dy);
+            double transform_y = inverse_det * (-camera.clip_plane_y * dx + camera.clip_plane_x * dy);
+            total += transform_x / transform_y;
+        }
+        return total;
+    }
+};
+
+BENCH_CASE("5.1: Sprite ordering, full sort vs coherent queue with culling", "[sprites]") {
+    const int counts[] = {100, 1000, 4000, 16000};
+    for (int count : counts) {
+        SpriteBenchScene scene(count);
+        SpriteBenchFullSort full_sort;
+        Rendering::SpriteQueue queue;
+        string name = to_string(count) + " sprites, " + to_string(SPRITE_BENCH_FRAMES) + " frames";
+        bench.run(name + ": full sort", [&]() {
+            double total = 0;
+            for (int frame = 0; frame < SPRITE_BENCH_FRAMES; frame++) {
+                total += full_sort.frame(scene, frame);
+            }
+            Bench::doNotOptimize(total);
+        });
+        bench.run(name + ": sprite queue", [&]() {
+            for (int frame = 0; frame < SPRITE_BENCH_FRAMES; frame++) {
+                queue.update(scene.sprites, scene.x[frame], scene.y[frame], scene.cameras[frame], 1280, 800);
+            }
+            Bench::doNotOptimize(queue.draws().size());
+        });
+        printf("  %s: %zu of %d sprites drawn in %zu batches on the last frame\n",
+            name.c_str(), queue.draws().size(), count, queue.batches().size());
+    }
+}
+
+BENCH_CASE("5.2: Sprite occlusion, per column depth test vs Hi-Z", "[sprites]") {
+    const int widths[] = {640, 1920};
+    mt19937 gen(23);
+    uniform_real_distribution<double> unit(0, 1);
+    for (int width : widths) {
+        // Walls in runs of a few dozen columns, near enough to hide most sprites behind them
+        Rendering::ZBuffer depth(width);
+        double distance = 2;
+        for (int x = 0; x < width; x++) {
+            if (unit(gen) < 0.03) {
+                distance = 1 + unit(gen) * 8;
+            }
+            depth[x] = distance;
+        }
+        vector<int> starts, ends;
+        vector<double> depths;
+        for (int i = 0; i < SPRITE_BENCH_OCCLUSION_SPRITES; i++) {
+            double sprite_depth = 0.5 + unit(gen) * 12;
+            int sprite_width = (int) (width * 0.6 / sprite_depth);
+            int start = (int) (unit(gen) * width) - sprite_width / 2;
+            starts.push_back(max(start, 1));
+            ends.push_back(min(start + sprite_width, width - 1));
+            depths.push_back(sprite_depth);
+        }
+        Rendering::HiZBuffer hiZ;
+        size_t scanned_visible = 0;
+        size_t hiz_visible = 0;
+        string name = to_string(width) + " columns, " + to_string(SPRITE_BENCH_OCCLUSION_SPRITES) + " sprites";
+        bench.run(name + ": depth test every column", [&]() {
+            scanned_visible = 0;
+            for (size_t i = 0; i < depths.size(); i++) {
+                for (int x = starts[i]; x < ends[i]; x++) {
+                    scanned_visible += depths[i] < depth[x];
+                }
+            }
+            Bench::doNotOptimize(scanned_visible);
+        });
+        bench.run(name + ": Hi-Z trim, then test", [&]() {
+            hiz_visible = 0;
+            hiZ.build(depth);
+            int start, end;
+            for (size_t i = 0; i < depths.size(); i++) {
+                start = starts[i];
+                end = ends[i];
+                if (!hiZ.visibleSpan(start, end, depths[i])) {
+                    continue;
+                }
+                for (int x = start; x < end; x++) {
+                    hiz_visible += depths[i] < depth[x];
+                }
+            }
+            Bench::doNotOptimize(hiz_visible);
+        });
+        size_t rejected = 0;
+        for (size_t i = 0; i < depths.size(); i++) {
+            rejected += hiZ.occluded(starts[i], ends[i], depths[i]);
+        }
+        printf("  %s: %zu sprites rejected whole, %zu of %zu visible columns found by both\n",
+            name.c_str(), rejected, hiz_visible, scanned_visible);
+    }
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <math.h>
+#include <stdio.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../../src/rendering/texturing/ColumnSampler.hpp"
+#include "../../src/rendering/texturing/TextureAtlas.cpp"
+#include "../framework/Bench.hpp"
+#include "../framework/Cache.hpp"
+
+using namespace std;
+
+#define LAYOUT_BENCH_WIDTH 1280
+#define LAYOUT_BENCH_HEIGHT 800
+#define LAYOUT_BENCH_PLANE 0.66
+
+///
+/// Floor rows of one frame with the camera turned to an angle, addressed in
+/// either row major or Morton order. Rows pick their mip level as the floor
+/// kernel does, so only the layout differs between the two
+///
+struct FloorView {
+    vector<uint32_t> row_x, row_y, row_step_x, row_step_y;
+    vector<const Rendering::AtlasEntry*> row_tex;
+
+    FloorView(const Rendering::TextureAtlas& atlas, Rendering::TexHandle handle, double angle) {
+        const Rendering::AtlasEntry& full = atlas.entry(handle);
+        const double dir_x = cos(angle), dir_y = sin(angle);
+        const double ray_x0 = dir_x + LAYOUT_BENCH_PLANE * dir_y, ray_y0 = dir_y - LAYOUT_BENCH_PLANE * dir_x;
+        const double ray_x1 = dir_x - LAYOUT_BENCH_PLANE * dir_y, ray_y1 = dir_y + LAYOUT_BENCH_PLANE * dir_x;
+        const double row_span = hypot(ray_x1 - ray_x0, ray_y1 - ray_y0);
+        for (int y = LAYOUT_BENCH_HEIGHT / 2 + 1; y < LAYOUT_BENCH_HEIGHT; y++) {
+            double dist = 0.5 * LAYOUT_BENCH_HEIGHT / (y - LAYOUT_BENCH_HEIGHT / 2);
+            double step_scale = dist / LAYOUT_BENCH_WIDTH;
+            double footprint = step_scale * sqrt(2 * dist * row_span);
+            this->row_tex.push_back(&atlas.level(handle,
+                Rendering::TextureAtlas::mipLevel(full, footprint * max(full.width, full.height))));
+            this->row_x.push_back((uint32_t) (int64_t) ((0.5 + dist * ray_x0) * 16777216.0));
+            this->row_y.push_back((uint32_t) (int64_t) ((0.5 + dist * ray_y0) * 16777216.0));
+            this->row_step_x.push_back((uint32_t) (int64_t) (step_scale * (ray_x1 - ray_x0) * 16777216.0));
+            this->row_step_y.push_back((uint32_t) (int64_t) (step_scale * (ray_y1 - ray_y0) * 16777216.0));
+        }
+    }
+
+    ///
+    /// Visit the texel offset of every pixel of every row
+    ///
+    template <typename Visit>
+    inline void walk(const Rendering::TextureAtlas& atlas, Rendering::TexelLayout layout, Visit visit) const {
+        for (size_t i = 0; i < this->row_tex.size(); i++) {
+            const Rendering::AtlasEntry& tex = *this->row_tex[i];
+            const uint32_t* texels = atlas.texels(tex, layout);
+            const uint32_t* swizzle = atlas.swizzle(tex);
+            uint32_t world_x = this->row_x[i], world_y = this->row_y[i];
+            for (int x = 0; x < LAYOUT_BENCH_WIDTH; x++, world_x += this->row_step_x[i], world_y += this->row_step_y[i]) {
+                uint32_t u = (world_x >> (24 - tex.width_shift)) & tex.width_mask;
+                uint32_t v = (world_y >> (24 - tex.height_shift)) & tex.height_mask;
+                visit(texels + (layout == Rendering::MORTON ? swizzle[u] | swizzle[tex.width + v] : (v << tex.width_shift) + u));
+            }
+        }
+    }
+};
+
+///
+/// Wall columns of one frame, a wall slanting away from the camera so columns
+/// range from taller than the screen to a few pixels
+///
+static vector<Rendering::ColumnSpan> wallColumns(const Rendering::TextureAtlas& atlas, Rendering::TexHandle handle,
+                                                 Rendering::TexelLayout layout, vector<int>& heights) {
+    const Rendering::AtlasEntry& full = atlas.entry(handle);
+    vector<Rendering::ColumnSpan> spans;
+    heights.clear();
+    for (int x = 0; x < LAYOUT_BENCH_WIDTH; x++) {
+        double perp = 0.5 + 16.0 * x / LAYOUT_BENCH_WIDTH;
+        int line_height = (int) (LAYOUT_BENCH_HEIGHT / perp);
+        const Rendering::AtlasEntry& tex = atlas.level(handle,
+            Rendering::TextureAtlas::mipLevel(full, double(full.height) / line_height));
+        uint32_t tex_x = (uint32_t) (perp * 4 * tex.width) & tex.width_mask;
+        double step = 1.0 * tex.height / line_height;
+        int top = max(LAYOUT_BENCH_HEIGHT / 2 - line_height / 2, 0);
+        Rendering::ColumnSpan span;
+        if (layout == Rendering::COLUMN_MAJOR) {
+            span.texels = atlas.texels(tex, layout) + (tex_x << tex.height_shift);
+            span.width_shift = 0;
+        } else {
+            span.texels = atlas.texels(tex) + tex_x;
+            span.width_shift = tex.width_shift;
+        }
+        span.row_shift = 32 - tex.height_shift;
+        span.v_step = Rendering::toColumnV(step, tex.height_shift);
+        span.v = Rendering::toColumnV((top - LAYOUT_BENCH_HEIGHT / 2 + line_height / 2) * step, tex.height_shift);
+        span.shade_shift = 0;
+        span.shade_mask = 0xFFFFFFFF;
+        spans.push_back(span);
+        heights.push_back(min(line_height, LAYOUT_BENCH_HEIGHT - 1));
+    }
+    return spans;
+}
+
+BENCH_CASE("8.1: Rotated floor views and wall columns, row major vs Morton and column major texels", "[textures]") {
+    const unsigned long sizes[] = {64, 256};
+    const double angles[] = {0, 30, 45, 90};
+    printf("  L1 misses are from a %d KiB %d way LRU model\n", BENCH_L1_BYTES / 1024, BENCH_L1_WAYS);
+    vector<uint32_t> column(LAYOUT_BENCH_HEIGHT);
+    for (unsigned long size : sizes) {
+        map<string, Texture> textures;
+        Texture& tex = textures["layout"];
+        tex.width = size;
+        tex.height = size;
+        tex.texture.resize(size * size);
+        for (size_t i = 0; i < tex.texture.size(); i++) {
+            tex.texture[i] = 0xFF000000 | (uint32_t) (i * 2654435761u);
+        }
+        Rendering::TextureAtlas atlas;
+        atlas.build(textures, 8, 8);
+        Rendering::TexHandle handle = atlas.handle("layout");
+        string res = to_string(size) + "x" + to_string(size);
+
+        for (double angle : angles) {
+            FloorView view(atlas, handle, angle * M_PI / 180);
+            for (Rendering::TexelLayout layout : {Rendering::ROW_MAJOR, Rendering::MORTON}) {
+                string name = res + " floor at " + to_string((int) angle) + " deg, " + (layout == Rendering::MORTON ? "Morton" : "row major");
+                uint32_t sum = 0;
+                bench.run(name, [&]() {
+                    view.walk(atlas, layout, [&](const uint32_t* texel) {
+                        sum += *texel;
+                    });
+                    Bench::doNotOptimize(sum);
+                });
+                Bench::CacheModel cache;
+                view.walk(atlas, layout, [&](const uint32_t* texel) {
+                    cache.access(texel);
+                });
+                printf("  %s: %zu of %zu loads miss L1\n", name.c_str(), cache.misses, cache.accesses);
+            }
+        }
+
+        for (Rendering::TexelLayout layout : {Rendering::ROW_MAJOR, Rendering::COLUMN_MAJOR}) {
+            vector<int> heights;
+            vector<Rendering::ColumnSpan> spans = wallColumns(atlas, handle, layout, heights);
+            string name = res + " walls, " + (layout == Rendering::COLUMN_MAJOR ? "column major" : "row major");
+            bench.run(name, [&]() {
+                for (size_t x = 0; x < spans.size(); x++) {
+                    Rendering::sampleColumn(spans[x], column.data(), heights[x]);
+                }
+                Bench::doNotOptimize(column[0]);
+            });
+            Bench::CacheModel cache;
+            for (size_t x = 0; x < spans.size(); x++) {
+                uint32_t v = spans[x].v;
+                for (int i = 0; i < heights[x]; i++, v += spans[x].v_step) {
+                    cache.access(spans[x].texels + ((uint32_t) ((uint64_t) v >> spans[x].row_shift) << spans[x].width_shift));
+                }
+            }
+            printf("  %s: %zu of %zu loads miss L1\n", name.c_str(), cache.misses, cache.accesses);
+        }
+    }
+}
@@ -12,25 +12,25 @@ namespace Animation {
 class Sequence : public BaseInterface::ITickedBase {
     public:
         Sequence();
-        Sequence(vector<string> frames, vector<Tick> durations);
+        Sequence(vector<Rendering::TexHandle> frames, vector<Tick> durations);
 
-        string nextFrame();
+        Rendering::TexHandle nextFrame();
         void reset();
     private:
         int idx = 0;
 
-        vector<string> frames;
+        vector<Rendering::TexHandle> frames;
         vector<Tick> durations;
 };
 
 Sequence::Sequence(){};
 
-Sequence::Sequence(vector<string> frames, vector<Tick> durations) {
+Sequence::Sequence(vector<Rendering::TexHandle> frames, vector<Tick> durations) {
     this->frames = frames;
     this->durations = durations;
 };
 
-string Sequence::nextFrame() {
+Rendering::TexHandle Sequence::nextFrame() {
     if (this->getTick() >= this->durations[this->idx]) {
         this->idx = (this->idx + 1) % (this->frames.size() - 1);
         this->setTick(0);
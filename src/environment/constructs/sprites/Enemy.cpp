@@ -12,15 +12,15 @@ namespace Constructs {
 class Enemy : public Sprite {
     public:
         Enemy(){};
-        Enemy(double xloc, double yloc, vector<string> animation_frames, Tick animation_tick_speed);
+        Enemy(double xloc, double yloc, vector<Rendering::TexHandle> animation_frames, Tick animation_tick_speed);
         void update();
     private:
-        vector<string> animation_frames;
+        vector<Rendering::TexHandle> animation_frames;
         int frame_idx = 0;
         Tick animation_tick_speed;
 };
 
-Enemy::Enemy(double xloc, double yloc, vector<string> animation_frames, Tick animation_tick_speed):
+Enemy::Enemy(double xloc, double yloc, vector<Rendering::TexHandle> animation_frames, Tick animation_tick_speed):
     Sprite(xloc, yloc, animation_frames[0])
 {
     this->animation_frames = animation_frames;
@@ -10,14 +10,11 @@ namespace Constructs {
 
 struct Sprite : public BaseInterface::IEntityBase<double, Coordinates> {
     Sprite();
-    Sprite(double xloc, double yloc, string tex);
+    Sprite(double xloc, double yloc, Rendering::TexHandle tex);
 
     bool operator==(Sprite& other);
-    bool operator<(const Sprite& other) const;
 
-    string texture;
-    double distance;
-    int order;
+    Rendering::TexHandle texture;
 };
 
 Sprite::Sprite():
@@ -25,10 +22,10 @@ Sprite::Sprite():
         Coordinates<double>(0, 0),
         INTERACTION_TYPE::PLAYER_ONLY
     ),
-    texture("")
+    texture(TEX_HANDLE_NONE)
 {};
 
-Sprite::Sprite(double xloc, double yloc, string tex):
+Sprite::Sprite(double xloc, double yloc, Rendering::TexHandle tex):
     IEntityBase<double, Coordinates>(
         Coordinates<double>(xloc, yloc),
         INTERACTION_TYPE::PLAYER_ONLY
@@ -41,11 +38,4 @@ bool Sprite::operator==(Sprite& other) {
         &&  this->texture == other.texture
         &&  this->interaction_type == other.interaction_type);
 }
-
-bool Sprite::operator<(const Sprite& other) const {
-    // This is deliberately reversed in order to have faster sorting of sprites,
-    // Taking half as much time than if it were implemented as you would expect
-    return (this->distance > other.distance
-        &&  this->order > other.order);
-}
 }
\ No newline at end of file
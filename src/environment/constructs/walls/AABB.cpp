@@ -48,9 +48,9 @@ WallType parseWallType(string wall_type_string) {
 
 class AABB : public BaseInterface::IObjectBase<int, Coordinates> {
    public:
-    AABB(int x, int y, Colour::RGB colour, string texture, WallType type);
+    AABB(int x, int y, Colour::RGB colour, Rendering::TexHandle texture, WallType type);
     AABB(int x, int y, Colour::RGB colour, WallType type);
-    AABB(int x, int y, string texture, WallType type);
+    AABB(int x, int y, Rendering::TexHandle texture, WallType type);
     AABB(int x, int y, Colour::RGB colour, AABBFace wf_left, AABBFace wf_right, AABBFace wf_up, AABBFace wf_down, WallType type);
     AABB();
 
@@ -62,7 +62,7 @@ class AABB : public BaseInterface::IObjectBase<int, Coordinates> {
     bool intersect(const Ray& ray, Coords& intersect_point);
 
     Colour::RGB texColour;
-    string texture_name;
+    Rendering::TexHandle texture;
 
     AABBFace wf_left;
     AABBFace wf_right;
@@ -78,18 +78,18 @@ class AABB : public BaseInterface::IObjectBase<int, Coordinates> {
 /// @param int x: X-axis location
 /// @param int y: Y-axis location
 /// @param Colour colour: A colour to set as the AABB
-/// @param string texture: Name of texture for the AABB
+/// @param TexHandle texture: Atlas handle of the texture for the AABB
 ///
 /// @returns AABB
 ///
-AABB::AABB(int x, int y, Colour::RGB colour, string texture, WallType type):
+AABB::AABB(int x, int y, Colour::RGB colour, Rendering::TexHandle texture, WallType type):
     IObjectBase<int, Coordinates>(
         Coordinates<int>(x,y),
         INTERACTION_TYPE::BLOCK_ALL
     )
 {
     this->texColour = colour;
-    this->texture_name = texture;
+    this->texture = texture;
     this->type = type;
 }
 
@@ -100,6 +100,7 @@ AABB::AABB(int x, int y, Colour::RGB colour, AABBFace wf_left, AABBFace wf_right
     )
 {
     this->texColour = colour;
+    this->texture = wf_left.texture;
     this->wf_left = wf_left;
     this->wf_right = wf_right;
     this->wf_up = wf_up;
@@ -107,24 +108,24 @@ AABB::AABB(int x, int y, Colour::RGB colour, AABBFace wf_left, AABBFace wf_right
     this->type = type;
 };
 
-AABB::AABB() : AABB(0, 0, Colour::RGB_None, "", WallType::NONE) {};
+AABB::AABB() : AABB(0, 0, Colour::RGB_None, TEX_HANDLE_NONE, WallType::NONE) {};
 
-AABB::AABB(int x, int y, string texture, WallType type) : AABB(x, y, Colour::RGB_None, texture, type) {};
+AABB::AABB(int x, int y, Rendering::TexHandle texture, WallType type) : AABB(x, y, Colour::RGB_None, texture, type) {};
 
-AABB::AABB(int x, int y, Colour::RGB colour, WallType type) : AABB(x, y, colour, "", type) {};
+AABB::AABB(int x, int y, Colour::RGB colour, WallType type) : AABB(x, y, colour, TEX_HANDLE_NONE, type) {};
 
 bool AABB::operator==(AABB& other) {
     return (this->location.x == other.location.x)
         && (this->location.y == other.location.y)
         && (this->texColour == other.texColour)
-        && (this->texture_name == other.texture_name);
+        && (this->texture == other.texture);
 };
 
 bool AABB::operator!=(AABB& other) {
     return (this->location.x != other.location.x)
         && (this->location.y != other.location.y)
         && (this->texColour != other.texColour)
-        && (this->texture_name != other.texture_name);
+        && (this->texture != other.texture);
 };
 
 NormalDir AABB::getNormDir(int x, int y) {
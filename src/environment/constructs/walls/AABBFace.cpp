@@ -12,19 +12,19 @@ namespace Constructs {
 class AABBFace {
     public:
         AABBFace();
-        AABBFace(Colour::RGB colour, string tex);
+        AABBFace(Colour::RGB colour, Rendering::TexHandle tex);
         ~AABBFace();
 
         Colour::RGB colour;
-        string texture;
+        Rendering::TexHandle texture;
 };
 
 AABBFace::AABBFace() {
     this->colour = Colour::RGB_None;
-    this->texture = "";
+    this->texture = TEX_HANDLE_NONE;
 }
 
-AABBFace::AABBFace(Colour::RGB colour, string tex) {
+AABBFace::AABBFace(Colour::RGB colour, Rendering::TexHandle tex) {
     this->colour = colour;
     this->texture = tex;
 };
@@ -15,6 +15,11 @@ struct Player : public BaseInterface::IEntityBase<double, Coordinates> {
     Player(double x, double y, double fov_x, double fov_y, double angle);
 
     void handleKeyPress(unsigned char key, int x, int y, World &world);
+    void setView(double x, double y, double angle);
+
+    void beginStep();
+    ViewModel::Camera view() const;
+    ViewModel::Camera interpolatedView(double alpha) const;
 
     void printLocation();
     void logLocation();
@@ -26,6 +31,8 @@ struct Player : public BaseInterface::IEntityBase<double, Coordinates> {
     bool isShooting = false;
 
     ViewModel::Camera camera{0,0,0,0.66, ViewModel::Frustrum()};
+    // View as of the start of the last simulation step
+    ViewModel::Camera previous_view{0,0,0,0.66, ViewModel::Frustrum()};
 };
 
 Player::Player():
@@ -54,6 +61,59 @@ void Player::logLocation() {
     debugContext.logAppInfo(string("Player Position: (" + to_string(this->location.x) + "," + to_string(this->location.y) +")"));
 };
 
+///
+/// Place the player and face it along an absolute angle, keeping
+/// the current direction and clip plane lengths (and so the FOV)
+///
+/// @param double x: X-axis location
+/// @param double y: Y-axis location
+/// @param double angle: View angle in radians
+///
+/// @return void
+///
+void Player::setView(double x, double y, double angle) {
+    double dir_len = hypot(this->camera.frustrum.getFovX(), this->camera.frustrum.getFovY());
+    double plane_len = hypot(this->camera.clip_plane_x, this->camera.clip_plane_y);
+    this->location.x = x;
+    this->location.y = y;
+    this->angle = angle;
+    this->camera.frustrum.setFovX(dir_len * cos(angle));
+    this->camera.frustrum.setFovY(dir_len * sin(angle));
+    this->camera.clip_plane_x = -plane_len * sin(angle);
+    this->camera.clip_plane_y = plane_len * cos(angle);
+};
+
+///
+/// Keep the current view before a simulation step moves the player, so
+/// frames drawn during the step can be interpolated from it
+///
+/// @return void
+///
+void Player::beginStep() {
+    this->previous_view = this->view();
+};
+
+///
+/// @return ViewModel::Camera: Camera placed at the player's location
+///
+ViewModel::Camera Player::view() const {
+    ViewModel::Camera view = this->camera;
+    view.x = this->location.x;
+    view.y = this->location.y;
+    return view;
+};
+
+///
+/// View between the start and the end of the last simulation step
+///
+/// @param double alpha: Share of the way through the step, 0 is its start
+///
+/// @return ViewModel::Camera
+///
+ViewModel::Camera Player::interpolatedView(double alpha) const {
+    return ViewModel::interpolate(this->previous_view, this->view(), alpha);
+};
+
 void Player::handleKeyPress(unsigned char key, int x, int y, World &world) {
     if (key == 'w') {
         if (world.getAt((int)(this->location.x + this->camera.frustrum.getFovX() * this->moveSpeed), (int)this->location.y).type == Constructs::WallType::NONE) {
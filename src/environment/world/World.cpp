@@ -9,6 +9,7 @@
 #include "../constructs/walls//AABBFace.cpp"
 #include "../constructs/walls/AABB.cpp"
 #include "../../exceptions/map/MapFormatError.hpp"
+#include "../../exceptions/map/MapLoadError.hpp"
 #include "../../io/resource_management/JSONParser.hpp"
 #include "../../io/logging/GLDebug.cpp"
 #include "Coordinates.hpp"
@@ -16,6 +17,7 @@
 #include "../constructs/sprites/Sprite.cpp"
 #include "../constructs/sprites/Enemy.cpp"
 #include "../../rendering/colour/Colours.cpp"
+#include "../../rendering/texturing/TextureAtlas.cpp"
 
 using namespace std;
 #define MAP_DELIM ";"
@@ -25,12 +27,10 @@ struct World {
     World(GLDebugContext *context = &debugContext);
 
     void fromArray(Constructs::AABB walls[], int width, int height);
-    void readMapFromJSON(string filename);
-    Constructs::AABB getAt(int x, int y);
-    Constructs::AABB getAtPure(int loc);
+    void readMapFromJSON(string filename, const Rendering::TextureAtlas& atlas);
+    inline const Constructs::AABB& getAt(int x, int y) const;
+    inline const Constructs::AABB& getAtPure(int loc) const;
 
-    inline double sqDist(double ax, double ay, double bx, double by);
-    inline void sortSprites(Coordinates<double> player_loc);
     void updateSprites();
 
     int map_width;
@@ -50,15 +50,15 @@ struct World {
     vector<Coords> tree_order_walls;
     vector<Constructs::Sprite> sprites;
 
-    string ceiling_texture;
-    string floor_texture;
+    Rendering::TexHandle ceiling_texture;
+    Rendering::TexHandle floor_texture;
 
     GLDebugContext* context;
 };
 
 World::World(vector<Constructs::AABB> walls, int width, int height, GLDebugContext *context) {
     this->map_width = width;
-    this->map_width = height;
+    this->map_height = height;
     this->walls = walls;
     this->size = width * height;
     this->context = context;
@@ -74,7 +74,7 @@ World::World(GLDebugContext *context){
 
 void World::fromArray(Constructs::AABB walls[], int width, int height) {
     this->map_width = width;
-    this->map_width = height;
+    this->map_height = height;
     for (int i = 0; i < width * height; i++) {
         this->walls.at(i) = walls[i];
     }
@@ -94,7 +94,15 @@ vector<string> splitString(string s, int substring_count, string delimiter) {
     return ss;
 }
 
-void World::readMapFromJSON(string filename) {
+///
+/// Load a map from a JSON file, resolving every texture name to its atlas handle
+///
+/// @param string filename: Path to the map file
+/// @param TextureAtlas atlas: Atlas the texture names are resolved against
+///
+/// @return void
+///
+void World::readMapFromJSON(string filename, const Rendering::TextureAtlas& atlas) {
     ResourceManager::RSJresource jsonres;
     filebuf fileBuffer;
     if (fileBuffer.open(filename.c_str(), ios::in)) {
@@ -102,18 +110,16 @@ void World::readMapFromJSON(string filename) {
         jsonres = ResourceManager::RSJresource(is);
         fileBuffer.close();
     } else {
-        this->context->glDebugMessageCallback(
-            GL_DEBUG_SOURCE::DEBUG_SOURCE_SYSTEM,
-            GL_DEBUG_TYPE::DEBUG_TYPE_ERROR,
-            GL_DEBUG_SEVERITY::DEBUG_SEVERITY_HIGH,
-            "Unable to load map file: " + filename
-        );
+        throw MapLoadError(filename, "Unable to open file");
     }
     this->context->logSysInfo("Retrieved map file: " + filename);
     this->context->logAppInfo("---- STARTED MAP PROCESSING [" + filename +"] ----");
     this->map_width = jsonres["Params"]["Width"].as<int>();
     this->map_height = jsonres["Params"]["Height"].as<int>();
     this->context->logAppInfo("Loading map with dimensions: W = " + to_string(this->map_width) + ", H = " + to_string(this->map_height));
+    if (this->map_width <= 0 || this->map_height <= 0) {
+        throw MapLoadError(filename, "Expected a positive Width and Height");
+    }
     this->size = this->map_height * this->map_width;
     this->start = Coords(
         jsonres["Params"]["Start"]["x"].as<int>(),
@@ -133,25 +139,30 @@ void World::readMapFromJSON(string filename) {
         ResourceManager::RSJobject right = wallObj["Right"].as<ResourceManager::RSJobject>();
         ResourceManager::RSJobject up = wallObj["Up"].as<ResourceManager::RSJobject>();
         ResourceManager::RSJobject down = wallObj["Down"].as<ResourceManager::RSJobject>();
-        this->walls.push_back(
-            Constructs::AABB(
+        Constructs::WallType type = Constructs::parseWallType(wallObj["Type"].as<string>());
+        Constructs::AABB wall(
                 x, y,
                 Colour::STRtoRGB(left["Colour"].as<string>()),
                 Constructs::AABBFace(
                     Colour::STRtoRGB(left["Colour"].as<string>()),
-                    left["Texture"].as<string>()),
+                    atlas.handle(left["Texture"].as<string>())),
                 Constructs::AABBFace(
                     Colour::STRtoRGB(right["Colour"].as<string>()),
-                    right["Texture"].as<string>()),
+                    atlas.handle(right["Texture"].as<string>())),
                 Constructs::AABBFace(
                     Colour::STRtoRGB(up["Colour"].as<string>()),
-                    up["Texture"].as<string>()),
+                    atlas.handle(up["Texture"].as<string>())),
                 Constructs::AABBFace(
                     Colour::STRtoRGB(down["Colour"].as<string>()),
-                    down["Texture"].as<string>()),
-                Constructs::parseWallType(wallObj["Type"].as<string>())
-            )
+                    atlas.handle(down["Texture"].as<string>())),
+                type
         );
+        // Solid cells are always drawn, so give untextured ones the placeholder
+        if (type != Constructs::WallType::NONE && wall.wf_left.texture == TEX_HANDLE_NONE) {
+            wall.wf_left.texture = TEX_HANDLE_MISSING;
+            wall.texture = TEX_HANDLE_MISSING;
+        }
+        this->walls.push_back(wall);
         if (x == 0) {
             this->left_boundary.push_back(Coords(x,y));
         } else if (x == this->map_width - 1) {
@@ -164,20 +175,28 @@ void World::readMapFromJSON(string filename) {
             this->tree_order_walls.push_back(Coords(x,y));
         }
     }
+    // Cells are looked up by position in the wall list, so every one of them must be there
+    if (this->walls.size() != (size_t) this->size) {
+        throw MapLoadError(filename, "Expected " + to_string(this->size) + " walls, got " + to_string(this->walls.size()));
+    }
+    if (this->start.x < 0 || this->start.y < 0 || this->start.x >= this->map_width || this->start.y >= this->map_height) {
+        throw MapLoadError(filename, "Start " + this->start.asString() + " is outside the map");
+    }
     this->context->logAppInfo("Processed " + to_string(wallarr.size()) + " AABB objects");
     ResourceManager::RSJarray spritearr = jsonres["Sprites"].as_array();
     if (spritearr.size() > 0) {
         for (ResourceManager::RSJresource spriteObj : spritearr) {
             double x = spriteObj["x"].as<double>();
             double y = spriteObj["y"].as<double>();
-            string texture = spriteObj["Texture"].as<string>();
+            Rendering::TexHandle texture = atlas.require(spriteObj["Texture"].as<string>());
             ResourceManager::RSJresource isEnemyObj = spriteObj["Enemy"];
             bool isEnemy = isEnemyObj.exists() ? isEnemyObj.as<bool>() : false;
             if (isEnemy) {
                 ResourceManager::RSJarray animation_frames = spriteObj["Animation Frames"].as_array();
-                vector<string> frames(animation_frames.size());
-                for_each(animation_frames.begin(), animation_frames.end(), [&frames](ResourceManager::RSJresource frame) {
-                    frames.push_back(frame.as<string>());
+                vector<Rendering::TexHandle> frames;
+                frames.reserve(animation_frames.size());
+                for_each(animation_frames.begin(), animation_frames.end(), [&frames, &atlas](ResourceManager::RSJresource frame) {
+                    frames.push_back(atlas.require(frame.as<string>()));
                 });
                 int tick_rate = spriteObj["Tick Rate"].as<int>();
                 this->sprites.push_back(Constructs::Enemy(
@@ -194,34 +213,21 @@ void World::readMapFromJSON(string filename) {
         }
         this->context->logAppInfo("Processed " + to_string(spritearr.size()) + " Sprite entities");
     }
-    this->ceiling_texture = jsonres["Ceiling"].as<string>();
-    this->context->logAppInfo("Loaded ceiling texture [" + this->ceiling_texture + "]");
-    this->floor_texture = jsonres["Floor"].as<string>();
-    this->context->logAppInfo("Loaded floor texture [" + this->floor_texture + "]");
+    this->ceiling_texture = atlas.require(jsonres["Ceiling"].as<string>());
+    this->context->logAppInfo("Loaded ceiling texture [" + atlas.name(this->ceiling_texture) + "]");
+    this->floor_texture = atlas.require(jsonres["Floor"].as<string>());
+    this->context->logAppInfo("Loaded floor texture [" + atlas.name(this->floor_texture) + "]");
     this->context->logAppInfo("---- FINISHED MAP PROCESSING [" + filename + "] ----");
 };
 
-Constructs::AABB World::getAt(int x, int y) {
+inline const Constructs::AABB& World::getAt(int x, int y) const {
     return this->walls.at((y * this->map_width) + x);
 };
 
-Constructs::AABB World::getAtPure(int loc) {
+inline const Constructs::AABB& World::getAtPure(int loc) const {
     return this->walls.at(loc);
 };
 
-double World::sqDist(double ax, double ay, double bx, double by) {
-    return pow(bx - ax, 2) + pow(by - ay, 2);
-};
-
-inline void World::sortSprites(Coordinates<double> player_loc) {
-    accumulate(this->sprites.begin(), this->sprites.end(), 0, [this, player_loc](int i, Constructs::Sprite& sprite) -> int {
-        sprite.distance = sqDist(sprite.location.x, player_loc.x, sprite.location.y, player_loc.y);
-        sprite.order = i;
-        return i++;
-    });
-    sort(this->sprites.begin(), this->sprites.end());
-};
-
 void World::updateSprites() {
     for_each(this->sprites.begin(), this->sprites.end(), [](Constructs::Sprite &sprite){
         sprite.update();
@@ -2,11 +2,10 @@
 
 #include <vector>
 #include <string>
-#include <map>
 
 #include "../../animation/Sequence.cpp"
 #include "../../rendering/buffering/PBO.cpp"
-#include "../../rendering/texturing/texture.cpp"
+#include "../../rendering/texturing/TextureAtlas.cpp"
 #include "../../rendering/colour/Colours.cpp"
 
 using namespace std;
@@ -18,7 +17,7 @@ class Weapon {
         Weapon(){};
         Weapon(Animation::Sequence sequence, int posx, int posy);
 
-        void render(Rendering::PBO &pbo, map<string, Texture> &textures);
+        void render(Rendering::PBO &pbo, const Rendering::TextureAtlas &atlas);
     private:
         Animation::Sequence sequence;
         int posx;
@@ -31,16 +30,16 @@ Weapon::Weapon(Animation::Sequence sequence, int posx, int posy) {
     this->posy = posy;
 };
 
-void Weapon::render(Rendering::PBO &pbo, map<string, Texture> &textures) {
-    string frame = this->sequence.nextFrame();
-    Texture texture = textures[frame];
-    for (int x = this->posx; x < this->posx + texture.width; x++) {
-        for (int y = this->posy; y < this->posy + texture.height; y++) {
+void Weapon::render(Rendering::PBO &pbo, const Rendering::TextureAtlas &atlas) {
+    Rendering::TexHandle frame = this->sequence.nextFrame();
+    const Rendering::AtlasEntry& entry = atlas.entry(frame);
+    for (int x = this->posx; x < this->posx + (int) entry.width; x++) {
+        for (int y = this->posy; y < this->posy + (int) entry.height; y++) {
             if (x < 0 || x >= pbo.width || y < 0 || y >= pbo.height) {
                 continue;
             }
             Colour::RGB colour = Colour::INTtoRGB(
-                texture.texture[(y * texture.height) + x]
+                atlas.sample(frame, x - this->posx, y - this->posy)
             );
             if (colour == Colour::RGB_Black) {
                 continue;
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <exception>
+#include <string>
+#include <string.h>
+
+using namespace std;
+
+class InvalidLaunchArgument : virtual public exception {
+    protected:
+        string msg;
+
+    public:
+        explicit InvalidLaunchArgument(const string& argument, const string& reason):
+            msg("[" + argument + "] " + reason)
+        {};
+
+        virtual ~InvalidLaunchArgument() throw(){};
+
+        virtual const char* what() const throw() {
+            return msg.c_str();
+        };
+};
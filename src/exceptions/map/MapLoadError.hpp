@@ -0,0 +1,34 @@
+#pragma once
+
+#include <exception>
+#include <string>
+#include <string.h>
+
+#include "../../rendering/Globals.hpp"
+
+using namespace std;
+
+class MapLoadError : virtual public exception {
+    protected:
+        string filename_val;
+        string reason_val;
+
+    public:
+        explicit MapLoadError(const string& filename, const string& reason):
+            filename_val(filename),
+            reason_val(reason)
+        {};
+
+        virtual ~MapLoadError() throw(){};
+
+        virtual const char* what() const throw() {
+            string ret_val = "Unable to load map [" + filename_val + "]: " + reason_val;
+            debugContext.glDebugMessageCallback(
+                GL_DEBUG_SOURCE::DEBUG_SOURCE_APPLICATION,
+                GL_DEBUG_TYPE::DEBUG_TYPE_ERROR,
+                GL_DEBUG_SEVERITY::DEBUG_SEVERITY_HIGH,
+                ret_val
+            );
+            return strdup(ret_val.c_str());
+        };
+};
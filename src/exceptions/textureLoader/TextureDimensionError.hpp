@@ -0,0 +1,37 @@
+#pragma once
+
+#include <exception>
+#include <string>
+#include <string.h>
+
+#include "../../rendering/Globals.hpp"
+
+using namespace std;
+
+class TextureDimensionError : virtual public exception {
+    protected:
+        string name_val;
+        unsigned long width_val;
+        unsigned long height_val;
+
+    public:
+        explicit TextureDimensionError(const string& name, unsigned long width, unsigned long height):
+            name_val(name),
+            width_val(width),
+            height_val(height)
+        {};
+
+        virtual ~TextureDimensionError() throw(){};
+
+        virtual const char* what() const throw() {
+            string ret_val = "[" + name_val + "] Texture dimensions must be powers of two: "
+                + to_string(width_val) + "x" + to_string(height_val);
+            debugContext.glDebugMessageCallback(
+                GL_DEBUG_SOURCE::DEBUG_SOURCE_APPLICATION,
+                GL_DEBUG_TYPE::DEBUG_TYPE_ERROR,
+                GL_DEBUG_SEVERITY::DEBUG_SEVERITY_HIGH,
+                ret_val
+            );
+            return strdup(ret_val.c_str());
+        };
+};
@@ -74,7 +74,7 @@ void Minimap::renderMap2D() {
     for (y = 0; y < world->map_height; y++) {
         for (x = 0; x < world->map_width; x++) {
             // Change to colour coresponding to map location
-            if (world->getAt(x,y).wf_left.texture != "") {
+            if (world->getAt(x,y).wf_left.texture != TEX_HANDLE_NONE) {
                 glColor3i(0,0,0);
             } else {
                 world->getAt(x, y).wf_left.colour.toColour4d();
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "../../exceptions/config/InvalidLaunchArgument.hpp"
+#include "sections/LaunchCfg.hpp"
+
+using namespace std;
+
+namespace ResourceManager {
+
+#define ARG_HEADLESS "--headless"
+#define ARG_HEADLESS_GL "--headless-gl"
+#define ARG_MAP "--map"
+#define ARG_WIDTH "--width"
+#define ARG_HEIGHT "--height"
+#define ARG_FRAMES "--frames"
+#define ARG_CAMERA_PATH "--camera-path"
+#define ARG_DUMP "--dump"
+#define ARG_RECORD "--record"
+#define ARG_REPLAY "--replay"
+
+class ArgParser {
+    public:
+        ArgParser(int argc, char* argv[]);
+
+        void parse(ConfigSection::LaunchCfg& l_cfg);
+        string usage() const;
+    private:
+        const string& valueOf(size_t& idx);
+        int positiveInt(const string& arg, const string& value);
+
+        string program;
+        vector<string> args;
+};
+
+ArgParser::ArgParser(int argc, char* argv[]) {
+    this->program = argc > 0 ? string(argv[0]) : "W3D";
+    for (int i = 1; i < argc; i++) {
+        this->args.push_back(string(argv[i]));
+    }
+};
+
+const string& ArgParser::valueOf(size_t& idx) {
+    if (idx + 1 >= this->args.size()) {
+        throw InvalidLaunchArgument(this->args[idx], "Missing value");
+    }
+    return this->args[++idx];
+};
+
+int ArgParser::positiveInt(const string& arg, const string& value) {
+    size_t end = 0;
+    int parsed = 0;
+    try {
+        parsed = stoi(value, &end);
+    } catch (const exception& e) {
+        throw InvalidLaunchArgument(arg, "Expected an integer, got: " + value);
+    }
+    if (end != value.size() || parsed <= 0) {
+        throw InvalidLaunchArgument(arg, "Expected a positive integer, got: " + value);
+    }
+    return parsed;
+};
+
+///
+/// Overlay the program arguments onto an existing launch config,
+/// values not passed on the command line are left untouched
+///
+/// @param LaunchCfg l_cfg: Config pre-populated with defaults
+///
+/// @return void
+///
+void ArgParser::parse(ConfigSection::LaunchCfg& l_cfg) {
+    for (size_t i = 0; i < this->args.size(); i++) {
+        const string arg = this->args[i];
+        if (arg == ARG_HEADLESS) {
+            l_cfg.headless = true;
+        } else if (arg == ARG_HEADLESS_GL) {
+            l_cfg.headless = true;
+            l_cfg.headless_gl = true;
+        } else if (arg == ARG_MAP) {
+            l_cfg.map_file = valueOf(i);
+        } else if (arg == ARG_WIDTH) {
+            l_cfg.width = positiveInt(arg, valueOf(i));
+        } else if (arg == ARG_HEIGHT) {
+            l_cfg.height = positiveInt(arg, valueOf(i));
+        } else if (arg == ARG_FRAMES) {
+            l_cfg.frames = positiveInt(arg, valueOf(i));
+        } else if (arg == ARG_CAMERA_PATH) {
+            l_cfg.camera_path = valueOf(i);
+        } else if (arg == ARG_DUMP) {
+            l_cfg.dump_dir = valueOf(i);
+        } else if (arg == ARG_RECORD) {
+            l_cfg.record_file = valueOf(i);
+        } else if (arg == ARG_REPLAY) {
+            l_cfg.headless = true;
+            l_cfg.replay_file = valueOf(i);
+        } else {
+            throw InvalidLaunchArgument(arg, "Unknown argument");
+        }
+    }
+};
+
+string ArgParser::usage() const {
+    return "Usage: " + this->program + " [options]\n"
+        "  " ARG_HEADLESS "              Software render without a window or GL context\n"
+        "  " ARG_HEADLESS_GL "           Headless, but present through an offscreen GL context (EGL builds)\n"
+        "  " ARG_MAP " <file>           Map JSON to load\n"
+        "  " ARG_WIDTH " <px>           Render target width\n"
+        "  " ARG_HEIGHT " <px>          Render target height\n"
+        "  " ARG_FRAMES " <n>           Frames to render in headless mode\n"
+        "  " ARG_CAMERA_PATH " <file>   Camera keyframes (x y angle_deg per line) for headless mode\n"
+        "  " ARG_DUMP " <dir>           Write each headless frame as a PPM into <dir>\n"
+        "  " ARG_RECORD " <file>        Record the keys pressed in the window into <file>\n"
+        "  " ARG_REPLAY " <file>        Replay a recording headless, a frame per simulation step\n";
+};
+}
@@ -86,6 +86,7 @@ ConfigSection::LoggingCfg ConfigInit::initLoggingConfig() {
 };
 
 ConfigSection::RenderCfg ConfigInit::initRenderConfig() {
+    long render_distance = reader.GetInteger(RENDER_SECTION, "render_distance", 10);
     return ConfigSection::RenderCfg{
         reader.GetBoolean(RENDER_SECTION, "headless_mode", false),
         reader.GetBoolean(RENDER_SECTION, "double_buffer", false),
@@ -94,10 +95,23 @@ ConfigSection::RenderCfg ConfigInit::initRenderConfig() {
         reader.GetBoolean(RENDER_SECTION, "render_sprites", true),
         static_cast<int>(reader.GetInteger(RENDER_SECTION, "refresh_rate", 60)),
         static_cast<int>(reader.GetInteger(RENDER_SECTION, "ray_count", 80)),
-        static_cast<int>(reader.GetInteger(RENDER_SECTION, "render_distance", 10)),
+        static_cast<int>(render_distance),
         static_cast<int>(reader.GetInteger(RENDER_SECTION, "texture_width", 64)),
         static_cast<int>(reader.GetInteger(RENDER_SECTION, "texture_height", 64)),
-        reader.GetBoolean(RENDER_SECTION, "show_stats_bar", false)
+        reader.GetBoolean(RENDER_SECTION, "show_stats_bar", false),
+        static_cast<int>(reader.GetInteger(RENDER_SECTION, "render_threads", 0)),
+        reader.GetBoolean(RENDER_SECTION, "column_major_target", false),
+        static_cast<int>(reader.GetInteger(RENDER_SECTION, "stream_buffers", 3)),
+        static_cast<int>(reader.GetInteger(RENDER_SECTION, "fog_start", render_distance)),
+        static_cast<int>(reader.GetInteger(RENDER_SECTION, "fog_colour", 0x000000)),
+        static_cast<int>(reader.GetInteger(RENDER_SECTION, "occupancy_grid_min_size", 128)),
+        ConfigSection::parseWallQuery(reader.Get(RENDER_SECTION, "wall_query", "DDA")),
+        reader.GetBoolean(RENDER_SECTION, "dynamic_resolution", false),
+        reader.GetReal(RENDER_SECTION, "min_render_scale", 0.5),
+        reader.GetReal(RENDER_SECTION, "max_render_scale", 1.0),
+        reader.GetBoolean(RENDER_SECTION, "mipmaps", true),
+        reader.GetBoolean(RENDER_SECTION, "indexed_colour", false),
+        static_cast<int>(reader.GetInteger(RENDER_SECTION, "sim_rate", 60))
     };
 }
 
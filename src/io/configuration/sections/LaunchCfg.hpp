@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+
+using namespace std;
+
+namespace ConfigSection {
+
+struct LaunchCfg {
+    bool headless;
+    string map_file;
+    int width;
+    int height;
+    int frames;
+    string camera_path;
+    string dump_dir;
+    bool headless_gl;
+    string record_file;
+    string replay_file;
+};
+}
@@ -1,9 +1,23 @@
 #pragma once
 
+#include <string>
+
 using namespace std;
 
 namespace ConfigSection {
 
+enum WallQuery {
+    DDA,
+    QSP
+};
+
+WallQuery parseWallQuery(const string& query_str) {
+    if (query_str == "QSP") {
+        return WallQuery::QSP;
+    }
+    return WallQuery::DDA;
+}
+
 struct RenderCfg {
     bool headless_mode;
     bool double_buffer;
@@ -16,5 +30,18 @@ struct RenderCfg {
     int texture_width;
     int texture_height;
     bool show_stats_bar;
+    int render_threads;
+    bool column_major_target;
+    int stream_buffers;
+    int fog_start;
+    int fog_colour;
+    int occupancy_grid_min_size;
+    WallQuery wall_query;
+    bool dynamic_resolution;
+    double min_render_scale;
+    double max_render_scale;
+    bool mipmaps;
+    bool indexed_colour;
+    int sim_rate;
 };
 }
\ No newline at end of file
@@ -0,0 +1,254 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "../../exceptions/replay/InputRecordingFormatError.hpp"
+
+using namespace std;
+
+namespace ResourceManager {
+
+#define INPUT_RECORDING_MAGIC "W3DI"
+// Bump whenever the header, the events or what a simulation step does change
+#define INPUT_RECORDING_VERSION 1
+// Longest varint of a 64 bit tick delta
+#define INPUT_RECORDING_MAX_VARINT 10
+
+enum InputAction : uint8_t {
+    KEY_UP = 0,
+    KEY_DOWN = 1,
+    // Marks the step the session ended on, written once when the recording is closed
+    RECORDING_END = 2
+};
+
+///
+/// A key going up or down, taking effect from the start of a simulation step
+///
+struct InputEvent {
+    uint64_t tick;
+    uint8_t key;
+    InputAction action;
+};
+
+///
+/// Header of a recording, the map path follows it and then the events. Each
+/// event is the steps since the one before as a varint, the key and the action,
+/// so most take 3 bytes. Written in host byte order, which is little endian on
+/// every platform W3D builds for
+///
+struct InputRecordingHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t sim_rate;
+    uint32_t map_file_bytes;
+    // Player config the session was simulated with, the step size and speeds decide where keys take the player
+    double fov;
+    double move_speed;
+    double rotation_speed;
+};
+
+static_assert(sizeof(InputRecordingHeader) == 40, "InputRecordingHeader is written to disk as is, keep it packed");
+
+///
+/// Input of a play session, with what is needed to simulate it again exactly:
+/// the map, the simulation rate and the player config
+///
+class InputRecording {
+    public:
+        InputRecording();
+        InputRecording(const string& map_file, int sim_rate, double fov, double move_speed, double rotation_speed);
+
+        static InputRecording load(const string& filename);
+
+        bool open(const string& filename);
+        bool record(uint64_t tick, uint8_t key, InputAction action);
+        void close(uint64_t tick);
+        inline bool isOpen() const;
+
+        string map_file;
+        int sim_rate;
+        double fov;
+        double move_speed;
+        double rotation_speed;
+        vector<InputEvent> events;
+        // Steps the session lasted
+        uint64_t length;
+    private:
+        FILE* file;
+};
+
+InputRecording::InputRecording():
+    sim_rate(0),
+    fov(0),
+    move_speed(0),
+    rotation_speed(0),
+    length(0),
+    file(nullptr)
+{};
+
+///
+/// @param string map_file: Map the session is played on
+/// @param int sim_rate: Simulation steps per second
+/// @param double fov: Player FOV, as scaled in the player config
+/// @param double move_speed: Cells per second
+/// @param double rotation_speed: Radians per second
+///
+InputRecording::InputRecording(const string& map_file, int sim_rate, double fov, double move_speed, double rotation_speed):
+    InputRecording()
+{
+    this->map_file = map_file;
+    this->sim_rate = sim_rate;
+    this->fov = fov;
+    this->move_speed = move_speed;
+    this->rotation_speed = rotation_speed;
+};
+
+///
+/// Read a whole recording. A recording that was never closed, say after a
+/// crash, ends with its last event
+///
+/// @param string filename: Recording to read
+///
+/// @return InputRecording
+///
+InputRecording InputRecording::load(const string& filename) {
+    FILE* file = fopen(filename.c_str(), "rb");
+    if (file == nullptr) {
+        throw InputRecordingFormatError(filename, "Unable to open file");
+    }
+    InputRecordingHeader header;
+    bool read = fread(&header, sizeof(header), 1, file) == 1;
+    if (!read || memcmp(header.magic, INPUT_RECORDING_MAGIC, sizeof(header.magic)) != 0) {
+        fclose(file);
+        throw InputRecordingFormatError(filename, "Not an input recording");
+    }
+    if (header.version != INPUT_RECORDING_VERSION) {
+        fclose(file);
+        throw InputRecordingFormatError(filename, "Version " + std::to_string(header.version)
+            + ", expected " + std::to_string(INPUT_RECORDING_VERSION));
+    }
+    string map_file(header.map_file_bytes, '\0');
+    if (fread(&map_file[0], 1, map_file.size(), file) != map_file.size()) {
+        fclose(file);
+        throw InputRecordingFormatError(filename, "Truncated header");
+    }
+    InputRecording recording(map_file, header.sim_rate, header.fov, header.move_speed, header.rotation_speed);
+
+    uint64_t tick = 0;
+    int byte;
+    while ((byte = fgetc(file)) != EOF) {
+        uint64_t delta = 0;
+        int shift = 0;
+        for (; byte & 0x80; byte = fgetc(file), shift += 7) {
+            if (byte == EOF || shift >= 7 * INPUT_RECORDING_MAX_VARINT) {
+                fclose(file);
+                throw InputRecordingFormatError(filename, "Malformed event " + std::to_string(recording.events.size()));
+            }
+            delta |= (uint64_t) (byte & 0x7F) << shift;
+        }
+        delta |= (uint64_t) byte << shift;
+        int key = fgetc(file);
+        int action = fgetc(file);
+        if (key == EOF || action == EOF || action > RECORDING_END) {
+            fclose(file);
+            throw InputRecordingFormatError(filename, "Malformed event " + std::to_string(recording.events.size()));
+        }
+        tick += delta;
+        recording.length = tick;
+        if (action == RECORDING_END) {
+            break;
+        }
+        recording.events.push_back(InputEvent{tick, (uint8_t) key, (InputAction) action});
+    }
+    fclose(file);
+    return recording;
+};
+
+///
+/// Start writing the recording to a file, events are written as they are recorded
+///
+/// @param string filename: Output file path
+///
+/// @return bool: False if the file could not be written
+///
+bool InputRecording::open(const string& filename) {
+    this->file = fopen(filename.c_str(), "wb");
+    if (this->file == nullptr) {
+        return false;
+    }
+    InputRecordingHeader header;
+    memcpy(header.magic, INPUT_RECORDING_MAGIC, sizeof(header.magic));
+    header.version = INPUT_RECORDING_VERSION;
+    header.sim_rate = this->sim_rate;
+    header.map_file_bytes = this->map_file.size();
+    header.fov = this->fov;
+    header.move_speed = this->move_speed;
+    header.rotation_speed = this->rotation_speed;
+    bool written = fwrite(&header, sizeof(header), 1, this->file) == 1
+        && fwrite(this->map_file.data(), 1, this->map_file.size(), this->file) == this->map_file.size()
+        && fflush(this->file) == 0;
+    if (!written) {
+        fclose(this->file);
+        this->file = nullptr;
+    }
+    return written;
+};
+
+///
+/// Add an event, and write it out straight away if the recording is open
+///
+/// @param uint64_t tick: Simulation step the event takes effect from, no earlier than the last event's
+/// @param uint8_t key: Key that went up or down
+/// @param InputAction action: What the key did
+///
+/// @return bool: False if the event could not be written
+///
+bool InputRecording::record(uint64_t tick, uint8_t key, InputAction action) {
+    uint64_t delta = tick - this->length;
+    this->length = tick;
+    if (action != RECORDING_END) {
+        this->events.push_back(InputEvent{tick, key, action});
+    }
+    if (this->file == nullptr) {
+        return true;
+    }
+    uint8_t bytes[INPUT_RECORDING_MAX_VARINT + 2];
+    size_t count = 0;
+    for (; delta >= 0x80; delta >>= 7) {
+        bytes[count++] = (uint8_t) (delta | 0x80);
+    }
+    bytes[count++] = (uint8_t) delta;
+    bytes[count++] = key;
+    bytes[count++] = action;
+    // Flushed per event, they are only as frequent as key presses and a crash keeps the session so far
+    return fwrite(bytes, 1, count, this->file) == count && fflush(this->file) == 0;
+};
+
+///
+/// Mark where the session ended and close the file
+///
+/// @param uint64_t tick: Steps the session lasted
+///
+/// @return void
+///
+void InputRecording::close(uint64_t tick) {
+    if (this->file == nullptr) {
+        return;
+    }
+    record(tick, 0, RECORDING_END);
+    fclose(this->file);
+    this->file = nullptr;
+};
+
+///
+/// @return bool: True while events are written to a file
+///
+inline bool InputRecording::isOpen() const {
+    return this->file != nullptr;
+}
+}
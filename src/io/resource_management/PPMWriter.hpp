@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace ResourceManager {
+namespace PPM {
+
+///
+/// Write a packed 0xAARRGGBB buffer as a binary (P6) PPM image
+///
+/// @param string filename: Output file path
+/// @param uint32_t* pixels: Packed pixel data, alpha is ignored
+/// @param int w: Image width
+/// @param int h: Image height
+/// @param bool inverted: Whether the buffer is stored rotated 180 degrees
+///                       (as the PBO is) and should be flipped on write
+///
+/// @return int: 0 on success, 1 if the file could not be written
+///
+int saveImage(const string& filename, const uint32_t* pixels, int w, int h, bool inverted = false) {
+    FILE* file = fopen(filename.c_str(), "wb");
+    if (file == nullptr) {
+        return 1;
+    }
+    fprintf(file, "P6\n%d %d\n255\n", w, h);
+    vector<unsigned char> row(w * 3);
+    for (int y = 0; y < h; y++) {
+        const uint32_t* src = pixels + (inverted ? h - 1 - y : y) * w;
+        for (int x = 0; x < w; x++) {
+            uint32_t px = src[inverted ? w - 1 - x : x];
+            row[x * 3 + 0] = (px >> 16) & 0xFF;
+            row[x * 3 + 1] = (px >> 8) & 0xFF;
+            row[x * 3 + 2] = px & 0xFF;
+        }
+        if (fwrite(row.data(), 1, row.size(), file) != row.size()) {
+            fclose(file);
+            return 1;
+        }
+    }
+    fclose(file);
+    return 0;
+}
+}
+}
@@ -65,13 +65,13 @@ vector<GraphNode> AStar::neighbors(GraphNode node) {
     for (int i = 0; i < 4; i++) {
         int cx{loc_to_check[i][0].x}, cy{loc_to_check[i][0].y};
         bool cInMap = inMap(Coords(node.x + cx, node.y + cy));
-        bool cIsWall = !cInMap ? false : map.getAt(node.x + cx, node.y + cy).wf_left.texture != "";
+        bool cIsWall = !cInMap ? false : map.getAt(node.x + cx, node.y + cy).wf_left.texture != TEX_HANDLE_NONE;
         int cx1{loc_to_check[i][1].x}, cy1{loc_to_check[i][1].y};
         bool c1InMap = inMap(Coords(node.x + cx1, node.y + cy1));
-        bool c1IsWall = !c1InMap ? false : map.getAt(node.x + cx1, node.y + cy1).wf_left.texture != "";
+        bool c1IsWall = !c1InMap ? false : map.getAt(node.x + cx1, node.y + cy1).wf_left.texture != TEX_HANDLE_NONE;
         int cx2{loc_to_check[i][1].x}, cy2{loc_to_check[i][1].y};
         bool c2InMap = inMap(Coords(node.x + cx2, node.y + cy2));
-        bool c2IsWall = !c2InMap ? false : map.getAt(node.x + cx2, node.y + cy2).wf_left.texture != "";
+        bool c2IsWall = !c2InMap ? false : map.getAt(node.x + cx2, node.y + cy2).wf_left.texture != TEX_HANDLE_NONE;
         if (cInMap) {
             if (cIsWall) {
                 if (c1InMap && !c1IsWall) {
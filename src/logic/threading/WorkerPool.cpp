@@ -0,0 +1,127 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+typedef function<void(int worker, int worker_count)> WorkerJob;
+
+///
+/// Persistent pool of worker threads that all run the same job and
+/// rendezvous when it completes. The calling thread takes part as worker 0,
+/// so a pool of size N owns N - 1 threads
+///
+class WorkerPool {
+    public:
+        WorkerPool();
+        ~WorkerPool();
+
+        void start(int thread_count);
+        void stop();
+        void run(const WorkerJob& job);
+
+        inline int size() const noexcept;
+    private:
+        void workerLoop(int worker, unsigned long seen);
+
+        vector<thread> threads;
+        mutex lock;
+        condition_variable job_ready;
+        condition_variable job_done;
+        const WorkerJob* job = nullptr;
+        unsigned long generation = 0;
+        int pending = 0;
+        int worker_count = 1;
+        bool stopping = false;
+};
+
+WorkerPool::WorkerPool(){};
+
+WorkerPool::~WorkerPool() {
+    stop();
+};
+
+///
+/// Spawn the worker threads, restarting the pool if it is already running
+///
+/// @param int thread_count: Total workers including the calling thread
+///
+/// @return void
+///
+void WorkerPool::start(int thread_count) {
+    stop();
+    this->stopping = false;
+    this->worker_count = max(1, thread_count);
+    for (int i = 1; i < this->worker_count; i++) {
+        this->threads.push_back(thread(&WorkerPool::workerLoop, this, i, this->generation));
+    }
+};
+
+void WorkerPool::stop() {
+    {
+        unique_lock<mutex> guard(this->lock);
+        this->stopping = true;
+    }
+    this->job_ready.notify_all();
+    for (thread& worker : this->threads) {
+        worker.join();
+    }
+    this->threads.clear();
+    this->worker_count = 1;
+};
+
+///
+/// Run a job on every worker and block until they have all finished
+///
+/// @param WorkerJob job: Called once per worker with (worker, worker_count)
+///
+/// @return void
+///
+void WorkerPool::run(const WorkerJob& job) {
+    if (this->threads.empty()) {
+        job(0, 1);
+        return;
+    }
+    {
+        unique_lock<mutex> guard(this->lock);
+        this->job = &job;
+        this->pending = this->worker_count - 1;
+        this->generation++;
+    }
+    this->job_ready.notify_all();
+    job(0, this->worker_count);
+    unique_lock<mutex> guard(this->lock);
+    this->job_done.wait(guard, [this]() { return this->pending == 0; });
+    this->job = nullptr;
+};
+
+inline int WorkerPool::size() const noexcept {
+    return this->worker_count;
+};
+
+void WorkerPool::workerLoop(int worker, unsigned long seen) {
+    while (true) {
+        const WorkerJob* current;
+        int count;
+        {
+            unique_lock<mutex> guard(this->lock);
+            this->job_ready.wait(guard, [this, seen]() { return this->stopping || this->generation != seen; });
+            if (this->stopping) {
+                return;
+            }
+            seen = this->generation;
+            current = this->job;
+            count = this->worker_count;
+        }
+        (*current)(worker, count);
+        {
+            unique_lock<mutex> guard(this->lock);
+            this->pending--;
+        }
+        this->job_done.notify_one();
+    }
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+#include <algorithm>
+
+using namespace std;
+
+// Steps run for one frame at most. After a longer stall the time left over is
+// dropped, rather than the simulation falling further behind every frame
+#define FIXED_TIMESTEP_MAX_STEPS 8
+
+///
+/// Turns the time between frames into a whole number of simulation steps of a
+/// fixed length. Time short of a full step carries over to the next frame, so
+/// the step rate doesn't depend on the frame rate. Its share of a step is the
+/// alpha to interpolate the last two simulated states by
+///
+class FixedTimestep {
+    public:
+        FixedTimestep();
+        FixedTimestep(int rate, int max_steps = FIXED_TIMESTEP_MAX_STEPS);
+
+        int advance(double elapsed);
+        inline double alpha() const;
+
+        // Seconds per step
+        double step;
+        // Steps run since construction
+        uint64_t steps;
+    private:
+        double accumulator;
+        int max_steps;
+};
+
+FixedTimestep::FixedTimestep():
+    FixedTimestep(60)
+{};
+
+///
+/// @param int rate: Steps per second, at least 1
+/// @param int max_steps: Steps to run for one frame at most
+///
+FixedTimestep::FixedTimestep(int rate, int max_steps):
+    step(1.0 / max(rate, 1)),
+    steps(0),
+    accumulator(0),
+    max_steps(max(max_steps, 1))
+{};
+
+///
+/// Add the time since the last frame
+///
+/// @param double elapsed: Seconds since the last call
+///
+/// @return int: Steps to simulate before this frame is rendered
+///
+int FixedTimestep::advance(double elapsed) {
+    this->accumulator += max(elapsed, 0.0);
+    int count = (int) (this->accumulator / this->step);
+    if (count > this->max_steps) {
+        count = this->max_steps;
+        this->accumulator = fmod(this->accumulator, this->step);
+    } else {
+        this->accumulator = max(this->accumulator - count * this->step, 0.0);
+    }
+    this->steps += count;
+    return count;
+};
+
+///
+/// @return double: Share of a step elapsed since the last step was simulated, 0 to 1
+///
+inline double FixedTimestep::alpha() const {
+    return min(this->accumulator / this->step, 1.0);
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <math.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+///
+/// Frame times of a run, kept per render stage so the slow frames of each
+/// stage can be told apart from the slow frames overall
+///
+class FrameStats {
+    public:
+        FrameStats();
+        FrameStats(vector<string> stages);
+
+        void add(const vector<double>& stage_ms);
+        double percentile(size_t stage, double percent) const;
+        string report() const;
+
+        inline size_t frames() const;
+
+        vector<string> stages;
+    private:
+        // Milliseconds of every frame, one list per stage
+        vector<vector<double>> times;
+};
+
+FrameStats::FrameStats(){};
+
+///
+/// @param vector<string> stages: Name of each stage, in the order their times are added
+///
+FrameStats::FrameStats(vector<string> stages):
+    stages(stages),
+    times(stages.size())
+{};
+
+///
+/// @param vector<double> stage_ms: Milliseconds the frame spent in each stage
+///
+/// @return void
+///
+void FrameStats::add(const vector<double>& stage_ms) {
+    for (size_t stage = 0; stage < this->times.size() && stage < stage_ms.size(); stage++) {
+        this->times[stage].push_back(stage_ms[stage]);
+    }
+};
+
+///
+/// Nearest rank percentile, the time that many percent of frames took at most
+///
+/// @param size_t stage: Index of the stage
+/// @param double percent: 0 to 100, 100 is the slowest frame
+///
+/// @return double: Milliseconds, 0 if no frames were added
+///
+double FrameStats::percentile(size_t stage, double percent) const {
+    vector<double> sorted = this->times[stage];
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t rank = (size_t) ceil(min(max(percent, 0.0), 100.0) / 100 * sorted.size());
+    size_t idx = rank == 0 ? 0 : rank - 1;
+    nth_element(sorted.begin(), sorted.begin() + idx, sorted.end());
+    return sorted[idx];
+};
+
+///
+/// @return string: Table of p50, p95, p99 and max for each stage
+///
+string FrameStats::report() const {
+    size_t name_width = 5;
+    for (const string& stage : this->stages) {
+        name_width = max(name_width, stage.size());
+    }
+    char line[256];
+    snprintf(line, sizeof(line), "%-*s | %10s | %10s | %10s | %10s\n", (int) name_width, "Stage", "p50 ms", "p95 ms", "p99 ms", "max ms");
+    string out = line;
+    for (size_t stage = 0; stage < this->stages.size(); stage++) {
+        snprintf(line, sizeof(line), "%-*s | %10.3f | %10.3f | %10.3f | %10.3f\n", (int) name_width, this->stages[stage].c_str(),
+            percentile(stage, 50), percentile(stage, 95), percentile(stage, 99), percentile(stage, 100));
+        out += line;
+    }
+    return out;
+};
+
+///
+/// @return size_t: Frames added
+///
+inline size_t FrameStats::frames() const {
+    return this->times.empty() ? 0 : this->times[0].size();
+}
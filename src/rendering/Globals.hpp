@@ -1,6 +1,7 @@
 #pragma once
 #define GL_SILENCE_DEPRECATION
 
+#include <cmath>
 #include <iostream>
 #include <sstream>
 
@@ -8,6 +9,7 @@
 #include "../io/configuration/sections/LoggingCfg.hpp"
 #include "../io/configuration/sections/MinimapCfg.hpp"
 #include "../io/configuration/sections/RenderCfg.hpp"
+#include "../io/configuration/sections/LaunchCfg.hpp"
 #include "../io/logging/GLDebug.cpp"
 #include "../environment/world/Coordinates.hpp"
 #include "raycaster/Ray.hpp"
@@ -61,6 +63,7 @@ static ConfigSection::PlayerCfg playerCfg = ConfigSection::PlayerCfg();
 static ConfigSection::MinimapCfg minimapCfg = ConfigSection::MinimapCfg();
 static ConfigSection::LoggingCfg loggingCfg = ConfigSection::LoggingCfg();
 static ConfigSection::RenderCfg renderCfg = ConfigSection::RenderCfg();
+static ConfigSection::LaunchCfg launchCfg = ConfigSection::LaunchCfg();
 
 static GLDebugContext debugContext;
 
@@ -69,10 +72,17 @@ typedef vector<uint32_t> PNGTex;
 typedef uint64_t Tick;
 
 namespace Rendering {
-    typedef vector<Ray> RayBuffer;
+    typedef vector<CameraRay> RayBuffer;
     typedef vector<double> ZBuffer;
+    typedef vector<int> SpanBuffer;
+    typedef uint32_t TexHandle;
 }
 
+// Handle of an empty texture name, i.e. a cell without a wall face
+#define TEX_HANDLE_NONE 0xFFFFFFFF
+// Handle of the generated placeholder used for unknown texture names
+#define TEX_HANDLE_MISSING 0
+
 static Tick global_tick;
 
 #define __EMTPY_VOID_FUNC__() (void (func*)())
\ No newline at end of file
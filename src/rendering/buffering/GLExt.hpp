@@ -0,0 +1,188 @@
+#pragma once
+
+#define GL_SILENCE_DEPRECATION
+
+#if _WIN64 || _WIN32
+    #include <windows.h>
+    #include <GL/glut.h>
+    #include <GL/glext.h>
+#elif __APPLE__
+    #include <GLUT/glut.h>
+#elif __linux__
+    #include <GL/glut.h>
+    #include <GL/glext.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+
+#include "../Globals.hpp"
+
+using namespace std;
+
+#if __linux__
+// Declared here rather than through GL/glx.h, which drags in Xlib macros
+extern "C" void (*glXGetProcAddressARB(const GLubyte* name))(void);
+#endif
+
+#if __APPLE__
+// The system headers have no function pointer types, these only keep the
+// pointers below declared since load() never resolves them on this platform
+typedef void (*PFNGLGENBUFFERSPROC)(GLsizei n, GLuint* buffers);
+typedef void (*PFNGLDELETEBUFFERSPROC)(GLsizei n, const GLuint* buffers);
+typedef void (*PFNGLBINDBUFFERPROC)(GLenum target, GLuint buffer);
+typedef void (*PFNGLBUFFERDATAPROC)(GLenum target, GLsizeiptr size, const void* data, GLenum usage);
+typedef void* (*PFNGLMAPBUFFERPROC)(GLenum target, GLenum access);
+typedef void* (*PFNGLMAPBUFFERRANGEPROC)(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+typedef GLboolean (*PFNGLUNMAPBUFFERPROC)(GLenum target);
+typedef GLsync (*PFNGLFENCESYNCPROC)(GLenum condition, GLbitfield flags);
+typedef GLenum (*PFNGLCLIENTWAITSYNCPROC)(GLsync sync, GLbitfield flags, GLuint64 timeout);
+typedef void (*PFNGLDELETESYNCPROC)(GLsync sync);
+typedef void (*PFNGLGENVERTEXARRAYSPROC)(GLsizei n, GLuint* arrays);
+typedef void (*PFNGLBINDVERTEXARRAYPROC)(GLuint array);
+typedef void (*PFNGLDELETEVERTEXARRAYSPROC)(GLsizei n, const GLuint* arrays);
+#endif
+
+#ifndef GL_MAP_WRITE_BIT
+    #define GL_MAP_WRITE_BIT 0x0002
+#endif
+#ifndef GL_MAP_INVALIDATE_BUFFER_BIT
+    #define GL_MAP_INVALIDATE_BUFFER_BIT 0x0008
+#endif
+#ifndef GL_MAP_UNSYNCHRONIZED_BIT
+    #define GL_MAP_UNSYNCHRONIZED_BIT 0x0020
+#endif
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+    #define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#endif
+#ifndef GL_SYNC_FLUSH_COMMANDS_BIT
+    #define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#endif
+#ifndef GL_TIMEOUT_EXPIRED
+    #define GL_TIMEOUT_EXPIRED 0x911B
+#endif
+#ifndef GL_WAIT_FAILED
+    #define GL_WAIT_FAILED 0x911D
+#endif
+
+namespace Rendering {
+namespace GLExt {
+
+typedef void (*Proc)(void);
+typedef Proc (*ProcLoader)(const char* name);
+
+///
+/// Features above GL 1.1 the renderer can use, resolved against the current context
+///
+struct Capabilities {
+    bool pixel_buffers;
+    bool map_range;
+    bool sync;
+    bool vertex_arrays;
+};
+
+static Capabilities caps = Capabilities{false, false, false, false};
+
+static PFNGLGENBUFFERSPROC genBuffers = nullptr;
+static PFNGLDELETEBUFFERSPROC deleteBuffers = nullptr;
+static PFNGLBINDBUFFERPROC bindBuffer = nullptr;
+static PFNGLBUFFERDATAPROC bufferData = nullptr;
+static PFNGLMAPBUFFERPROC mapBuffer = nullptr;
+static PFNGLMAPBUFFERRANGEPROC mapBufferRange = nullptr;
+static PFNGLUNMAPBUFFERPROC unmapBuffer = nullptr;
+static PFNGLFENCESYNCPROC fenceSync = nullptr;
+static PFNGLCLIENTWAITSYNCPROC clientWaitSync = nullptr;
+static PFNGLDELETESYNCPROC deleteSync = nullptr;
+static PFNGLGENVERTEXARRAYSPROC genVertexArrays = nullptr;
+static PFNGLBINDVERTEXARRAYPROC bindVertexArray = nullptr;
+static PFNGLDELETEVERTEXARRAYSPROC deleteVertexArrays = nullptr;
+
+///
+/// Resolve an entry point with the windowing system's loader
+///
+/// @param char* name: GL function name
+///
+/// @return Proc: Function address, may be non-null for unsupported functions
+///
+inline Proc platformLoader(const char* name) {
+#if _WIN64 || _WIN32
+    return (Proc) wglGetProcAddress(name);
+#elif __linux__
+    return glXGetProcAddressARB((const GLubyte*) name);
+#else
+    return nullptr;
+#endif
+}
+
+inline bool hasExtension(const char* extensions, const char* name) {
+    if (extensions == nullptr) {
+        return false;
+    }
+    size_t length = strlen(name);
+    for (const char* found = strstr(extensions, name); found != nullptr; found = strstr(found + length, name)) {
+        if ((found == extensions || found[-1] == ' ') && (found[length] == ' ' || found[length] == '\0')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+///
+/// Detect which features the current context supports and resolve their
+/// entry points. Loaders hand back addresses for any name, so support is
+/// decided by version and extension strings only. Requires a current context
+///
+/// @param ProcLoader loader: Entry point loader of the windowing system
+///
+/// @return Capabilities: Usable features, all false if none could be resolved
+///
+inline Capabilities load(ProcLoader loader = platformLoader) {
+    caps = Capabilities{false, false, false, false};
+#if __APPLE__
+    // Legacy macOS contexts only expose these through APPLE extensions, keep to client memory uploads
+    debugContext.logApiInfo("GL pixel buffer streaming is not supported on this platform");
+    return caps;
+#else
+    const char* version = (const char*) glGetString(GL_VERSION);
+    const char* extensions = (const char*) glGetString(GL_EXTENSIONS);
+    int major = 1, minor = 0;
+    if (version == nullptr || sscanf(version, "%d.%d", &major, &minor) != 2) {
+        return caps;
+    }
+    int gl_version = major * 10 + minor;
+
+    #define GLEXT_LOAD(func, name) func = (decltype(func)) loader(name)
+    GLEXT_LOAD(genBuffers, "glGenBuffers");
+    GLEXT_LOAD(deleteBuffers, "glDeleteBuffers");
+    GLEXT_LOAD(bindBuffer, "glBindBuffer");
+    GLEXT_LOAD(bufferData, "glBufferData");
+    GLEXT_LOAD(mapBuffer, "glMapBuffer");
+    GLEXT_LOAD(mapBufferRange, "glMapBufferRange");
+    GLEXT_LOAD(unmapBuffer, "glUnmapBuffer");
+    GLEXT_LOAD(fenceSync, "glFenceSync");
+    GLEXT_LOAD(clientWaitSync, "glClientWaitSync");
+    GLEXT_LOAD(deleteSync, "glDeleteSync");
+    GLEXT_LOAD(genVertexArrays, "glGenVertexArrays");
+    GLEXT_LOAD(bindVertexArray, "glBindVertexArray");
+    GLEXT_LOAD(deleteVertexArrays, "glDeleteVertexArrays");
+    #undef GLEXT_LOAD
+
+    bool buffers = genBuffers && deleteBuffers && bindBuffer && bufferData && mapBuffer && unmapBuffer;
+    caps.pixel_buffers = buffers && (gl_version >= 21 || hasExtension(extensions, "GL_ARB_pixel_buffer_object"));
+    caps.map_range = mapBufferRange && (gl_version >= 30 || hasExtension(extensions, "GL_ARB_map_buffer_range"));
+    caps.sync = fenceSync && clientWaitSync && deleteSync && (gl_version >= 32 || hasExtension(extensions, "GL_ARB_sync"));
+    caps.vertex_arrays = genVertexArrays && bindVertexArray && deleteVertexArrays
+        && (gl_version >= 30 || hasExtension(extensions, "GL_ARB_vertex_array_object"));
+
+    debugContext.logApiInfo("GL " + string(version) + " [" + string((const char*) glGetString(GL_RENDERER)) + "]"
+        + " pixel buffers: " + to_string(caps.pixel_buffers)
+        + ", map range: " + to_string(caps.map_range)
+        + ", sync: " + to_string(caps.sync)
+        + ", vertex arrays: " + to_string(caps.vertex_arrays));
+    return caps;
+#endif
+}
+}
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#ifdef W3D_HAVE_EGL
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "../Globals.hpp"
+#include "GLExt.hpp"
+
+using namespace std;
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+    #define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+namespace Rendering {
+
+///
+/// Windowless GL context on an EGL pbuffer, so the GL presentation path can be
+/// exercised in headless mode on software drivers such as Mesa llvmpipe
+///
+class OffscreenContext {
+    public:
+        OffscreenContext();
+        ~OffscreenContext();
+
+        bool create(int width, int height);
+        void destroy();
+        void readPixels(vector<uint32_t>& pixels);
+
+        static GLExt::Proc loader(const char* name);
+
+        int width;
+        int height;
+    private:
+        EGLDisplay display;
+        EGLSurface surface;
+        EGLContext context;
+};
+
+OffscreenContext::OffscreenContext():
+    width(0),
+    height(0),
+    display(EGL_NO_DISPLAY),
+    surface(EGL_NO_SURFACE),
+    context(EGL_NO_CONTEXT)
+{};
+
+OffscreenContext::~OffscreenContext() {
+    destroy();
+};
+
+///
+/// Create a compatibility profile context on a pbuffer of the given size and make it current.
+/// Prefers the surfaceless Mesa platform, falling back to the default display
+///
+/// @param int width: Surface width
+/// @param int height: Surface height
+///
+/// @return bool: True if the context is current
+///
+bool OffscreenContext::create(int width, int height) {
+    this->width = width;
+    this->height = height;
+
+    typedef EGLDisplay (*PlatformDisplayProc)(EGLenum platform, void* native_display, const EGLint* attribs);
+    PlatformDisplayProc getPlatformDisplay = (PlatformDisplayProc) eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay != nullptr) {
+        this->display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (this->display == EGL_NO_DISPLAY) {
+        this->display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    EGLint major = 0, minor = 0;
+    if (this->display == EGL_NO_DISPLAY || !eglInitialize(this->display, &major, &minor)) {
+        debugContext.logApiInfo("Unable to initialise an EGL display");
+        return false;
+    }
+
+    const EGLint config_attribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint config_count = 0;
+    if (!eglChooseConfig(this->display, config_attribs, &config, 1, &config_count) || config_count == 0) {
+        debugContext.logApiInfo("No EGL config with desktop GL pbuffer support");
+        destroy();
+        return false;
+    }
+
+    const EGLint surface_attribs[] = { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+    this->surface = eglCreatePbufferSurface(this->display, config, surface_attribs);
+    eglBindAPI(EGL_OPENGL_API);
+    this->context = eglCreateContext(this->display, config, EGL_NO_CONTEXT, nullptr);
+    if (this->surface == EGL_NO_SURFACE || this->context == EGL_NO_CONTEXT
+        || !eglMakeCurrent(this->display, this->surface, this->surface, this->context)) {
+        debugContext.logApiInfo("Unable to create an EGL pbuffer context, error: " + to_string(eglGetError()));
+        destroy();
+        return false;
+    }
+    debugContext.logApiInfo("Created EGL " + to_string(major) + "." + to_string(minor)
+        + " offscreen context of " + to_string(width) + "*" + to_string(height));
+    return true;
+};
+
+void OffscreenContext::destroy() {
+    if (this->display == EGL_NO_DISPLAY) {
+        return;
+    }
+    eglMakeCurrent(this->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (this->context != EGL_NO_CONTEXT) {
+        eglDestroyContext(this->display, this->context);
+    }
+    if (this->surface != EGL_NO_SURFACE) {
+        eglDestroySurface(this->display, this->surface);
+    }
+    eglTerminate(this->display);
+    this->display = EGL_NO_DISPLAY;
+    this->surface = EGL_NO_SURFACE;
+    this->context = EGL_NO_CONTEXT;
+};
+
+///
+/// Read back the presented frame as packed 0xAARRGGBB pixels, top row first
+/// as it appears on screen
+///
+/// @param vector pixels: Resized to width*height and overwritten
+///
+/// @return void
+///
+void OffscreenContext::readPixels(vector<uint32_t>& pixels) {
+    pixels.resize(this->width * this->height);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, this->width, this->height, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, pixels.data());
+    // GL reads bottom row first
+    for (int top = 0, bottom = this->height - 1; top < bottom; top++, bottom--) {
+        swap_ranges(pixels.begin() + top * this->width, pixels.begin() + (top + 1) * this->width,
+            pixels.begin() + bottom * this->width);
+    }
+};
+
+GLExt::Proc OffscreenContext::loader(const char* name) {
+    return (GLExt::Proc) eglGetProcAddress(name);
+};
+}
+
+#endif
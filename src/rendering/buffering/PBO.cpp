@@ -11,11 +11,27 @@
     #include <GL/glut.h>
 #endif
 
+// Packed BGRA uploads are core since GL 1.2, older headers (Windows) lack the enums
+#ifndef GL_BGRA
+    #define GL_BGRA 0x80E1
+#endif
+#ifndef GL_UNSIGNED_INT_8_8_8_8_REV
+    #define GL_UNSIGNED_INT_8_8_8_8_REV 0x8367
+#endif
+#ifndef GL_CLAMP_TO_EDGE
+    #define GL_CLAMP_TO_EDGE 0x812F
+#endif
+
+#include <algorithm>
 #include <vector>
 #include <string>
+#include <string.h>
 
 #include "../Globals.hpp"
 #include "../colour/Colours.cpp"
+#include "../colour/Palette.cpp"
+#include "GLExt.hpp"
+#include "Transpose.hpp"
 #include "../../exceptions/buffering/BufferIndexOutOfRange.hpp"
 
 using namespace std;
@@ -26,63 +42,361 @@ namespace Rendering {
 #define PBO_DEFAULT_WIDTH 64
 #define PBO_DEFAULT_HEIGHT 64
 
+// Most pixel unpack buffers in flight, more only adds latency
+#define PBO_MAX_STREAM_BUFFERS 4
+// Nanoseconds to wait on a buffer the GPU is still reading before giving up on it
+#define PBO_FENCE_TIMEOUT 1000000000
+
+// Build with PBO_BOUNDS_CHECK defined (CMake Debug builds) to validate every write
+#ifdef PBO_BOUNDS_CHECK
+    #define PBO_CHECK_RANGE(x, y, count_x, count_y) this->checkRange(x, y, count_x, count_y)
+#else
+    #define PBO_CHECK_RANGE(x, y, count_x, count_y)
+#endif
+
+///
+/// CPU side frame buffer of packed 0xAARRGGBB pixels, the same layout as
+/// texture texels, uploaded as GL_BGRA/GL_UNSIGNED_INT_8_8_8_8_REV so no
+/// swizzle is needed on either side.
+///
+/// In column major mode pixels are stored x * height + y so column writers
+/// touch contiguous memory, and resolve() transposes into a row major copy
+/// before upload.
+///
+/// When the context supports them, frames are streamed through a ring of
+/// GL_PIXEL_UNPACK_BUFFERs. beginFrame() maps the next buffer and the writers
+/// render straight into it (column major frames are transposed into it), then
+/// swapBuffer() unmaps it and starts the texture upload from GPU side memory.
+/// Each buffer is fenced so it is only rewritten once the GPU is done with it,
+/// or orphaned when fences are unavailable. Without pixel buffer support the
+/// frame is uploaded from client memory as before.
+///
+/// Storage is allocated for the display size, the size of the quad the frame is
+/// drawn over. Frames can be rendered smaller than that into the same storage,
+/// with setRenderSize(), and are stretched over the quad with linear filtering.
+///
+/// With a palette set, frames are rendered as one byte palette indices into an
+/// indexed plane of the same layout, and resolve() expands them to packed colour
+///
 class PBO {
     public:
         PBO();
-        PBO(int width, int height);
+        PBO(int width, int height, bool column_major = false);
 
-        void init();
+        void init(int stream_buffers = 0, GLExt::ProcLoader loader = GLExt::platformLoader);
+        void beginFrame();
+        void resolve();
         void swapBuffer();
 
         inline void pushToBuffer(int x, int y, Colour::RGB colour);
+        inline void write(int x, int y, uint32_t texel);
+        inline void writeSpan(int x, int y, int count, const uint32_t* texels);
+        inline void writeColumn(int x, int y, int count, const uint32_t* texels);
+        inline void fill(int x, int y, int count, uint32_t texel);
+        void setPalette(const uint32_t* colours);
+        inline void writeIndexed(int x, int y, uint8_t palette_index);
+        inline void writeIndexedColumn(int x, int y, int count, const uint8_t* indices);
+        inline uint8_t* indexedRow(int y);
+        inline uint8_t* indexedColumn(int x);
+        inline uint32_t* row(int y);
+        inline uint32_t* column(int x);
+        inline bool isColumnMajor() const;
+        inline bool isStreaming() const;
+        inline bool isIndexed() const;
+        inline int index(int x, int y) const;
         inline void resize(int newWidth, int newHeight);
+        inline bool setRenderSize(int newWidth, int newHeight);
         inline void clear();
         inline void blankOut();
+        inline const uint32_t* data() const;
 
+        // Size frames are rendered at
         int width;
         int height;
+        // Size of the quad frames are drawn over, and of the storage allocated for them
+        int display_width;
+        int display_height;
     private:
         bool inRange(int value, int min, int max);
+        void checkRange(int x, int y, int count_x, int count_y);
+        void allocate();
+        void uploadQuad();
+        void drawQuad();
+        inline uint32_t* pixels();
 
-        vector<GLubyte> buffer;
+        bool column_major;
+        vector<uint32_t> buffer;
+        vector<uint32_t> resolved;
         GLuint buffer_id;
+        // Palette indices of indexed frames, and the PALETTE_SIZE colours they expand to
+        vector<uint8_t> indexed;
+        const uint32_t* palette;
+
+        bool gl_ready;
+        int stream_count;
+        int stream_index;
+        GLuint stream_ids[PBO_MAX_STREAM_BUFFERS];
+        GLsync stream_fences[PBO_MAX_STREAM_BUFFERS];
+        uint32_t* mapped;
+
+        GLuint quad_vbo;
+        GLuint quad_vao;
+        // Texture coordinates of the far edges of the rendered part of the texture
+        GLfloat quad_u;
+        GLfloat quad_v;
 };
 
-PBO::PBO(){};
+PBO::PBO():
+    column_major(false),
+    palette(nullptr),
+    gl_ready(false),
+    stream_count(0),
+    stream_index(0),
+    mapped(nullptr),
+    quad_vbo(0),
+    quad_vao(0),
+    quad_u(1),
+    quad_v(1)
+{};
 
-PBO::PBO(int width, int height) {
+PBO::PBO(int width, int height, bool column_major):
+    PBO()
+{
     this->width = width;
     this->height = height;
-    this->buffer = vector<GLubyte>(width * height * 3);
-    debugContext.logApiInfo("Initialised new PBO of size " + to_string(width * height * 3) + " [" + to_string(width) + "*" + to_string(height) + "*3" + "]");
+    this->display_width = width;
+    this->display_height = height;
+    this->column_major = column_major;
+    this->buffer = vector<uint32_t>(width * height);
+    if (column_major) {
+        this->resolved = vector<uint32_t>(width * height);
+    }
+    debugContext.logApiInfo("Initialised new " + string(column_major ? "column" : "row") + " major PBO of size "
+        + to_string(width * height * 4) + " [" + to_string(width) + "*" + to_string(height) + "*4" + "]");
 };
 
-void PBO::init() {
+///
+/// Create the GL objects backing the buffer, requires a current context
+///
+/// @param int stream_buffers: Pixel unpack buffers to stream through, 0 uploads from client memory
+/// @param ProcLoader loader: Entry point loader of the context's windowing system
+///
+/// @return void
+///
+void PBO::init(int stream_buffers, GLExt::ProcLoader loader) {
+    GLExt::load(loader);
     glGenTextures(1, &this->buffer_id);
     glBindTexture(GL_TEXTURE_2D, this->buffer_id);
     debugContext.logApiInfo("Bound PBO texture to id: " + to_string(this->buffer_id));
-
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, this->width, this->height, 0, GL_RGB, GL_UNSIGNED_BYTE, this->buffer.data());
-    debugContext.logApiInfo("Allocated memory for PBO texture at: " + ADDR_OF(*this->buffer.data()));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // Scaled frames don't fill the texture, keep the filter from wrapping around into the unused part
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    this->stream_count = GLExt::caps.pixel_buffers ? min(max(stream_buffers, 0), PBO_MAX_STREAM_BUFFERS) : 0;
+    if (stream_buffers > 0 && this->stream_count == 0) {
+        debugContext.logApiInfo("Pixel unpack buffers unavailable, uploading frames from client memory");
+    }
+    if (this->stream_count > 0) {
+        GLExt::genBuffers(this->stream_count, this->stream_ids);
+    }
+    fill_n(this->stream_fences, PBO_MAX_STREAM_BUFFERS, (GLsync) nullptr);
+    GLExt::genBuffers(1, &this->quad_vbo);
+    if (GLExt::caps.vertex_arrays) {
+        GLExt::genVertexArrays(1, &this->quad_vao);
+    }
+    this->gl_ready = true;
+    allocate();
 };
 
-void PBO::swapBuffer() {
-    glEnable(GL_TEXTURE_2D);
-    glClear(GL_COLOR_BUFFER_BIT);
+///
+/// (Re)allocate the texture, unpack buffers and quad to the display size
+///
+/// @return void
+///
+void PBO::allocate() {
+    glBindTexture(GL_TEXTURE_2D, this->buffer_id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, this->display_width, this->display_height, 0, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, nullptr);
+
+    // Start every buffer black, they keep their contents between frames when fenced
+    vector<uint32_t> blank(this->display_width * this->display_height, 0);
+    for (int i = 0; i < this->stream_count; i++) {
+        if (this->stream_fences[i] != nullptr) {
+            GLExt::deleteSync(this->stream_fences[i]);
+            this->stream_fences[i] = nullptr;
+        }
+        GLExt::bindBuffer(GL_PIXEL_UNPACK_BUFFER, this->stream_ids[i]);
+        GLExt::bufferData(GL_PIXEL_UNPACK_BUFFER, blank.size() * sizeof(uint32_t), blank.data(), GL_STREAM_DRAW);
+    }
+    if (this->stream_count > 0) {
+        GLExt::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        debugContext.logApiInfo("Allocated " + to_string(this->stream_count) + " pixel unpack buffers of "
+            + to_string(blank.size() * sizeof(uint32_t)) + " bytes"
+            + (GLExt::caps.sync ? " (fenced)" : " (orphaned)"));
+    }
+
+    uploadQuad();
+    debugContext.logApiInfo("Allocated PBO texture and quad for " + to_string(this->display_width) + "*" + to_string(this->display_height));
+}
+
+///
+/// Point the quad's texture coordinates at the part of the texture the frame
+/// is rendered into, and stretch that over the display size
+///
+/// @return void
+///
+void PBO::uploadQuad() {
+    // Filtering at a far edge of a scaled frame would blend in the unused texels past it, stop half a texel short
+    this->quad_u = this->width < this->display_width ? (this->width - 0.5f) / this->display_width : 1;
+    this->quad_v = this->height < this->display_height ? (this->height - 0.5f) / this->display_height : 1;
+    if (!this->gl_ready) {
+        return;
+    }
 
-    glTexSubImage2D(GL_TEXTURE_2D,
-        0, 0, 0, this->width,this->height,
-        GL_RGB, GL_UNSIGNED_BYTE,
-        this->buffer.data());
+    // Inverted quad to handle pixel location inversion, as x, y, u, v triangle strip
+    const GLfloat w = this->display_width;
+    const GLfloat h = this->display_height;
+    const GLfloat u = this->quad_u;
+    const GLfloat v = this->quad_v;
+    const GLfloat quad[] = {
+        0, 0, u, v,
+        w, 0, 0, v,
+        0, h, u, 0,
+        w, h, 0, 0
+    };
+    if (this->quad_vao != 0) {
+        GLExt::bindVertexArray(this->quad_vao);
+    }
+    GLExt::bindBuffer(GL_ARRAY_BUFFER, this->quad_vbo);
+    GLExt::bufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    if (this->quad_vao != 0) {
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glVertexPointer(2, GL_FLOAT, 4 * sizeof(GLfloat), (const void*) 0);
+        glTexCoordPointer(2, GL_FLOAT, 4 * sizeof(GLfloat), (const void*) (2 * sizeof(GLfloat)));
+        GLExt::bindVertexArray(0);
+    }
+    GLExt::bindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+///
+/// Map the next unpack buffer of the ring so this frame renders straight into
+/// it, waiting first if the GPU may still be reading it. A no-op when not streaming
+///
+/// @return void
+///
+void PBO::beginFrame() {
+    if (this->stream_count == 0 || this->mapped != nullptr) {
+        return;
+    }
+    this->stream_index = (this->stream_index + 1) % this->stream_count;
+    GLExt::bindBuffer(GL_PIXEL_UNPACK_BUFFER, this->stream_ids[this->stream_index]);
+    GLsizeiptr size = this->width * this->height * sizeof(uint32_t);
+    GLsizeiptr capacity = this->display_width * this->display_height * sizeof(uint32_t);
+    bool retained = false;
+    GLsync fence = this->stream_fences[this->stream_index];
+    if (fence != nullptr) {
+        GLenum status = GLExt::clientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, PBO_FENCE_TIMEOUT);
+        GLExt::deleteSync(fence);
+        this->stream_fences[this->stream_index] = nullptr;
+        retained = status != GL_TIMEOUT_EXPIRED && status != GL_WAIT_FAILED;
+    }
+    if (retained && GLExt::caps.map_range) {
+        this->mapped = (uint32_t*) GLExt::mapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+            GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    } else {
+        // Orphan the storage so the driver never blocks on a pending upload, the new contents are undefined.
+        // Keep the display size so a later, larger render size still fits
+        GLExt::bufferData(GL_PIXEL_UNPACK_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+        this->mapped = (uint32_t*) GLExt::mapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+        if (this->mapped != nullptr && !this->column_major && this->palette == nullptr) {
+            std::fill(this->mapped, this->mapped + this->width * this->height, 0);
+        }
+    }
+    GLExt::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if (this->mapped == nullptr) {
+        debugContext.glDebugMessageCallback(
+            GL_DEBUG_SOURCE::DEBUG_SOURCE_API,
+            GL_DEBUG_TYPE::DEBUG_TYPE_ERROR,
+            GL_DEBUG_SEVERITY::DEBUG_SEVERITY_MEDIUM,
+            "Unable to map pixel unpack buffer " + to_string(this->stream_ids[this->stream_index])
+        );
+    }
+}
+
+///
+/// Bring the row major copy up to date, a no-op for row major buffers.
+/// While streaming, column major frames are transposed straight into the mapped buffer.
+/// Indexed frames are expanded to colour first, row major ones straight into the mapped buffer
+///
+/// @return void
+///
+void PBO::resolve() {
+    if (this->palette != nullptr) {
+        expandPalette(this->indexed.data(), this->column_major ? this->buffer.data() : this->pixels(),
+            this->width * this->height, this->palette);
+    }
+    if (this->column_major) {
+        transposeBlocked(this->buffer.data(), this->mapped != nullptr ? this->mapped : this->resolved.data(), this->width, this->height);
+    }
+}
 
+void PBO::drawQuad() {
+    if (this->quad_vao != 0) {
+        GLExt::bindVertexArray(this->quad_vao);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        GLExt::bindVertexArray(0);
+        return;
+    }
+    if (this->quad_vbo != 0) {
+        GLExt::bindBuffer(GL_ARRAY_BUFFER, this->quad_vbo);
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glVertexPointer(2, GL_FLOAT, 4 * sizeof(GLfloat), (const void*) 0);
+        glTexCoordPointer(2, GL_FLOAT, 4 * sizeof(GLfloat), (const void*) (2 * sizeof(GLfloat)));
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+        GLExt::bindBuffer(GL_ARRAY_BUFFER, 0);
+        return;
+    }
     // Inverted quad to handle pixel location inversion
     glBegin(GL_QUADS);
-        glTexCoord2d(1,1); glVertex2d(0, 0);
-        glTexCoord2d(0,1); glVertex2d(this->width, 0);
-        glTexCoord2d(0,0); glVertex2d(this->width, this->height);
-        glTexCoord2d(1,0); glVertex2d(0, this->height);
+        glTexCoord2d(this->quad_u, this->quad_v); glVertex2d(0, 0);
+        glTexCoord2d(0, this->quad_v); glVertex2d(this->display_width, 0);
+        glTexCoord2d(0, 0); glVertex2d(this->display_width, this->display_height);
+        glTexCoord2d(this->quad_u, 0); glVertex2d(0, this->display_height);
     glEnd();
+}
+
+void PBO::swapBuffer() {
+    glEnable(GL_TEXTURE_2D);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glBindTexture(GL_TEXTURE_2D, this->buffer_id);
+
+    resolve();
+    if (this->mapped != nullptr) {
+        GLExt::bindBuffer(GL_PIXEL_UNPACK_BUFFER, this->stream_ids[this->stream_index]);
+        GLExt::unmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        this->mapped = nullptr;
+        // Sources from the bound unpack buffer, the upload is queued rather than copied here
+        glTexSubImage2D(GL_TEXTURE_2D,
+            0, 0, 0, this->width, this->height,
+            GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV,
+            (const void*) 0);
+        if (GLExt::caps.sync) {
+            this->stream_fences[this->stream_index] = GLExt::fenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+        GLExt::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    } else {
+        glTexSubImage2D(GL_TEXTURE_2D,
+            0, 0, 0, this->width,this->height,
+            GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV,
+            this->data());
+    }
+
+    drawQuad();
     glDisable(GL_TEXTURE_2D);
 }
 
@@ -90,21 +404,269 @@ bool PBO::inRange(int value, int min, int max) {
     return !(value < min) && !(max < value);
 }
 
+void PBO::checkRange(int x, int y, int count_x, int count_y) {
+    if (!inRange(x, 0, this->width - count_x) || !inRange(y, 0, this->height - count_y)) {
+        throw BufferIndexOutOfRange(index(x, y));
+    }
+}
+
 inline void PBO::pushToBuffer(int x, int y, Colour::RGB colour) {
-    int idx = y * this->width + x;
-    if (!inRange(x, 0, this->width) || !inRange(y, 0, this->height)) {
-        throw BufferIndexOutOfRange(idx);
+    PBO_CHECK_RANGE(x, y, 1, 1);
+    this->pixels()[index(x, y)] = Colour::RGBtoINT(colour);
+}
+
+///
+/// Write a single packed pixel
+///
+/// @param int x: Column
+/// @param int y: Row
+/// @param uint32_t texel: Packed 0xAARRGGBB colour
+///
+/// @return void
+///
+inline void PBO::write(int x, int y, uint32_t texel) {
+    PBO_CHECK_RANGE(x, y, 1, 1);
+    this->pixels()[index(x, y)] = texel;
+}
+
+///
+/// Copy a horizontal run of packed pixels into a row
+///
+/// @param int x: First column
+/// @param int y: Row
+/// @param int count: Number of pixels
+/// @param uint32_t* texels: Packed 0xAARRGGBB source pixels
+///
+/// @return void
+///
+inline void PBO::writeSpan(int x, int y, int count, const uint32_t* texels) {
+    PBO_CHECK_RANGE(x, y, count, 1);
+    if (this->column_major) {
+        uint32_t* dst = &this->pixels()[index(x, y)];
+        for (int i = 0; i < count; i++, dst += this->height) {
+            *dst = texels[i];
+        }
+        return;
+    }
+    memcpy(&this->pixels()[index(x, y)], texels, count * sizeof(uint32_t));
+}
+
+///
+/// Copy a vertical run of packed pixels into a column
+///
+/// @param int x: Column
+/// @param int y: First row
+/// @param int count: Number of pixels
+/// @param uint32_t* texels: Packed 0xAARRGGBB source pixels, top to bottom
+///
+/// @return void
+///
+inline void PBO::writeColumn(int x, int y, int count, const uint32_t* texels) {
+    PBO_CHECK_RANGE(x, y, 1, count);
+    if (this->column_major) {
+        memcpy(&this->pixels()[index(x, y)], texels, count * sizeof(uint32_t));
+        return;
+    }
+    uint32_t* dst = &this->pixels()[index(x, y)];
+    for (int i = 0; i < count; i++, dst += this->width) {
+        *dst = texels[i];
+    }
+}
+
+///
+/// Set a horizontal run of pixels to one colour
+///
+/// @param int x: First column
+/// @param int y: Row
+/// @param int count: Number of pixels
+/// @param uint32_t texel: Packed 0xAARRGGBB colour
+///
+/// @return void
+///
+inline void PBO::fill(int x, int y, int count, uint32_t texel) {
+    PBO_CHECK_RANGE(x, y, count, 1);
+    uint32_t* dst = &this->pixels()[index(x, y)];
+    if (this->column_major) {
+        for (int i = 0; i < count; i++, dst += this->height) {
+            *dst = texel;
+        }
+        return;
+    }
+    std::fill(dst, dst + count, texel);
+}
+
+///
+/// Render frames as palette indices, expanded to colour by resolve(). Storage is
+/// allocated for the display size
+///
+/// @param uint32_t* colours: PALETTE_SIZE packed 0xAARRGGBB colours, kept by pointer.
+///                           nullptr goes back to rendering packed pixels
+///
+/// @return void
+///
+void PBO::setPalette(const uint32_t* colours) {
+    this->palette = colours;
+    this->indexed.assign(colours != nullptr ? this->display_width * this->display_height : 0, PALETTE_TRANSPARENT);
+}
+
+///
+/// Write a single palette index, indexed frames only
+///
+/// @param int x: Column
+/// @param int y: Row
+/// @param uint8_t palette_index: Palette index
+///
+/// @return void
+///
+inline void PBO::writeIndexed(int x, int y, uint8_t palette_index) {
+    PBO_CHECK_RANGE(x, y, 1, 1);
+    this->indexed[index(x, y)] = palette_index;
+}
+
+///
+/// Copy a vertical run of palette indices into a column, indexed frames only
+///
+/// @param int x: Column
+/// @param int y: First row
+/// @param int count: Number of pixels
+/// @param uint8_t* indices: Palette indices, top to bottom
+///
+/// @return void
+///
+inline void PBO::writeIndexedColumn(int x, int y, int count, const uint8_t* indices) {
+    PBO_CHECK_RANGE(x, y, 1, count);
+    uint8_t* dst = &this->indexed[index(x, y)];
+    if (this->column_major) {
+        memcpy(dst, indices, count);
+        return;
+    }
+    for (int i = 0; i < count; i++, dst += this->width) {
+        *dst = indices[i];
     }
-    this->buffer[3 * idx + 0] = colour.r;
-    this->buffer[3 * idx + 1] = colour.g;
-    this->buffer[3 * idx + 2] = colour.b;
+}
+
+///
+/// Raw access to a row of palette indices, row major indexed frames only
+///
+/// @param int y: Row
+///
+/// @return uint8_t*: First index of the row
+///
+inline uint8_t* PBO::indexedRow(int y) {
+    PBO_CHECK_RANGE(0, y, this->width, 1);
+    return &this->indexed[y * this->width];
+}
+
+///
+/// Raw access to a column of palette indices, column major indexed frames only
+///
+/// @param int x: Column
+///
+/// @return uint8_t*: First index of the column
+///
+inline uint8_t* PBO::indexedColumn(int x) {
+    PBO_CHECK_RANGE(x, 0, 1, this->height);
+    return &this->indexed[x * this->height];
+}
+
+///
+/// Raw access to a row for kernels that write most of it, row major only
+///
+/// @param int y: Row
+///
+/// @return uint32_t*: First pixel of the row
+///
+inline uint32_t* PBO::row(int y) {
+    PBO_CHECK_RANGE(0, y, this->width, 1);
+    return &this->pixels()[y * this->width];
+}
+
+///
+/// Raw access to a column for kernels that write most of it, column major only
+///
+/// @param int x: Column
+///
+/// @return uint32_t*: First pixel of the column
+///
+inline uint32_t* PBO::column(int x) {
+    PBO_CHECK_RANGE(x, 0, 1, this->height);
+    return &this->pixels()[x * this->height];
+}
+
+inline bool PBO::isColumnMajor() const {
+    return this->column_major;
+}
+
+inline bool PBO::isStreaming() const {
+    return this->stream_count > 0;
+}
+
+inline bool PBO::isIndexed() const {
+    return this->palette != nullptr;
+}
+
+///
+/// Memory the writers render into, the mapped unpack buffer while streaming a row major frame
+///
+/// @return uint32_t*: First pixel of the frame
+///
+inline uint32_t* PBO::pixels() {
+    return this->mapped != nullptr && !this->column_major ? this->mapped : this->buffer.data();
+}
+
+inline int PBO::index(int x, int y) const {
+    return this->column_major ? x * this->height + y : y * this->width + x;
 }
 
 inline void PBO::resize(int newWidth, int newHeight) {
+    if (this->mapped != nullptr) {
+        GLExt::bindBuffer(GL_PIXEL_UNPACK_BUFFER, this->stream_ids[this->stream_index]);
+        GLExt::unmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        GLExt::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        this->mapped = nullptr;
+    }
     this->width = newWidth;
     this->height = newHeight;
-    this->buffer.resize(newWidth * newHeight * 3);
-    debugContext.logApiInfo("Resized PBO to " + to_string(newWidth * newHeight * 3) + " [" + to_string(newWidth) + "*" + to_string(newHeight) + "*3" + "]");
+    this->display_width = newWidth;
+    this->display_height = newHeight;
+    this->buffer.resize(newWidth * newHeight);
+    if (this->column_major) {
+        this->resolved.resize(newWidth * newHeight);
+    }
+    if (this->palette != nullptr) {
+        this->indexed.resize(newWidth * newHeight);
+    }
+    if (this->gl_ready) {
+        allocate();
+    } else {
+        uploadQuad();
+    }
+    debugContext.logApiInfo("Resized PBO to " + to_string(newWidth * newHeight * 4) + " [" + to_string(newWidth) + "*" + to_string(newHeight) + "*4" + "]");
+}
+
+///
+/// Render frames at a size up to the display size, reusing the storage already
+/// allocated. Only the quad's texture coordinates change, nothing is reallocated
+///
+/// @param int newWidth: Pixels, at most the display width
+/// @param int newHeight: Pixels, at most the display height
+///
+/// @return bool: False, and nothing changed, if the size is larger than the display size
+///
+inline bool PBO::setRenderSize(int newWidth, int newHeight) {
+    if (newWidth > this->display_width || newHeight > this->display_height) {
+        return false;
+    }
+    if (this->mapped != nullptr) {
+        GLExt::bindBuffer(GL_PIXEL_UNPACK_BUFFER, this->stream_ids[this->stream_index]);
+        GLExt::unmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        GLExt::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        this->mapped = nullptr;
+    }
+    this->width = newWidth;
+    this->height = newHeight;
+    uploadQuad();
+    return true;
 }
 
 inline void PBO::clear() {
@@ -112,7 +674,22 @@ inline void PBO::clear() {
 }
 
 inline void PBO::blankOut() {
-    fill(this->buffer.begin(), this->buffer.end(), 0);
+    if (this->palette != nullptr) {
+        std::fill(this->indexed.begin(), this->indexed.begin() + this->width * this->height, PALETTE_TRANSPARENT);
+        return;
+    }
+    uint32_t* dst = this->pixels();
+    std::fill(dst, dst + this->width * this->height, 0);
+}
+
+///
+/// Row major pixels, for column major buffers this is the copy made by the last
+/// resolve(). Streamed frames only live in GL memory so this is stale while streaming
+///
+/// @return uint32_t*: First pixel of the frame
+///
+inline const uint32_t* PBO::data() const {
+    return this->column_major ? this->resolved.data() : this->buffer.data();
 }
 
 }
\ No newline at end of file
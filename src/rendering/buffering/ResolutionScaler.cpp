@@ -0,0 +1,128 @@
+#pragma once
+
+#include <math.h>
+
+#include <algorithm>
+
+using namespace std;
+
+namespace Rendering {
+
+// Weight of the newest frame in the smoothed frame time
+#define RESOLUTION_SMOOTHING 0.1
+// Share of the frame budget a new scale aims for, leaves room for frames heavier than the average
+#define RESOLUTION_TARGET 0.9
+// Only scale back up while frames take less than this share of the budget
+#define RESOLUTION_HEADROOM 0.75
+// Frames to wait after a change before judging the new scale
+#define RESOLUTION_SETTLE_FRAMES 15
+// Scales are rounded to multiples of this, so noise doesn't resize every few frames
+#define RESOLUTION_SCALE_STEP 0.0625
+
+///
+/// Picks the share of the window's resolution to render at from measured frame
+/// times. The frame time is smoothed, and while it is over budget, or well under
+/// it, the scale is moved to where the budget should just be met. Frame cost goes
+/// with the pixel count, the square of the scale, so a frame twice over budget is
+/// rendered at 0.71 of the resolution. The scale stays between a minimum and a
+/// maximum of at most 1
+///
+class ResolutionScaler {
+    public:
+        ResolutionScaler();
+        ResolutionScaler(int refresh_rate, double min_scale, double max_scale);
+
+        bool update(double frame_ms);
+        void renderSize(int window_width, int window_height, int& width, int& height) const;
+        inline bool enabled() const;
+
+        // Share of the window's width and height rendered
+        double scale;
+        double min_scale;
+        double max_scale;
+        // Milliseconds per frame at the refresh rate
+        double budget_ms;
+        double smoothed_ms;
+    private:
+        int frames_since_change;
+};
+
+ResolutionScaler::ResolutionScaler():
+    scale(1),
+    min_scale(1),
+    max_scale(1),
+    budget_ms(0),
+    smoothed_ms(0),
+    frames_since_change(0)
+{};
+
+///
+/// @param int refresh_rate: Frames per second to keep up with, 0 keeps the scale at its maximum
+/// @param double min_scale: Smallest share of the window's width and height to render
+/// @param double max_scale: Largest share of the window's width and height to render, at most 1
+///
+ResolutionScaler::ResolutionScaler(int refresh_rate, double min_scale, double max_scale):
+    ResolutionScaler()
+{
+    this->max_scale = min(max(max_scale, RESOLUTION_SCALE_STEP), 1.0);
+    this->min_scale = min(max(min_scale, RESOLUTION_SCALE_STEP), this->max_scale);
+    this->scale = this->max_scale;
+    this->budget_ms = refresh_rate > 0 ? 1000.0 / refresh_rate : 0;
+};
+
+///
+/// Feed in the time the last frame took to render
+///
+/// @param double frame_ms: Milliseconds spent rendering the frame, not waiting on the display
+///
+/// @return bool: True if the scale changed and the render size should be updated
+///
+bool ResolutionScaler::update(double frame_ms) {
+    if (!this->enabled()) {
+        return false;
+    }
+    this->smoothed_ms = this->smoothed_ms == 0
+        ? frame_ms
+        : this->smoothed_ms + RESOLUTION_SMOOTHING * (frame_ms - this->smoothed_ms);
+    if (++this->frames_since_change < RESOLUTION_SETTLE_FRAMES) {
+        return false;
+    }
+    if (this->smoothed_ms <= this->budget_ms && this->smoothed_ms >= this->budget_ms * RESOLUTION_HEADROOM) {
+        return false;
+    }
+
+    double target = this->scale * sqrt(this->budget_ms * RESOLUTION_TARGET / max(this->smoothed_ms, 1e-3));
+    target = round(target / RESOLUTION_SCALE_STEP) * RESOLUTION_SCALE_STEP;
+    target = min(max(target, this->min_scale), this->max_scale);
+    if (target == this->scale) {
+        return false;
+    }
+    // Expect the new scale's cost rather than waiting for the average to catch up
+    this->smoothed_ms *= (target * target) / (this->scale * this->scale);
+    this->scale = target;
+    this->frames_since_change = 0;
+    return true;
+};
+
+///
+/// Size to render at for a window at the current scale
+///
+/// @param int window_width: Pixels
+/// @param int window_height: Pixels
+/// @param int& width: Set to the render width, at least 1
+/// @param int& height: Set to the render height, at least 1
+///
+/// @return void
+///
+void ResolutionScaler::renderSize(int window_width, int window_height, int& width, int& height) const {
+    width = min(max((int) round(window_width * this->scale), 1), window_width);
+    height = min(max((int) round(window_height * this->scale), 1), window_height);
+};
+
+///
+/// @return bool: False if the scale is fixed, no refresh rate or no range to move in
+///
+inline bool ResolutionScaler::enabled() const {
+    return this->budget_ms > 0 && this->min_scale < this->max_scale;
+}
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+    #define TRANSPOSE_SSE2 1
+#endif
+
+using namespace std;
+
+namespace Rendering {
+
+// Edge of the square tiles the transpose works through, 32*32*4 bytes keeps
+// both the source and destination tile resident in L1
+#define TRANSPOSE_BLOCK 32
+
+///
+/// Transpose a 4x4 tile of 32-bit pixels
+///
+/// @param uint32_t* src: Top left of the source tile
+/// @param int src_stride: Pixels between source rows
+/// @param uint32_t* dst: Top left of the destination tile
+/// @param int dst_stride: Pixels between destination rows
+///
+/// @return void
+///
+inline void transpose4x4(const uint32_t* src, int src_stride, uint32_t* dst, int dst_stride) {
+#ifdef TRANSPOSE_SSE2
+    __m128i r0 = _mm_loadu_si128((const __m128i*) (src));
+    __m128i r1 = _mm_loadu_si128((const __m128i*) (src + src_stride));
+    __m128i r2 = _mm_loadu_si128((const __m128i*) (src + 2 * src_stride));
+    __m128i r3 = _mm_loadu_si128((const __m128i*) (src + 3 * src_stride));
+
+    __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+    __m128i t1 = _mm_unpacklo_epi32(r2, r3);
+    __m128i t2 = _mm_unpackhi_epi32(r0, r1);
+    __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+
+    _mm_storeu_si128((__m128i*) (dst), _mm_unpacklo_epi64(t0, t1));
+    _mm_storeu_si128((__m128i*) (dst + dst_stride), _mm_unpackhi_epi64(t0, t1));
+    _mm_storeu_si128((__m128i*) (dst + 2 * dst_stride), _mm_unpacklo_epi64(t2, t3));
+    _mm_storeu_si128((__m128i*) (dst + 3 * dst_stride), _mm_unpackhi_epi64(t2, t3));
+#else
+    for (int r = 0; r < 4; r++) {
+        for (int c = 0; c < 4; c++) {
+            dst[c * dst_stride + r] = src[r * src_stride + c];
+        }
+    }
+#endif
+}
+
+///
+/// Cache blocked transpose of a rows*cols matrix of 32-bit pixels,
+/// such that dst[c * rows + r] = src[r * cols + c]
+///
+/// @param uint32_t* src: Source matrix, rows*cols pixels
+/// @param uint32_t* dst: Destination matrix, cols*rows pixels, must not alias src
+/// @param int rows: Source rows
+/// @param int cols: Source columns
+///
+/// @return void
+///
+inline void transposeBlocked(const uint32_t* src, uint32_t* dst, int rows, int cols) {
+    for (int row_block = 0; row_block < rows; row_block += TRANSPOSE_BLOCK) {
+        int row_end = min(rows, row_block + TRANSPOSE_BLOCK);
+        for (int col_block = 0; col_block < cols; col_block += TRANSPOSE_BLOCK) {
+            int col_end = min(cols, col_block + TRANSPOSE_BLOCK);
+            int r = row_block;
+            for (; r + 4 <= row_end; r += 4) {
+                int c = col_block;
+                for (; c + 4 <= col_end; c += 4) {
+                    transpose4x4(src + r * cols + c, cols, dst + c * rows + r, rows);
+                }
+                for (; c < col_end; c++) {
+                    for (int i = 0; i < 4; i++) {
+                        dst[c * rows + r + i] = src[(r + i) * cols + c];
+                    }
+                }
+            }
+            for (; r < row_end; r++) {
+                for (int c = col_block; c < col_end; c++) {
+                    dst[c * rows + r] = src[r * cols + c];
+                }
+            }
+        }
+    }
+}
+}
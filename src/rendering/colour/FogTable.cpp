@@ -0,0 +1,119 @@
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+namespace Rendering {
+
+// Distance resolution of the fog table
+#define FOG_STEPS_PER_CELL 16
+// Weight at which a pixel is entirely fog
+#define FOG_WEIGHT_MAX 256
+
+///
+/// Distance fog as a lookup table of blend weights, ramping linearly from
+/// nothing at the fog start to solid fog colour at the render distance
+///
+class FogTable {
+    public:
+        FogTable();
+        FogTable(double start, double end, uint32_t colour);
+
+        inline bool enabled() const;
+        inline uint32_t weight(double distance) const;
+        inline uint32_t blend(uint32_t texel, uint32_t weight) const;
+        inline void blendSpan(uint32_t* pixels, int count, uint32_t weight) const;
+
+        // Packed 0xAARRGGBB
+        uint32_t colour;
+        // Render distance, 0 if unbounded
+        double end;
+    private:
+        vector<uint16_t> weights;
+};
+
+FogTable::FogTable():
+    colour(0xFF000000),
+    end(0)
+{};
+
+///
+/// @param double start: Distance fog starts at, in cells
+/// @param double end: Render distance in cells, 0 for no fog or cutoff
+/// @param uint32_t colour: Packed 0xAARRGGBB fog colour
+///
+FogTable::FogTable(double start, double end, uint32_t colour):
+    colour(colour),
+    end(end)
+{
+    if (end <= 0) {
+        return;
+    }
+    start = max(0.0, min(start, end));
+    this->weights.resize((size_t) ceil(end * FOG_STEPS_PER_CELL));
+    for (size_t i = 0; i < this->weights.size(); i++) {
+        double distance = double(i) / FOG_STEPS_PER_CELL;
+        double t = distance <= start ? 0.0 : (distance - start) / (end - start);
+        this->weights[i] = (uint16_t) min((double) FOG_WEIGHT_MAX, floor(t * FOG_WEIGHT_MAX + 0.5));
+    }
+};
+
+inline bool FogTable::enabled() const {
+    return this->end > 0;
+}
+
+///
+/// @param double distance: Perpendicular distance in cells
+///
+/// @return uint32_t: Blend weight, 0 for none up to FOG_WEIGHT_MAX for solid fog
+///
+inline uint32_t FogTable::weight(double distance) const {
+    if (!enabled()) {
+        return 0;
+    }
+    size_t idx = (size_t) (max(0.0, distance) * FOG_STEPS_PER_CELL);
+    return idx < this->weights.size() ? this->weights[idx] : FOG_WEIGHT_MAX;
+}
+
+///
+/// Blend a texel toward the fog colour, red and blue are blended together in one multiply
+///
+/// @param uint32_t texel: Packed 0xAARRGGBB
+/// @param uint32_t weight: Blend weight from weight()
+///
+/// @return uint32_t: Packed 0xAARRGGBB, alpha of the texel
+///
+inline uint32_t FogTable::blend(uint32_t texel, uint32_t weight) const {
+    uint32_t keep = FOG_WEIGHT_MAX - weight;
+    uint32_t rb = ((texel & 0xFF00FF) * keep + (this->colour & 0xFF00FF) * weight) >> 8;
+    uint32_t g = ((texel & 0xFF00) * keep + (this->colour & 0xFF00) * weight) >> 8;
+    return (texel & 0xFF000000) | (rb & 0xFF00FF) | (g & 0xFF00);
+}
+
+///
+/// Blend a run of pixels at one distance toward the fog colour
+///
+/// @param uint32_t* pixels: Packed 0xAARRGGBB pixels, blended in place
+/// @param int count: Number of pixels
+/// @param uint32_t weight: Blend weight from weight()
+///
+/// @return void
+///
+inline void FogTable::blendSpan(uint32_t* pixels, int count, uint32_t weight) const {
+    if (weight == 0) {
+        return;
+    }
+    if (weight >= FOG_WEIGHT_MAX) {
+        fill(pixels, pixels + count, this->colour);
+        return;
+    }
+    for (int i = 0; i < count; i++) {
+        pixels[i] = blend(pixels[i], weight);
+    }
+}
+}
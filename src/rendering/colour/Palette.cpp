@@ -0,0 +1,376 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include "FogTable.cpp"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__)) && !defined(PALETTE_EXPAND_SCALAR)
+    #include <immintrin.h>
+    #define PALETTE_EXPAND_X86 1
+#endif
+
+using namespace std;
+
+namespace Rendering {
+
+#define PALETTE_SIZE 256
+// Black, never picked for a texel that isn't black, so sprites can keep treating it as transparent
+#define PALETTE_TRANSPARENT 0
+// Fog weights are rounded to this many colormaps, from clear to solid fog
+#define PALETTE_LIGHT_LEVELS 32
+// Colormap sets, unshaded and the dark shade of wall sides, floors and ceilings
+#define PALETTE_SHADES 2
+#define PALETTE_SHADE_DARK 1
+
+///
+/// Range of colours in the median cut, with the channel it spans widest
+///
+struct PaletteBox {
+    size_t first;
+    size_t last;
+    // Shift of the widest channel in a packed colour, and its range
+    int shift;
+    int range;
+
+    PaletteBox(const vector<pair<uint32_t, uint32_t> >& colours, size_t first, size_t last):
+        first(first),
+        last(last),
+        shift(16),
+        range(0)
+    {
+        for (int channel_shift = 16; channel_shift >= 0; channel_shift -= 8) {
+            int lo = 255, hi = 0;
+            for (size_t i = first; i < last; i++) {
+                int value = (colours[i].first >> channel_shift) & 0xFF;
+                lo = min(lo, value);
+                hi = max(hi, value);
+            }
+            if (hi - lo > this->range) {
+                this->shift = channel_shift;
+                this->range = hi - lo;
+            }
+        }
+    };
+};
+
+///
+/// Shared 256 colour palette for rendering 8 bit indices instead of packed texels.
+/// Colours are picked by median cut over every texel of the atlas and its dark
+/// shade, weighted by how often they appear.
+///
+/// Shading is done through colormaps, as Doom does: for every shade and fog level
+/// a 256 entry table mapping each index to the index nearest the shaded, fogged
+/// colour. Renderers look a colormap up once per column or row and then shade
+/// with one byte load per pixel, the frame is expanded to colour once when presented
+///
+class Palette {
+    public:
+        Palette();
+
+        void build(const uint32_t* texels, size_t count, uint32_t fog_colour);
+        void buildColormaps(const FogTable& fog);
+        uint8_t quantize(uint32_t colour, bool allow_transparent = false) const;
+        void quantize(const uint32_t* texels, size_t count, uint8_t* out) const;
+
+        inline const uint8_t* colormap(uint32_t shade, uint32_t fog_weight) const;
+        inline const uint32_t* colours() const;
+        inline uint8_t fogIndex() const;
+        int size() const;
+    private:
+        static inline uint32_t shadeColour(uint32_t colour, uint32_t shade);
+        static inline uint32_t distance(uint32_t a, uint32_t b);
+
+        // Packed 0xAARRGGBB, opaque, unused entries are black
+        vector<uint32_t> entries;
+        int used;
+        uint8_t fog_index;
+        // PALETTE_SHADES * PALETTE_LIGHT_LEVELS tables of PALETTE_SIZE indices
+        vector<uint8_t> colormaps;
+};
+
+Palette::Palette():
+    entries(PALETTE_SIZE, 0xFF000000),
+    used(1),
+    fog_index(PALETTE_TRANSPARENT),
+    colormaps(PALETTE_SHADES * PALETTE_LIGHT_LEVELS * PALETTE_SIZE, PALETTE_TRANSPARENT)
+{};
+
+///
+/// @param uint32_t colour: Packed 0x..RRGGBB
+/// @param uint32_t shade: 0 for none or PALETTE_SHADE_DARK, which halves every channel as the true colour kernels do
+///
+/// @return uint32_t: Packed 0x00RRGGBB
+///
+inline uint32_t Palette::shadeColour(uint32_t colour, uint32_t shade) {
+    return shade == PALETTE_SHADE_DARK ? (colour >> 1) & 0x7F7F7F : colour & 0xFFFFFF;
+}
+
+///
+/// Squared distance between two colours, green weighted most and blue least
+///
+inline uint32_t Palette::distance(uint32_t a, uint32_t b) {
+    int dr = (int) ((a >> 16) & 0xFF) - (int) ((b >> 16) & 0xFF);
+    int dg = (int) ((a >> 8) & 0xFF) - (int) ((b >> 8) & 0xFF);
+    int db = (int) (a & 0xFF) - (int) (b & 0xFF);
+    return (uint32_t) (2 * dr * dr + 4 * dg * dg + 3 * db * db);
+}
+
+///
+/// Pick the palette for a set of texels. Index 0 is black and the fog colour
+/// has an entry of its own, the rest are split by median cut
+///
+/// @param uint32_t* texels: Packed 0xAARRGGBB texels, alpha is ignored
+/// @param size_t count: Number of texels
+/// @param uint32_t fog_colour: Packed 0x..RRGGBB colour solid fog is drawn in
+///
+/// @return void
+///
+void Palette::build(const uint32_t* texels, size_t count, uint32_t fog_colour) {
+    fill(this->entries.begin(), this->entries.end(), 0xFF000000);
+    this->used = 1;
+    fog_colour &= 0xFFFFFF;
+    if (fog_colour != 0) {
+        this->entries[this->used++] = 0xFF000000 | fog_colour;
+    }
+
+    // Every texel is drawn both unshaded and dark, so both count toward the palette
+    unordered_map<uint32_t, uint32_t> histogram;
+    for (size_t i = 0; i < count; i++) {
+        for (uint32_t shade = 0; shade < PALETTE_SHADES; shade++) {
+            uint32_t colour = shadeColour(texels[i], shade);
+            if (colour != 0 && colour != fog_colour) {
+                histogram[colour]++;
+            }
+        }
+    }
+    vector<pair<uint32_t, uint32_t> > colours(histogram.begin(), histogram.end());
+    // Hash order differs between standard libraries, sorting keeps the palette the same everywhere
+    sort(colours.begin(), colours.end());
+    size_t available = PALETTE_SIZE - this->used;
+
+    // Boxes are ranges of colours, the box with the widest channel is split at its weighted median until the palette is full
+    vector<PaletteBox> boxes;
+    if (!colours.empty()) {
+        boxes.push_back(PaletteBox(colours, 0, colours.size()));
+    }
+    while (boxes.size() < available) {
+        size_t widest = 0;
+        for (size_t b = 1; b < boxes.size(); b++) {
+            if (boxes[b].range > boxes[widest].range) {
+                widest = b;
+            }
+        }
+        if (boxes.empty() || boxes[widest].range == 0) {
+            // Every box is down to one colour
+            break;
+        }
+        PaletteBox box = boxes[widest];
+        int shift = box.shift;
+        sort(colours.begin() + box.first, colours.begin() + box.last,
+            [shift](const pair<uint32_t, uint32_t>& a, const pair<uint32_t, uint32_t>& b) {
+                return ((a.first >> shift) & 0xFF) < ((b.first >> shift) & 0xFF);
+            });
+        uint64_t total = 0, below = 0;
+        for (size_t i = box.first; i < box.last; i++) {
+            total += colours[i].second;
+        }
+        size_t split = box.first + 1;
+        for (size_t i = box.first; i < box.last - 1; i++) {
+            below += colours[i].second;
+            split = i + 1;
+            if (2 * below >= total) {
+                break;
+            }
+        }
+        boxes[widest] = PaletteBox(colours, box.first, split);
+        boxes.push_back(PaletteBox(colours, split, box.last));
+    }
+
+    for (const PaletteBox& box : boxes) {
+        uint64_t r = 0, g = 0, b = 0, weight = 0;
+        for (size_t i = box.first; i < box.last; i++) {
+            uint32_t colour = colours[i].first;
+            uint64_t n = colours[i].second;
+            r += ((colour >> 16) & 0xFF) * n;
+            g += ((colour >> 8) & 0xFF) * n;
+            b += (colour & 0xFF) * n;
+            weight += n;
+        }
+        this->entries[this->used++] = 0xFF000000
+            | (uint32_t) ((r + weight / 2) / weight) << 16
+            | (uint32_t) ((g + weight / 2) / weight) << 8
+            | (uint32_t) ((b + weight / 2) / weight);
+    }
+    this->fog_index = quantize(fog_colour, true);
+}
+
+///
+/// Build the colormaps for every shade and fog level. The palette must be built first
+///
+/// @param FogTable fog: Fog the levels blend toward
+///
+/// @return void
+///
+void Palette::buildColormaps(const FogTable& fog) {
+    for (uint32_t shade = 0; shade < PALETTE_SHADES; shade++) {
+        for (uint32_t level = 0; level < PALETTE_LIGHT_LEVELS; level++) {
+            uint32_t weight = level * FOG_WEIGHT_MAX / (PALETTE_LIGHT_LEVELS - 1);
+            uint8_t* colormap = &this->colormaps[(shade * PALETTE_LIGHT_LEVELS + level) * PALETTE_SIZE];
+            for (int i = 0; i < PALETTE_SIZE; i++) {
+                colormap[i] = quantize(fog.blend(shadeColour(this->entries[i], shade), weight), true);
+            }
+        }
+    }
+}
+
+///
+/// Nearest palette entry to a colour. Only black itself maps to the transparent
+/// index, unless allowed, so shading a texel never makes it transparent
+///
+/// @param uint32_t colour: Packed 0x..RRGGBB
+/// @param bool allow_transparent: Consider index 0 for colours other than black
+///
+/// @return uint8_t: Palette index
+///
+uint8_t Palette::quantize(uint32_t colour, bool allow_transparent) const {
+    colour &= 0xFFFFFF;
+    if (colour == 0) {
+        return PALETTE_TRANSPARENT;
+    }
+    int best = allow_transparent || this->used == 1 ? 0 : 1;
+    uint32_t best_distance = distance(colour, this->entries[best]);
+    for (int i = best + 1; i < this->used && best_distance > 0; i++) {
+        uint32_t d = distance(colour, this->entries[i]);
+        if (d < best_distance) {
+            best = i;
+            best_distance = d;
+        }
+    }
+    return (uint8_t) best;
+}
+
+///
+/// Quantize a run of texels, each distinct colour is only searched for once
+///
+/// @param uint32_t* texels: Packed 0xAARRGGBB texels
+/// @param size_t count: Number of texels
+/// @param uint8_t* out: Palette indices, count of them
+///
+/// @return void
+///
+void Palette::quantize(const uint32_t* texels, size_t count, uint8_t* out) const {
+    unordered_map<uint32_t, uint8_t> found;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t colour = texels[i] & 0xFFFFFF;
+        unordered_map<uint32_t, uint8_t>::const_iterator it = found.find(colour);
+        out[i] = it != found.end() ? it->second : (found[colour] = quantize(colour));
+    }
+}
+
+///
+/// @param uint32_t shade: 0 for none or PALETTE_SHADE_DARK
+/// @param uint32_t fog_weight: Blend weight from FogTable::weight()
+///
+/// @return uint8_t*: PALETTE_SIZE indices, the shaded and fogged index of each
+///
+inline const uint8_t* Palette::colormap(uint32_t shade, uint32_t fog_weight) const {
+    uint32_t level = (min(fog_weight, (uint32_t) FOG_WEIGHT_MAX) * (PALETTE_LIGHT_LEVELS - 1) + FOG_WEIGHT_MAX / 2) / FOG_WEIGHT_MAX;
+    return &this->colormaps[(shade * PALETTE_LIGHT_LEVELS + level) * PALETTE_SIZE];
+}
+
+///
+/// @return uint32_t*: PALETTE_SIZE packed 0xAARRGGBB colours
+///
+inline const uint32_t* Palette::colours() const {
+    return this->entries.data();
+}
+
+///
+/// @return uint8_t: Index nearest the fog colour, drawn for solid fog
+///
+inline uint8_t Palette::fogIndex() const {
+    return this->fog_index;
+}
+
+///
+/// @return int: Entries in use, including black
+///
+int Palette::size() const {
+    return this->used;
+}
+
+///
+/// Reference palette expand, one pixel at a time
+///
+/// @param uint8_t* indices: Palette indices
+/// @param uint32_t* out: Packed 0xAARRGGBB pixels, count of them
+/// @param size_t count: Pixels to expand
+/// @param uint32_t* colours: PALETTE_SIZE packed colours
+///
+/// @return void
+///
+inline void expandPaletteScalar(const uint8_t* indices, uint32_t* out, size_t count, const uint32_t* colours) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = colours[indices[i]];
+    }
+}
+
+#ifdef PALETTE_EXPAND_X86
+///
+/// AVX2 palette expand, 8 indices are widened to 32 bits and looked up with one gather
+///
+/// @param uint8_t* indices: Palette indices
+/// @param uint32_t* out: Packed 0xAARRGGBB pixels, count of them
+/// @param size_t count: Pixels to expand
+/// @param uint32_t* colours: PALETTE_SIZE packed colours
+///
+/// @return void
+///
+__attribute__((target("avx2")))
+inline void expandPaletteAVX2(const uint8_t* indices, uint32_t* out, size_t count, const uint32_t* colours) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i index = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*) (indices + i)));
+        _mm256_storeu_si256((__m256i*) (out + i), _mm256_i32gather_epi32((const int*) colours, index, 4));
+    }
+    expandPaletteScalar(indices + i, out + i, count - i, colours);
+}
+#endif
+
+typedef void (*PaletteExpander)(const uint8_t* indices, uint32_t* out, size_t count, const uint32_t* colours);
+
+///
+/// Pick the widest expand the CPU supports, build with PALETTE_EXPAND_SCALAR
+/// defined to force the reference one
+///
+/// @return PaletteExpander
+///
+inline PaletteExpander selectPaletteExpander() {
+#ifdef PALETTE_EXPAND_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return expandPaletteAVX2;
+    }
+#endif
+    return expandPaletteScalar;
+}
+
+///
+/// Expand palette indices to packed colour with the best expand for this CPU
+///
+/// @param uint8_t* indices: Palette indices
+/// @param uint32_t* out: Packed 0xAARRGGBB pixels, count of them
+/// @param size_t count: Pixels to expand
+/// @param uint32_t* colours: PALETTE_SIZE packed colours
+///
+/// @return void
+///
+inline void expandPalette(const uint8_t* indices, uint32_t* out, size_t count, const uint32_t* colours) {
+    static const PaletteExpander expander = selectPaletteExpander();
+    expander(indices, out, count, colours);
+}
+}
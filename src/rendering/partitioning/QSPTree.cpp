@@ -1,18 +1,47 @@
 #pragma once
 
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
 #include <cmath>
-#include <stack>
+#include <algorithm>
+#include <limits>
+#include <string>
 #include <vector>
 
+#if _WIN64 || _WIN32
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
 #include "../../environment/constructs/walls/AABB.cpp"
 #include "../../environment/world/Coordinates.hpp"
 #include "../../environment/world/World.cpp"
+#include "../../logic/threading/WorkerPool.cpp"
 #include "../Globals.hpp"
 #include "../raycaster/Ray.hpp"
+#include "../raycaster/DDA.hpp"
 #include "QuadNode.cpp"
 
 using namespace std;
 
+// Stands in for 1 / 0 on axis aligned rays, large enough to act as infinity without producing NaNs
+#define QSP_INV_ZERO_DIR 1e300
+// Pivots nearest the median of a node's walls whose split cost is compared
+#define QSP_PIVOT_CANDIDATES 4
+// Depth at which subtrees are handed out to the workers of a pool, 4^depth of them
+#define QSP_PARALLEL_DEPTH 2
+// Subtrees with fewer walls than this are not worth a hand off
+#define QSP_PARALLEL_MIN_WALLS 4096
+// Saved trees sit next to their map with this extension in place of the map's
+#define QSP_FILE_EXTENSION ".qsp"
+#define QSP_FILE_MAGIC "QSPT"
+// Bump whenever QuadNode, the header or the way trees are built change
+#define QSP_FILE_VERSION 2
+
 enum RelativePosition : size_t {
     REL_UP = 0,
     REL_DOWN = 1,
@@ -20,235 +49,889 @@ enum RelativePosition : size_t {
     REL_RIGHT = 3
 };
 
-struct TraversalRecord {
-    TraversalRecord(QuadNode* node, vector<RelativePosition> vec) {
-        this->node = node;
-        this->traversals = vec;
-    };
-    QuadNode* node;
-    vector<RelativePosition> traversals;
+///
+/// Header of a saved tree, the nodes follow it in breadth first order.
+/// Written in host byte order, a blob is only meant for the machine that built it
+///
+struct QSPFileHeader {
+    char magic[4];
+    uint32_t version;
+    int32_t map_width;
+    int32_t map_height;
+    // Hash of which cells are solid, a tree is stale once the walls move
+    uint64_t map_hash;
+    uint64_t node_count;
 };
 
+static_assert(sizeof(QSPFileHeader) == 32, "QSPFileHeader is written to disk as is, keep it packed");
+
+///
+/// Quadrant tree over the solid cells of a map. Bulk loaded top down, each node
+/// splits its walls into four quadrants around the pivot wall near their median
+/// that gives the cheapest split, then the tree is laid out breadth first in one
+/// array, so the upper levels every query walks share a few cache lines and the
+/// whole tree is freed, saved or memory mapped in one go
+///
 class QSPTree {
     public:
+        // Per ray terms and the traversal stack of a query. Kept by the caller between
+        // queries, one per thread, so repeated queries reuse their storage
+        struct QueryScratch {
+            struct Frame {
+                int32_t node;
+                size_t begin;
+                size_t end;
+            };
+
+            vector<double> inv_x;
+            vector<double> inv_y;
+            vector<double> best;
+            // Rays still in play, each frame's list follows its parent's
+            vector<int> ids;
+            vector<Frame> frames;
+        };
+
         QSPTree();
-        QSPTree(World map, vector<Constructs::AABB>* ordered_walls, vector<Constructs::AABB>* u_bound, vector<Constructs::AABB>* d_bound, vector<Constructs::AABB>* l_bound, vector<Constructs::AABB>* r_bound);
+        QSPTree(const World& map);
+        QSPTree(QSPTree&& other);
+        QSPTree(const QSPTree& other) = delete;
         ~QSPTree();
 
-        void buildTree();
-        QuadNode* insertNode(QuadNode* root, QuadNode* node);
-        inline QuadNode* insertRelative(QuadNode* dir_node, QuadNode* node);
+        QSPTree& operator=(QSPTree&& other);
+        QSPTree& operator=(const QSPTree& other) = delete;
 
-        void queryWalls(Coords origin, float player_angle, vector<Ray>& rays, vector<Coords>& ret_walls);
+        void buildTree(WorkerPool* pool = nullptr);
+        bool save(const string& filename) const;
+        bool load(const string& filename, const World& map);
+        static string pathFor(const string& map_file);
+        static uint64_t hashMap(const World& map);
+        static bool validNodes(const QuadNode* nodes, size_t node_count, int map_width, int map_height);
 
-        void printPreorder(QuadNode* node);
+        void queryWalls(const Rendering::RayBuffer& rays, int first, int last, vector<Rendering::RayHit>& hits,
+            double max_dist = numeric_limits<double>::infinity()) const;
+        void queryWalls(const Rendering::RayBuffer& rays, int first, int last, vector<Rendering::RayHit>& hits,
+            QueryScratch& scratch, double max_dist = numeric_limits<double>::infinity()) const;
+
+        size_t size() const;
+        size_t bytes() const;
+        bool mapped() const;
+        int depth() const;
+        void printPreorder(int node = 0) const;
     private:
-        RelativePosition position(Coords a, Coords b);
-        double sqDist(Coords a, Coords b);
-        void findMiddle();
-        inline void traverseNext(RelativePosition& currBranch, QuadNode* currNode, TraversalRecord& currTraversal, stack<TraversalRecord>& nodesVisited);
+        struct BuildCell {
+            int16_t x;
+            int16_t y;
+            uint32_t wall;
+        };
+        // A subtree left for a worker, its root becomes child slot of parent
+        struct BuildTask {
+            size_t begin;
+            size_t end;
+            int32_t parent;
+            int slot;
+        };
+
+        static RelativePosition position(int pivot_x, int pivot_y, int x, int y);
+        static size_t choosePivot(const vector<BuildCell>& cells, size_t begin, size_t end, vector<int>& scratch);
+        static int32_t bulkLoad(vector<BuildCell>& cells, size_t begin, size_t end, vector<QuadNode>& out,
+            vector<int>& scratch, int depth, vector<BuildTask>* tasks, int32_t parent, int slot);
+        void layoutBreadthFirst();
+        void logStats() const;
+        void release();
 
-        World map;
-        vector<Constructs::AABB>* walls;
-        vector<Constructs::AABB>* up_boundary;
-        vector<Constructs::AABB>* down_boundary;
-        vector<Constructs::AABB>* left_boundary;
-        vector<Constructs::AABB>* right_boundary;
-        Constructs::AABB mid;
-        QuadNode* root;
+        int map_width;
+        int map_height;
+        uint64_t map_hash;
+        // Wall ids (indices into World::walls) to build from
+        vector<uint32_t> walls;
+        // Owns the nodes of a built tree, empty when they are mapped from a file
+        vector<QuadNode> arena;
+        const QuadNode* nodes;
+        size_t node_count;
+        void* mapping;
+        size_t mapping_bytes;
 };
 
-QSPTree::QSPTree(){};
+QSPTree::QSPTree():
+    map_width(0),
+    map_height(0),
+    map_hash(0),
+    nodes(nullptr),
+    node_count(0),
+    mapping(nullptr),
+    mapping_bytes(0)
+{};
+
+///
+/// Collect the solid cells of a map
+///
+/// @param World map: Map to partition, at most 32767 cells a side
+///
+QSPTree::QSPTree(const World& map):
+    map_width(map.map_width),
+    map_height(map.map_height),
+    map_hash(hashMap(map)),
+    nodes(nullptr),
+    node_count(0),
+    mapping(nullptr),
+    mapping_bytes(0)
+{
+    if (map.map_width > INT16_MAX || map.map_height > INT16_MAX) {
+        debugContext.logAppInfo("Map too large to partition: " + to_string(map.map_width) + "*" + to_string(map.map_height));
+        return;
+    }
+    for (int y = 0; y < map.map_height; y++) {
+        for (int x = 0; x < map.map_width; x++) {
+            if (map.getAt(x, y).type != Constructs::WallType::NONE) {
+                this->walls.push_back(y * map.map_width + x);
+            }
+        }
+    }
+};
 
-QSPTree::QSPTree(World map, vector<Constructs::AABB>* ordered_walls, vector<Constructs::AABB>* u_bound, vector<Constructs::AABB>* d_bound, vector<Constructs::AABB>* l_bound, vector<Constructs::AABB>* r_bound) {
-    this->map = map;
-    this->walls = ordered_walls;
-    findMiddle();
-    this->up_boundary = u_bound;
-    this->down_boundary = d_bound;
-    this->left_boundary = l_bound;
-    this->right_boundary = r_bound;
+QSPTree::QSPTree(QSPTree&& other):
+    nodes(nullptr),
+    node_count(0),
+    mapping(nullptr),
+    mapping_bytes(0)
+{
+    *this = move(other);
 };
 
 QSPTree::~QSPTree() {
-    delete root;
+    release();
 };
 
-double QSPTree::sqDist(Coords a, Coords b) {
-    int delta_x = abs(b.x - a.x);
-    int delta_y = abs(b.y - a.y);
-    return (delta_x * delta_x) + (delta_y * delta_y);
+QSPTree& QSPTree::operator=(QSPTree&& other) {
+    if (this != &other) {
+        release();
+        this->map_width = other.map_width;
+        this->map_height = other.map_height;
+        this->map_hash = other.map_hash;
+        this->walls = move(other.walls);
+        this->arena = move(other.arena);
+        this->nodes = other.mapping != nullptr ? other.nodes : this->arena.data();
+        this->node_count = other.node_count;
+        this->mapping = other.mapping;
+        this->mapping_bytes = other.mapping_bytes;
+        other.nodes = nullptr;
+        other.node_count = 0;
+        other.mapping = nullptr;
+        other.mapping_bytes = 0;
+    }
+    return *this;
 };
 
-void QSPTree::findMiddle() {
-    Constructs::AABB current_mid;
-    Coords cMid = Coords((int)floor(map.map_width), (int)floor(map.map_height));
-    double current_min_dist = numeric_limits<double>::max();
-    int current_wall_idx;
-    for (int i = walls->size() - 1; i != -1; i--) {
-        Coords loc = Coords(walls->at(i).location.x, walls->at(i).location.y);
-        int dist = sqDist(cMid, loc);
-        if (dist < current_min_dist) {
-            current_mid = walls->at(i);
-            current_min_dist = dist;
-            current_wall_idx = i;
-        }
+///
+/// Drop the nodes, unmapping them if they came from a file
+///
+/// @return void
+///
+void QSPTree::release() {
+#if _WIN64 || _WIN32
+#else
+    if (this->mapping != nullptr) {
+        munmap(this->mapping, this->mapping_bytes);
     }
-    this->walls->erase(this->walls->begin() + current_wall_idx);
-    this->mid = current_mid;
-    debugContext.logAppInfo("Closest AABB to actuall map centre at: (" + to_string(current_mid.location.x) + "," + to_string(current_mid.location.y) + ")");
-    this->root = new QuadNode(current_mid);
+#endif
+    this->mapping = nullptr;
+    this->mapping_bytes = 0;
+    this->arena.clear();
+    this->nodes = nullptr;
+    this->node_count = 0;
 };
 
-RelativePosition QSPTree::position(Coords a, Coords b) {
-    double angle = atan2(
-        (b.x - a.x) + (b.y - a.y),
-        (b.x - a.x) - (b.y - a.y)
-    );
-    if (0 <= angle && angle < M_PI_2) {
+///
+/// Quadrant of a cell around a pivot, split along the diagonals through the pivot.
+/// In coordinates rotated by 45 degrees the quadrants are [0, 90), [90, 180),
+/// [180, 270) and [270, 360) degrees counted from right
+///
+/// @return RelativePosition
+///
+inline RelativePosition QSPTree::position(int pivot_x, int pivot_y, int x, int y) {
+    int u = (x - pivot_x) + (y - pivot_y);
+    int v = (x - pivot_x) - (y - pivot_y);
+    if (u >= 0 && v > 0) {
         return RelativePosition::REL_RIGHT;
-    } else if (M_PI_2 <= angle && angle < M_PI) {
+    } else if (u > 0 && v <= 0) {
         return RelativePosition::REL_UP;
-    } else if (M_PI <= angle && angle <= THREE_HALF_PI) {
+    } else if (u <= 0 && v < 0) {
         return RelativePosition::REL_LEFT;
     } else {
         return RelativePosition::REL_DOWN;
     }
 };
 
-inline QuadNode* QSPTree::insertRelative(QuadNode* dir_node, QuadNode* node) {
-    if (dir_node == nullptr) {
-        dir_node = node;
-        node->parent = dir_node;
+///
+/// Pick the pivot of a node. The quadrants are split along diagonals, so in
+/// rotated coordinates (x + y, x - y) a pivot at the median of both halves the
+/// walls either way. Of the walls nearest that median the one with the lowest
+/// surface area cost wins: the walls of each quadrant weighted by the perimeter
+/// of their bounds, which is proportional to the chance a ray crosses them
+///
+/// @param vector<BuildCell> cells: Walls of the tree
+/// @param size_t begin: First wall of the node (inclusive)
+/// @param size_t end: Last wall of the node (exclusive)
+/// @param vector<int> scratch: Working space, reused between nodes
+///
+/// @return size_t: Index of the pivot in cells
+///
+size_t QSPTree::choosePivot(const vector<BuildCell>& cells, size_t begin, size_t end, vector<int>& scratch) {
+    size_t count = end - begin;
+    // Any pivot of two walls leaves the other as its only child
+    if (count <= 2) {
+        return begin;
+    }
+    size_t candidates[QSP_PIVOT_CANDIDATES] = {};
+    int candidate_count = 0;
+    if (count <= QSP_PIVOT_CANDIDATES) {
+        for (size_t i = begin; i < end; i++) {
+            candidates[candidate_count++] = i;
+        }
     } else {
-        dir_node = insertNode(dir_node, node);
+        scratch.resize(2 * count);
+        int* us = scratch.data();
+        int* vs = us + count;
+        for (size_t i = 0; i < count; i++) {
+            us[i] = cells[begin + i].x + cells[begin + i].y;
+            vs[i] = cells[begin + i].x - cells[begin + i].y;
+        }
+        nth_element(us, us + count / 2, us + count);
+        nth_element(vs, vs + count / 2, vs + count);
+        int median_u = us[count / 2];
+        int median_v = vs[count / 2];
+
+        // Nearest first, kept sorted by insertion
+        int distances[QSP_PIVOT_CANDIDATES];
+        for (size_t i = begin; i < end; i++) {
+            int distance = max(abs(cells[i].x + cells[i].y - median_u), abs(cells[i].x - cells[i].y - median_v));
+            if (candidate_count == QSP_PIVOT_CANDIDATES && distance >= distances[candidate_count - 1]) {
+                continue;
+            }
+            int slot = min(candidate_count, QSP_PIVOT_CANDIDATES - 1);
+            while (slot > 0 && distances[slot - 1] > distance) {
+                distances[slot] = distances[slot - 1];
+                candidates[slot] = candidates[slot - 1];
+                slot--;
+            }
+            distances[slot] = distance;
+            candidates[slot] = i;
+            candidate_count = min(candidate_count + 1, QSP_PIVOT_CANDIDATES);
+        }
+    }
+
+    size_t best = candidates[0];
+    double best_cost = numeric_limits<double>::infinity();
+    for (int c = 0; c < candidate_count; c++) {
+        const BuildCell& pivot = cells[candidates[c]];
+        int quadrant_count[4] = {0, 0, 0, 0};
+        int min_x[4], min_y[4], max_x[4], max_y[4];
+        fill(min_x, min_x + 4, INT16_MAX);
+        fill(min_y, min_y + 4, INT16_MAX);
+        fill(max_x, max_x + 4, INT16_MIN);
+        fill(max_y, max_y + 4, INT16_MIN);
+        for (size_t i = begin; i < end; i++) {
+            if (i == candidates[c]) {
+                continue;
+            }
+            int q = position(pivot.x, pivot.y, cells[i].x, cells[i].y);
+            quadrant_count[q]++;
+            min_x[q] = min(min_x[q], (int) cells[i].x);
+            min_y[q] = min(min_y[q], (int) cells[i].y);
+            max_x[q] = max(max_x[q], (int) cells[i].x);
+            max_y[q] = max(max_y[q], (int) cells[i].y);
+        }
+        double cost = 0;
+        for (int q = 0; q < 4; q++) {
+            if (quadrant_count[q] > 0) {
+                cost += (double) quadrant_count[q] * (max_x[q] - min_x[q] + max_y[q] - min_y[q] + 2);
+            }
+        }
+        if (cost < best_cost) {
+            best_cost = cost;
+            best = candidates[c];
+        }
     }
-    return dir_node;
+    return best;
 };
 
-QuadNode* QSPTree::insertNode(QuadNode* root, QuadNode* node) {
-    RelativePosition relPos = position(Coords(root->wall.location.x, root->wall.location.y), Coords(node->wall.location.x, node->wall.location.y));
-    switch (relPos) {
-        case RelativePosition::REL_UP:
-            root->U = insertRelative(root->U, node);
-            break;
-        case RelativePosition::REL_DOWN:
-            root->D = insertRelative(root->D, node);
-            break;
-        case RelativePosition::REL_LEFT:
-            root->L = insertRelative(root->L, node);
-        default:
-            root->R = insertRelative(root->R, node);
-            break;
+///
+/// Build the subtree over a range of walls into out, depth first. The range is
+/// reordered so each quadrant's walls are contiguous. With a task list, subtrees
+/// at QSP_PARALLEL_DEPTH big enough to share out are recorded there instead
+///
+/// @param vector<BuildCell> cells: Walls of the tree
+/// @param size_t begin: First wall of the subtree (inclusive)
+/// @param size_t end: Last wall of the subtree (exclusive)
+/// @param vector<QuadNode> out: Arena the nodes are appended to
+/// @param vector<int> scratch: Working space for picking pivots
+/// @param int depth: Depth of the subtree root
+/// @param vector<BuildTask>* tasks: Receives deferred subtrees, nullptr to build everything here
+/// @param int32_t parent: Node the subtree hangs from, QUAD_NODE_NONE for the root
+/// @param int slot: Child slot of the parent it fills
+///
+/// @return int32_t: Index of the subtree root in out, QUAD_NODE_NONE if empty or deferred
+///
+int32_t QSPTree::bulkLoad(vector<BuildCell>& cells, size_t begin, size_t end, vector<QuadNode>& out,
+    vector<int>& scratch, int depth, vector<BuildTask>* tasks, int32_t parent, int slot) {
+    if (begin == end) {
+        return QUAD_NODE_NONE;
+    }
+    if (tasks != nullptr && depth == QSP_PARALLEL_DEPTH && end - begin >= QSP_PARALLEL_MIN_WALLS) {
+        tasks->push_back(BuildTask{begin, end, parent, slot});
+        return QUAD_NODE_NONE;
+    }
+
+    swap(cells[begin], cells[choosePivot(cells, begin, end, scratch)]);
+    const BuildCell pivot = cells[begin];
+    QuadNode node;
+    node.x = node.min_x = node.max_x = pivot.x;
+    node.y = node.min_y = node.max_y = pivot.y;
+    node.wall = pivot.wall;
+    fill(node.child, node.child + 4, QUAD_NODE_NONE);
+    for (size_t i = begin + 1; i < end; i++) {
+        node.min_x = min(node.min_x, cells[i].x);
+        node.min_y = min(node.min_y, cells[i].y);
+        node.max_x = max(node.max_x, cells[i].x);
+        node.max_y = max(node.max_y, cells[i].y);
+    }
+    int32_t index = (int32_t) out.size();
+    out.push_back(node);
+
+    // Group the rest by quadrant in RelativePosition order
+    size_t bounds[5];
+    bounds[0] = begin + 1;
+    for (int q = 0; q < 3; q++) {
+        bounds[q + 1] = partition(cells.begin() + bounds[q], cells.begin() + end, [&pivot, q](const BuildCell& cell) {
+            return position(pivot.x, pivot.y, cell.x, cell.y) == (RelativePosition) q;
+        }) - cells.begin();
+    }
+    bounds[4] = end;
+    for (int q = 0; q < 4; q++) {
+        int32_t child = bulkLoad(cells, bounds[q], bounds[q + 1], out, scratch, depth + 1, tasks, index, q);
+        out[index].child[q] = child;
     }
-    return root;
+    return index;
 };
 
-void QSPTree::buildTree() {
+///
+/// Reorder the arena level by level from the root, so a query touches the nodes
+/// near the top, which every ray visits, in a handful of adjacent cache lines
+///
+/// @return void
+///
+void QSPTree::layoutBreadthFirst() {
+    vector<QuadNode> ordered;
+    ordered.reserve(this->arena.size());
+    vector<int32_t> order(1, 0);
+    order.reserve(this->arena.size());
+    for (size_t head = 0; head < order.size(); head++) {
+        QuadNode node = this->arena[order[head]];
+        for (int32_t& child : node.child) {
+            if (child != QUAD_NODE_NONE) {
+                order.push_back(child);
+                // Children are queued in order, so the position they will take is known now
+                child = (int32_t) order.size() - 1;
+            }
+        }
+        ordered.push_back(node);
+    }
+    this->arena.swap(ordered);
+};
+
+///
+/// Bulk load the tree from every wall at once
+///
+/// @param WorkerPool* pool: Workers to share the lower subtrees between, nullptr to build on this thread
+///
+/// @return void
+///
+void QSPTree::buildTree(WorkerPool* pool) {
     debugContext.logAppInfo("---- STARTED BUILDING QSP TREE ----");
-    for (Constructs::AABB wall : *this->walls) {
-        this->root = insertNode(this->root, new QuadNode(wall));
+    release();
+    vector<BuildCell> cells(this->walls.size());
+    for (size_t i = 0; i < this->walls.size(); i++) {
+        cells[i] = BuildCell{(int16_t) (this->walls[i] % this->map_width), (int16_t) (this->walls[i] / this->map_width), this->walls[i]};
     }
-    debugContext.logAppInfo("Inserted " + to_string(this->walls->size()) + " AABB nodes");
-    // Inserting boundaries last will garuantee them as leaf nodes
-    for (Constructs::AABB wall : *this->up_boundary) {
-        this->root->U = insertNode(this->root->U, new QuadNode(wall));
+    this->arena.reserve(cells.size());
+
+    vector<BuildTask> tasks;
+    vector<int> scratch;
+    bool parallel = pool != nullptr && pool->size() > 1;
+    bulkLoad(cells, 0, cells.size(), this->arena, scratch, 0, parallel ? &tasks : nullptr, QUAD_NODE_NONE, 0);
+    if (!tasks.empty()) {
+        // Tasks cover disjoint ranges of cells, so workers only share the read of their own
+        vector<vector<QuadNode>> subtrees(tasks.size());
+        pool->run([&](int worker, int worker_count) {
+            vector<int> worker_scratch;
+            for (size_t t = worker; t < tasks.size(); t += worker_count) {
+                subtrees[t].reserve(tasks[t].end - tasks[t].begin);
+                bulkLoad(cells, tasks[t].begin, tasks[t].end, subtrees[t], worker_scratch, QSP_PARALLEL_DEPTH, nullptr, QUAD_NODE_NONE, 0);
+            }
+        });
+        for (size_t t = 0; t < tasks.size(); t++) {
+            int32_t offset = (int32_t) this->arena.size();
+            this->arena[tasks[t].parent].child[tasks[t].slot] = offset;
+            for (QuadNode node : subtrees[t]) {
+                for (int32_t& child : node.child) {
+                    child = child == QUAD_NODE_NONE ? child : child + offset;
+                }
+                this->arena.push_back(node);
+            }
+        }
+        debugContext.logAppInfo("Built " + to_string(tasks.size()) + " QSP subtrees on " + to_string(pool->size()) + " workers");
     }
-    debugContext.logAppInfo("Inserted " + to_string(this->up_boundary->size()) + " 'TOP' boundary leaves");
-    for (Constructs::AABB wall : *this->down_boundary) {
-        this->root->D = insertNode(this->root->D, new QuadNode(wall));
+    layoutBreadthFirst();
+    this->nodes = this->arena.data();
+    this->node_count = this->arena.size();
+    logStats();
+    debugContext.logAppInfo("---- FINISHED BUILDING QSP TREE [" + string(ADDR_OF(*this)) + "] ----");
+};
+
+///
+/// Log the depth and balance of the tree against a perfectly balanced one
+///
+/// @return void
+///
+void QSPTree::logStats() const {
+    if (this->node_count == 0) {
+        debugContext.logAppInfo("No walls to partition");
+        return;
     }
-    debugContext.logAppInfo("Inserted " + to_string(this->down_boundary->size()) + " 'DOWN' boundary leaves");
-    for (Constructs::AABB wall : *this->left_boundary) {
-        this->root->L = insertNode(this->root->L, new QuadNode(wall));
+    // Breadth first, so every parent comes before its children
+    vector<int> depths(this->node_count, 0);
+    // Quadrant of the root each node falls in
+    vector<int> quadrants(this->node_count, 0);
+    size_t quadrant_nodes[4] = {0, 0, 0, 0};
+    double depth_sum = 0;
+    int max_depth = 0;
+    size_t leaves = 0;
+    for (size_t i = 0; i < this->node_count; i++) {
+        bool leaf = true;
+        for (int q = 0; q < 4; q++) {
+            int32_t child = this->nodes[i].child[q];
+            if (child != QUAD_NODE_NONE) {
+                depths[child] = depths[i] + 1;
+                quadrants[child] = i == 0 ? q : quadrants[i];
+                leaf = false;
+            }
+        }
+        if (i > 0) {
+            quadrant_nodes[quadrants[i]]++;
+        }
+        depth_sum += depths[i];
+        max_depth = max(max_depth, depths[i]);
+        leaves += leaf;
     }
-    debugContext.logAppInfo("Inserted " + to_string(this->left_boundary->size()) + " 'LEFT' boundary leaves");
-    for (Constructs::AABB wall : *this->right_boundary) {
-        this->root->R = insertNode(this->root->R, new QuadNode(wall));
+    int ideal_depth = 0;
+    for (size_t level_nodes = 1, total = 1; total < this->node_count; level_nodes *= 4, total += level_nodes) {
+        ideal_depth++;
     }
-    debugContext.logAppInfo("Inserted " + to_string(this->right_boundary->size()) + " 'RIGHT' boundary leaves");
-    debugContext.logAppInfo("---- FINISHED BUILDING QSP TREE [" + string(ADDR_OF(*this)) + "] ----");
+    debugContext.logAppInfo("QSP tree of " + to_string(this->node_count) + " nodes, " + to_string(leaves) + " leaves, depth "
+        + to_string(max_depth) + " (balanced " + to_string(ideal_depth) + "), mean depth " + to_string(depth_sum / this->node_count));
+    debugContext.logAppInfo("QSP root quadrants hold " + to_string(quadrant_nodes[REL_UP]) + " up, " + to_string(quadrant_nodes[REL_DOWN])
+        + " down, " + to_string(quadrant_nodes[REL_LEFT]) + " left and " + to_string(quadrant_nodes[REL_RIGHT]) + " right");
+};
+
+///
+/// @return int: Depth of the deepest node, the root is at 0 and an empty tree is -1
+///
+int QSPTree::depth() const {
+    vector<int> depths(this->node_count, 0);
+    int max_depth = -1;
+    for (size_t i = 0; i < this->node_count; i++) {
+        for (int32_t child : this->nodes[i].child) {
+            if (child != QUAD_NODE_NONE) {
+                depths[child] = depths[i] + 1;
+            }
+        }
+        max_depth = max(max_depth, depths[i]);
+    }
+    return max_depth;
+};
+
+///
+/// FNV-1a over the map size and which cells are solid
+///
+/// @param World map: Map to hash
+///
+/// @return uint64_t
+///
+uint64_t QSPTree::hashMap(const World& map) {
+    uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&hash](uint32_t value) {
+        for (int i = 0; i < 4; i++) {
+            hash = (hash ^ ((value >> (i * 8)) & 0xFF)) * 1099511628211ULL;
+        }
+    };
+    mix(map.map_width);
+    mix(map.map_height);
+    for (int y = 0; y < map.map_height; y++) {
+        for (int x = 0; x < map.map_width; x++) {
+            if (map.getAt(x, y).type != Constructs::WallType::NONE) {
+                mix(y * map.map_width + x);
+            }
+        }
+    }
+    return hash;
+};
+
+///
+/// @param string map_file: Path of a map
+///
+/// @return string: Path of the saved tree next to it
+///
+string QSPTree::pathFor(const string& map_file) {
+    size_t dot = map_file.find_last_of('.');
+    size_t slash = map_file.find_last_of("/\\");
+    if (dot == string::npos || (slash != string::npos && dot < slash)) {
+        return map_file + QSP_FILE_EXTENSION;
+    }
+    return map_file.substr(0, dot) + QSP_FILE_EXTENSION;
+};
+
+///
+/// Write the nodes of a built tree to a file
+///
+/// @param string filename: Output file path
+///
+/// @return bool: False if there is no tree or the file could not be written
+///
+bool QSPTree::save(const string& filename) const {
+    if (this->node_count == 0) {
+        return false;
+    }
+    QSPFileHeader header;
+    memcpy(header.magic, QSP_FILE_MAGIC, sizeof(header.magic));
+    header.version = QSP_FILE_VERSION;
+    header.map_width = this->map_width;
+    header.map_height = this->map_height;
+    header.map_hash = this->map_hash;
+    header.node_count = this->node_count;
+
+    FILE* file = fopen(filename.c_str(), "wb");
+    if (file == nullptr) {
+        debugContext.logAppInfo("Could not write QSP tree to " + filename);
+        return false;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1
+        && fwrite(this->nodes, sizeof(QuadNode), this->node_count, file) == this->node_count;
+    written = fclose(file) == 0 && written;
+    if (!written) {
+        remove(filename.c_str());
+        debugContext.logAppInfo("Could not write QSP tree to " + filename);
+        return false;
+    }
+    debugContext.logAppInfo("Saved QSP tree of " + to_string(this->node_count) + " nodes to " + filename);
+    return true;
+};
+
+///
+/// Check that every child index of a tree names a later node, so walking it
+/// from the root stays inside the nodes and ends, and that every node is a
+/// cell of the map whose wall is the one at that cell, so queries only hand
+/// the world cells it has. Nodes are laid out breadth first, so children
+/// always come after their parent
+///
+/// @param QuadNode* nodes: Flattened tree
+/// @param size_t node_count: Nodes in the tree
+/// @param int map_width: Cells across the map the tree must partition
+/// @param int map_height: Cells down the map the tree must partition
+///
+/// @return bool: False if any node is outside the map, names another cell's wall,
+///               or has a child that is neither QUAD_NODE_NONE nor after it
+///
+bool QSPTree::validNodes(const QuadNode* nodes, size_t node_count, int map_width, int map_height) {
+    for (size_t i = 0; i < node_count; i++) {
+        const QuadNode& node = nodes[i];
+        if (node.x < 0 || node.x >= map_width || node.y < 0 || node.y >= map_height
+            || node.wall != (uint32_t) node.y * (uint32_t) map_width + (uint32_t) node.x) {
+            return false;
+        }
+        for (int q = 0; q < 4; q++) {
+            int32_t child = nodes[i].child[q];
+            if (child != QUAD_NODE_NONE && (child <= (int64_t) i || (size_t) child >= node_count)) {
+                return false;
+            }
+        }
+    }
+    return true;
+};
+
+///
+/// Take the nodes from a saved tree, memory mapped where the platform allows.
+/// The file must have been saved for this map, any mismatch leaves the tree as it was
+///
+/// @param string filename: Saved tree
+/// @param World map: Map the tree must partition
+///
+/// @return bool: False if the file is missing, malformed, corrupt or saved for other walls
+///
+bool QSPTree::load(const string& filename, const World& map) {
+    FILE* file = fopen(filename.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    QSPFileHeader header;
+    bool read = fread(&header, sizeof(header), 1, file) == 1;
+    long file_bytes = fseek(file, 0, SEEK_END) == 0 ? ftell(file) : -1;
+
+    string problem;
+    if (!read || memcmp(header.magic, QSP_FILE_MAGIC, sizeof(header.magic)) != 0) {
+        problem = "not a QSP tree";
+    } else if (header.version != QSP_FILE_VERSION) {
+        problem = "version " + to_string(header.version) + ", expected " + to_string(QSP_FILE_VERSION);
+    } else if (header.map_width != map.map_width || header.map_height != map.map_height || header.map_hash != hashMap(map)) {
+        problem = "saved for different walls";
+    } else if (header.node_count == 0 || file_bytes != (long) (sizeof(header) + header.node_count * sizeof(QuadNode))) {
+        problem = "truncated";
+    }
+    if (!problem.empty()) {
+        fclose(file);
+        debugContext.logAppInfo("Ignoring QSP tree " + filename + ": " + problem);
+        return false;
+    }
+
+#if _WIN64 || _WIN32
+    vector<QuadNode> loaded(header.node_count);
+    read = fseek(file, sizeof(header), SEEK_SET) == 0
+        && fread(loaded.data(), sizeof(QuadNode), loaded.size(), file) == loaded.size();
+    fclose(file);
+    if (!read) {
+        debugContext.logAppInfo("Could not read QSP tree " + filename);
+        return false;
+    }
+    if (!validNodes(loaded.data(), loaded.size(), map.map_width, map.map_height)) {
+        debugContext.logAppInfo("Ignoring QSP tree " + filename + ": corrupt nodes");
+        return false;
+    }
+    release();
+    this->arena.swap(loaded);
+    this->nodes = this->arena.data();
+#else
+    void* mapped = mmap(nullptr, file_bytes, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+    fclose(file);
+    if (mapped == MAP_FAILED) {
+        debugContext.logAppInfo("Could not map QSP tree " + filename);
+        return false;
+    }
+    if (!validNodes((const QuadNode*) ((const char*) mapped + sizeof(header)), header.node_count, map.map_width, map.map_height)) {
+        munmap(mapped, file_bytes);
+        debugContext.logAppInfo("Ignoring QSP tree " + filename + ": corrupt nodes");
+        return false;
+    }
+    release();
+    this->mapping = mapped;
+    this->mapping_bytes = file_bytes;
+    this->nodes = (const QuadNode*) ((const char*) mapped + sizeof(header));
+#endif
+    this->node_count = header.node_count;
+    this->map_width = map.map_width;
+    this->map_height = map.map_height;
+    this->map_hash = header.map_hash;
+    this->walls.clear();
+    debugContext.logAppInfo("Loaded QSP tree of " + to_string(this->node_count) + " nodes from " + filename);
+    return true;
+};
+
+///
+/// @return size_t: Number of nodes, one per solid cell once built
+///
+size_t QSPTree::size() const {
+    return this->node_count;
 };
 
-inline void QSPTree::traverseNext(RelativePosition& currBranch, QuadNode* currNode, TraversalRecord& currTraversal, stack<TraversalRecord>& nodesVisited) {
-    switch (currBranch) {
-        case RelativePosition::REL_UP:
-            currNode = currNode->U;
-            currTraversal.traversals.push_back(RelativePosition::REL_UP);
-            nodesVisited.push(currTraversal);
-            break;
-        case RelativePosition::REL_LEFT:
-            currNode = currNode->L;
-            currTraversal.traversals.push_back(RelativePosition::REL_LEFT);
-            nodesVisited.push(currTraversal);
-            break;
-        case RelativePosition::REL_DOWN:
-            currNode = currNode->D;
-            currTraversal.traversals.push_back(RelativePosition::REL_DOWN);
-            nodesVisited.push(currTraversal);
-            break;
-        default:
-            currNode = currNode->R;
-            currTraversal.traversals.push_back(RelativePosition::REL_RIGHT);
-            nodesVisited.push(currTraversal);
-            break;
-    }
-};
-
-void QSPTree::queryWalls(Coords origin, float player_angle, vector<Ray>& rays, vector<Coords>& ret_walls) {
-    // TODO: implement tree traversal and node query against rays
-    stack<TraversalRecord> nodesVisited;
-    TraversalRecord currTraversal(this->root, vector<RelativePosition>());
-    QuadNode* currNode = this->root;
-    Coords cPos = Coords(radToCoord(currNode->wall.location.x) + 0.5, radToCoord(currNode->wall.location.y) + 0.5);
-    RelativePosition currBranch = position(cPos, origin);
-    int raysQueried = 0;
-    debugContext.logAppVerb("Querying " + to_string(rays.size()) + " rays in QSP tree [" + ADDR_OF(*this) + "]");
-    while (raysQueried < rays.size() && (!nodesVisited.empty())) {
-        if (currNode == nullptr) {
-            currTraversal = nodesVisited.top();
-            nodesVisited.pop();
-            currNode = currTraversal.node;
+///
+/// @return size_t: Memory held by the nodes
+///
+size_t QSPTree::bytes() const {
+    return this->node_count * sizeof(QuadNode);
+};
+
+///
+/// @return bool: True if the nodes are mapped from a saved tree
+///
+bool QSPTree::mapped() const {
+    return this->mapping != nullptr;
+};
+
+///
+/// Slab test of a ray against the box [x0, x1] x [y0, y1]
+///
+/// @param int& side: Set to 0 if the ray enters through an x facing edge, 1 for a y facing one
+///
+/// @return double: Distance along the ray at which it enters, infinity if it misses or the box is behind
+///
+inline static double qspEnter(double origin_x, double origin_y, double inv_x, double inv_y,
+    double x0, double y0, double x1, double y1, int& side) {
+    double tx0 = (x0 - origin_x) * inv_x;
+    double tx1 = (x1 - origin_x) * inv_x;
+    double ty0 = (y0 - origin_y) * inv_y;
+    double ty1 = (y1 - origin_y) * inv_y;
+    double near_x = min(tx0, tx1);
+    double near_y = min(ty0, ty1);
+    double t_exit = min(max(tx0, tx1), max(ty0, ty1));
+    // Ties go to the y facing edge, as the DDA steps y when both side distances are equal
+    side = near_x > near_y ? 0 : 1;
+    double t_enter = max(near_x, near_y);
+    return t_enter <= t_exit && t_exit >= 0 ? t_enter : numeric_limits<double>::infinity();
+}
+
+///
+/// Intersect a batch of rays with the walls in the tree, front to back. Each node
+/// keeps the rays that can still meet something in its subtree closer than their
+/// best hit so far, so a ray retires once it hits and every remaining subtree lies
+/// beyond. Subtrees are visited nearest first from the first ray's origin. Results
+/// match the DDA: the starting cell is never hit and distances are perpendicular
+/// to the camera plane when the directions are camera rays
+///
+/// @param RayBuffer rays: Frame rays
+/// @param int first: First ray to query (inclusive)
+/// @param int last: Last ray to query (exclusive)
+/// @param vector<RayHit> hits: Receives the hit of ray i at index i. The face hit is the
+///        x (side 0) or y (side 1) facing edge of the cell on the side the ray came from
+/// @param double max_dist: Give up on walls further than this
+///
+/// @return void
+///
+void QSPTree::queryWalls(const Rendering::RayBuffer& rays, int first, int last, vector<Rendering::RayHit>& hits, double max_dist) const {
+    QueryScratch scratch;
+    queryWalls(rays, first, last, hits, scratch, max_dist);
+};
+
+///
+/// Intersect a batch of rays with the walls in the tree, keeping the per ray terms
+/// and traversal stack in the caller's scratch rather than allocating them
+///
+/// @param RayBuffer rays: Frame rays
+/// @param int first: First ray to query (inclusive)
+/// @param int last: Last ray to query (exclusive)
+/// @param vector<RayHit> hits: Receives the hit of ray i at index i
+/// @param QueryScratch scratch: Working storage, reused from query to query
+/// @param double max_dist: Give up on walls further than this
+///
+/// @return void
+///
+void QSPTree::queryWalls(const Rendering::RayBuffer& rays, int first, int last, vector<Rendering::RayHit>& hits,
+    QueryScratch& scratch, double max_dist) const {
+    int count = last - first;
+    if (count <= 0) {
+        return;
+    }
+    vector<double>& inv_x = scratch.inv_x;
+    vector<double>& inv_y = scratch.inv_y;
+    vector<double>& best = scratch.best;
+    vector<int>& ids = scratch.ids;
+    vector<QueryScratch::Frame>& frames = scratch.frames;
+    inv_x.resize(count);
+    inv_y.resize(count);
+    best.assign(count, max_dist);
+    ids.resize(count);
+    frames.clear();
+    for (int i = 0; i < count; i++) {
+        const Rendering::CameraRay& ray = rays[first + i];
+        inv_x[i] = ray.dir_x != 0 ? 1 / ray.dir_x : copysign(QSP_INV_ZERO_DIR, ray.dir_x);
+        inv_y[i] = ray.dir_y != 0 ? 1 / ray.dir_y : copysign(QSP_INV_ZERO_DIR, ray.dir_y);
+        ids[i] = i;
+        Rendering::RayHit& hit = hits[first + i];
+        hit.map_x = (int) ray.origin_x;
+        hit.map_y = (int) ray.origin_y;
+        hit.side = 0;
+        hit.perp_wall_dist = max_dist;
+        hit.in_range = false;
+        hit.steps = 0;
+    }
+
+    if (this->node_count > 0) {
+        frames.push_back(QueryScratch::Frame{0, 0, (size_t) count});
+    }
+    int side;
+    while (!frames.empty()) {
+        QueryScratch::Frame frame = frames.back();
+        frames.pop_back();
+        // Lists past this frame's belong to subtrees already finished
+        ids.resize(frame.end);
+        const QuadNode& node = this->nodes[frame.node];
+
+        size_t begin = ids.size();
+        for (size_t k = frame.begin; k < frame.end; k++) {
+            int i = ids[k];
+            const Rendering::CameraRay& ray = rays[first + i];
+            hits[first + i].steps++;
+            if (qspEnter(ray.origin_x, ray.origin_y, inv_x[i], inv_y[i],
+                    node.min_x, node.min_y, node.max_x + 1, node.max_y + 1, side) <= best[i]) {
+                ids.push_back(i);
+            }
+        }
+        size_t end = ids.size();
+        if (begin == end) {
             continue;
         }
 
-        cPos = Coords(radToCoord(currNode->wall.location.x) + 0.5, radToCoord(currNode->wall.location.y) + 0.5);
-        currBranch = position(cPos, origin);
+        int cell_x = node.x;
+        int cell_y = node.y;
+        for (size_t k = begin; k < end; k++) {
+            int i = ids[k];
+            const Rendering::CameraRay& ray = rays[first + i];
+            if (cell_x == (int) ray.origin_x && cell_y == (int) ray.origin_y) {
+                continue;
+            }
+            double t = qspEnter(ray.origin_x, ray.origin_y, inv_x[i], inv_y[i], cell_x, cell_y, cell_x + 1, cell_y + 1, side);
+            Rendering::RayHit& hit = hits[first + i];
+            if (t < best[i] || (t == best[i] && !hit.in_range)) {
+                best[i] = t;
+                hit.map_x = cell_x;
+                hit.map_y = cell_y;
+                hit.side = side;
+                hit.in_range = true;
+            }
+        }
 
-        vector<Ray> newRays;
-        for (Ray ray : rays) {
-            Coords intersection;
-            if (currNode->wall.intersect(ray, intersection)) {
-                raysQueried++;
-                ret_walls.push_back(intersection);
-            } else {
-                newRays.push_back(ray);
+        // Front to back from the first ray's origin: the quadrant holding it, the two
+        // beside it, then the one opposite. Pushed in reverse so the nearest pops first
+        const Rendering::CameraRay& lead = rays[first + ids[begin]];
+        double rel_x = lead.origin_x - (cell_x + 0.5);
+        double rel_y = lead.origin_y - (cell_y + 0.5);
+        int32_t nearest, opposite, beside[2];
+        if (fabs(rel_x) > fabs(rel_y)) {
+            nearest = node.child[rel_x > 0 ? REL_RIGHT : REL_LEFT];
+            opposite = node.child[rel_x > 0 ? REL_LEFT : REL_RIGHT];
+            beside[0] = node.child[REL_UP];
+            beside[1] = node.child[REL_DOWN];
+        } else {
+            nearest = node.child[rel_y > 0 ? REL_UP : REL_DOWN];
+            opposite = node.child[rel_y > 0 ? REL_DOWN : REL_UP];
+            beside[0] = node.child[REL_LEFT];
+            beside[1] = node.child[REL_RIGHT];
+        }
+        for (int32_t child : {opposite, beside[1], beside[0], nearest}) {
+            if (child != QUAD_NODE_NONE) {
+                frames.push_back(QueryScratch::Frame{child, begin, end});
             }
         }
-        rays = newRays;
+    }
 
-        RelativePosition nextBranch = currBranch;
-        if (currTraversal.traversals.size() == 4) {
-            currNode = nodesVisited.top().node;
-            nodesVisited.pop();
+    // Distances from the same expression as the DDA, so both engines agree exactly
+    for (int i = 0; i < count; i++) {
+        const Rendering::CameraRay& ray = rays[first + i];
+        Rendering::RayHit& hit = hits[first + i];
+        if (!hit.in_range) {
             continue;
         }
-        // 3.1 If already searched branch containing ray origin, try other branches
-        if (find(currTraversal.traversals.begin(), currTraversal.traversals.end(), currBranch) == currTraversal.traversals.end()) {
-            // 3.2 If already searched branch that rays at facing towards try other branches
-            // 3.3 If already searched non-behind branch, try behind branch
+        if (hit.side == 0) {
+            hit.perp_wall_dist = (hit.map_x - ray.origin_x + (1 - (int) copysign(1.0, ray.dir_x)) / 2) / ray.dir_x;
+        } else {
+            hit.perp_wall_dist = (hit.map_y - ray.origin_y + (1 - (int) copysign(1.0, ray.dir_y)) / 2) / ray.dir_y;
         }
-        traverseNext(currBranch, currNode, currTraversal, nodesVisited);
     }
 };
 
-void QSPTree::printPreorder(QuadNode* node) {
-    if (node == nullptr) {
+void QSPTree::printPreorder(int node) const {
+    if (node == QUAD_NODE_NONE || (size_t) node >= this->node_count) {
         return;
     }
-    cout << "(" + to_string(node->wall.location.x) + "," + to_string(node->wall.location.y) + ")";
-    printPreorder(node->U);
-    printPreorder(node->D);
-    printPreorder(node->L);
-    printPreorder(node->R);
-};
\ No newline at end of file
+    cout << "(" + to_string(this->nodes[node].x) + "," + to_string(this->nodes[node].y) + ")";
+    for (int32_t child : this->nodes[node].child) {
+        printPreorder(child);
+    }
+};
@@ -1,37 +1,30 @@
 #pragma once
 
-#include <cmath>
-#include <limits>
-#include <stack>
-#include <vector>
-
-#include "../../environment/constructs/walls/AABB.cpp"
-#include "../../environment/world/World.cpp"
-#include "../../rendering/Globals.hpp"
-#include "../../rendering/raycaster/Ray.hpp"
+#include <stdint.h>
 
 using namespace std;
 
-struct QuadNode {
-    QuadNode(Constructs::AABB& wall);
-    ~QuadNode();
+// Child index of an empty quadrant
+#define QUAD_NODE_NONE -1
 
-    Constructs::AABB wall;
-    QuadNode* U = nullptr;
-    QuadNode* D = nullptr;
-    QuadNode* L = nullptr;
-    QuadNode* R = nullptr;
-    QuadNode* parent = nullptr;
+///
+/// Node of a flattened QSP tree. Nodes live in one array and name their children
+/// by index, so a tree is a single block that can be written out and mapped back
+/// in as is. Two nodes fit a cache line
+///
+struct QuadNode {
+    // Wall cell
+    int16_t x;
+    int16_t y;
+    // Cells covered by this node and everything below it, inclusive
+    int16_t min_x;
+    int16_t min_y;
+    int16_t max_x;
+    int16_t max_y;
+    // Index of the wall in World::walls
+    uint32_t wall;
+    // Children by RelativePosition (up, down, left, right), QUAD_NODE_NONE if empty
+    int32_t child[4];
 };
 
-QuadNode::QuadNode(Constructs::AABB& wall) {
-    this->wall = wall;
-}
-
-QuadNode::~QuadNode() {
-    delete U;
-    delete D;
-    delete L;
-    delete R;
-    delete parent;
-}
\ No newline at end of file
+static_assert(sizeof(QuadNode) == 32, "QuadNode is written to disk as is, keep it packed");
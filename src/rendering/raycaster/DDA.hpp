@@ -0,0 +1,200 @@
+#pragma once
+
+#include <math.h>
+
+#include <algorithm>
+#include <limits>
+
+#include "FixedPoint.hpp"
+
+using namespace std;
+
+namespace Rendering {
+
+// DDA arithmetic: 0 = double, 16 = 16.16 fixed point, 32 = 32.32 fixed point
+#ifndef RAYCAST_DDA_FIXED
+    #define RAYCAST_DDA_FIXED 0
+#endif
+
+///
+/// First wall cell a ray enters and its distance to the camera plane
+///
+struct RayHit {
+    int map_x;
+    int map_y;
+    // 0 if an x facing (vertical) edge was crossed, 1 for a y facing one
+    int side;
+    double perp_wall_dist;
+    // False if no wall was found within the maximum distance, perp_wall_dist is then that distance
+    bool in_range;
+    // Cells (or whole empty blocks, for the hierarchical traversal) the ray stepped through
+    int steps;
+};
+
+///
+/// Carry on stepping a ray with doubles from a cell part way along it, until it
+/// enters a wall cell. Lets a ray started elsewhere, as a lane of a packet, finish
+/// with the same arithmetic as castRayDouble
+///
+/// @param double origin_x: Ray origin in world units
+/// @param double origin_y: Ray origin in world units
+/// @param double dir_x: Ray direction, not normalised
+/// @param double dir_y: Ray direction, not normalised
+/// @param RayHit hit: Cell the ray is in, the last side it crossed and its steps so far
+/// @param double side_dist_x: Distance along the ray to the next x facing edge
+/// @param double side_dist_y: Distance along the ray to the next y facing edge
+/// @param IsWall is_wall: Callable (int x, int y) -> bool
+/// @param double max_dist: Give up on walls further than this from the camera plane
+///
+/// @return RayHit
+///
+template <typename IsWall>
+inline RayHit continueRayDouble(double origin_x, double origin_y, double dir_x, double dir_y, RayHit hit,
+    double side_dist_x, double side_dist_y, const IsWall& is_wall, double max_dist = numeric_limits<double>::infinity()) {
+    double delta_x = fabs(1 / dir_x);
+    double delta_y = fabs(1 / dir_y);
+    int step_x = copysign(1.0, dir_x);
+    int step_y = copysign(1.0, dir_y);
+
+    // A side distance is how far along the ray the next edge on that axis is crossed
+    do {
+        if (side_dist_x < side_dist_y) {
+            if (side_dist_x > max_dist) {
+                hit.in_range = false;
+                hit.perp_wall_dist = max_dist;
+                return hit;
+            }
+            side_dist_x += delta_x;
+            hit.map_x += step_x;
+            hit.side = 0;
+        } else {
+            if (side_dist_y > max_dist) {
+                hit.in_range = false;
+                hit.perp_wall_dist = max_dist;
+                return hit;
+            }
+            side_dist_y += delta_y;
+            hit.map_y += step_y;
+            hit.side = 1;
+        }
+        hit.steps++;
+    } while (!is_wall(hit.map_x, hit.map_y));
+
+    hit.in_range = true;
+    if (hit.side == 0) {
+        hit.perp_wall_dist = (hit.map_x - origin_x + (1 - step_x) / 2) / dir_x;
+    } else {
+        hit.perp_wall_dist = (hit.map_y - origin_y + (1 - step_y) / 2) / dir_y;
+    }
+    return hit;
+}
+
+///
+/// Step a ray through the grid with doubles until it enters a wall cell
+///
+/// @param double origin_x: Ray origin in world units
+/// @param double origin_y: Ray origin in world units
+/// @param double dir_x: Ray direction, not normalised
+/// @param double dir_y: Ray direction, not normalised
+/// @param IsWall is_wall: Callable (int x, int y) -> bool
+/// @param double max_dist: Give up on walls further than this from the camera plane
+///
+/// @return RayHit
+///
+template <typename IsWall>
+inline RayHit castRayDouble(double origin_x, double origin_y, double dir_x, double dir_y, const IsWall& is_wall,
+    double max_dist = numeric_limits<double>::infinity()) {
+    RayHit hit;
+    hit.map_x = (int) origin_x;
+    hit.map_y = (int) origin_y;
+    hit.side = 0;
+    hit.steps = 0;
+    double side_dist_x = fabs(1 / dir_x) * (dir_x < 0 ? origin_x - hit.map_x : hit.map_x + 1.0 - origin_x);
+    double side_dist_y = fabs(1 / dir_y) * (dir_y < 0 ? origin_y - hit.map_y : hit.map_y + 1.0 - origin_y);
+    return continueRayDouble(origin_x, origin_y, dir_x, dir_y, hit, side_dist_x, side_dist_y, is_wall, max_dist);
+}
+
+///
+/// Step a ray through the grid in fixed point. The per axis step comes from the
+/// reciprocal table rather than a divide, the loop is integer adds and compares,
+/// and the wall distance is the last side distance minus one step, so no divide either
+///
+/// @param double origin_x: Ray origin in world units
+/// @param double origin_y: Ray origin in world units
+/// @param double dir_x: Ray direction, not normalised
+/// @param double dir_y: Ray direction, not normalised
+/// @param IsWall is_wall: Callable (int x, int y) -> bool
+/// @param double max_dist: Give up on walls further than this from the camera plane
+///
+/// @return RayHit
+///
+template <typename F, typename IsWall>
+inline RayHit castRayFixed(double origin_x, double origin_y, double dir_x, double dir_y, const IsWall& is_wall,
+    double max_dist = numeric_limits<double>::infinity()) {
+    typedef typename F::Type T;
+    RayHit hit;
+    hit.map_x = (int) origin_x;
+    hit.map_y = (int) origin_y;
+    hit.side = 0;
+    hit.steps = 0;
+
+    T abs_x = F::fromDouble(fabs(dir_x));
+    T abs_y = F::fromDouble(fabs(dir_y));
+    T delta_x = abs_x > 0 ? F::recip(abs_x) : F::FAR;
+    T delta_y = abs_y > 0 ? F::recip(abs_y) : F::FAR;
+    int step_x = dir_x < 0 ? -1 : 1;
+    int step_y = dir_y < 0 ? -1 : 1;
+    T frac_x = F::fromDouble(origin_x - hit.map_x);
+    T frac_y = F::fromDouble(origin_y - hit.map_y);
+    T side_dist_x = F::mul(delta_x, dir_x < 0 ? frac_x : F::ONE - frac_x);
+    T side_dist_y = F::mul(delta_y, dir_y < 0 ? frac_y : F::ONE - frac_y);
+
+    T max_side_dist = max_dist >= F::toDouble(F::FAR) ? F::FAR : F::fromDouble(max_dist);
+
+    // Branch free step, the axis choice is close to random so a branch mispredicts often
+    T x_mask, y_mask;
+    do {
+        if (min(side_dist_x, side_dist_y) > max_side_dist) {
+            hit.in_range = false;
+            hit.perp_wall_dist = max_dist;
+            return hit;
+        }
+        x_mask = -(T) (side_dist_x < side_dist_y);
+        y_mask = ~x_mask;
+        side_dist_x += delta_x & x_mask;
+        side_dist_y += delta_y & y_mask;
+        hit.map_x += step_x & (int) x_mask;
+        hit.map_y += step_y & (int) y_mask;
+        hit.steps++;
+    } while (!is_wall(hit.map_x, hit.map_y));
+    hit.side = (int) (y_mask & 1);
+    hit.in_range = true;
+
+    hit.perp_wall_dist = F::toDouble(hit.side == 0 ? side_dist_x - delta_x : side_dist_y - delta_y);
+    return hit;
+}
+
+///
+/// Cast a ray with the DDA selected at compile time by RAYCAST_DDA_FIXED
+///
+/// @param double origin_x: Ray origin in world units
+/// @param double origin_y: Ray origin in world units
+/// @param double dir_x: Ray direction, not normalised
+/// @param double dir_y: Ray direction, not normalised
+/// @param IsWall is_wall: Callable (int x, int y) -> bool
+/// @param double max_dist: Give up on walls further than this from the camera plane
+///
+/// @return RayHit
+///
+template <typename IsWall>
+inline RayHit castRay(double origin_x, double origin_y, double dir_x, double dir_y, const IsWall& is_wall,
+    double max_dist = numeric_limits<double>::infinity()) {
+#if RAYCAST_DDA_FIXED == 16
+    return castRayFixed<Fixed16>(origin_x, origin_y, dir_x, dir_y, is_wall, max_dist);
+#elif RAYCAST_DDA_FIXED == 32
+    return castRayFixed<Fixed32>(origin_x, origin_y, dir_x, dir_y, is_wall, max_dist);
+#else
+    return castRayDouble(origin_x, origin_y, dir_x, dir_y, is_wall, max_dist);
+#endif
+}
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+
+using namespace std;
+
+namespace Rendering {
+
+// Reciprocal table entries between 1 and 2, interpolated then refined by a Newton step
+#define RECIP_TABLE_BITS 8
+#define RECIP_TABLE_SIZE (1 << RECIP_TABLE_BITS)
+
+///
+/// 1 / m for mantissas m in [1, 2] as Q0.32, one extra entry closes the last interval
+///
+struct RecipTable {
+    uint64_t entries[RECIP_TABLE_SIZE + 1];
+
+    RecipTable() {
+        for (int i = 0; i <= RECIP_TABLE_SIZE; i++) {
+            this->entries[i] = (uint64_t) llround(4294967296.0 / (1.0 + double(i) / RECIP_TABLE_SIZE));
+        }
+    }
+};
+
+static const RecipTable recipTable;
+
+///
+/// Signed fixed point arithmetic with FRAC fractional bits stored in T,
+/// products are formed in Wide so no precision is lost before the shift
+///
+template <typename T, typename Wide, int FRAC>
+struct Fixed {
+    typedef T Type;
+
+    static const int FRAC_BITS = FRAC;
+    static const T ONE = T(1) << FRAC;
+    // Stand in for infinity, leaves headroom so a few additions can't overflow
+    static const T FAR = T(1) << (sizeof(T) * 8 - 4);
+
+    static inline T fromDouble(double value) {
+        return (T) (value * (double) ONE);
+    }
+
+    static inline double toDouble(T value) {
+        return value / (double) ONE;
+    }
+
+    static inline T mul(T a, T b) {
+        return (T) (((Wide) a * b) >> FRAC);
+    }
+
+    ///
+    /// Reciprocal without a divide, from the interpolated table and one Newton-Raphson step
+    ///
+    /// @param T value: Positive fixed point value
+    ///
+    /// @return T: 1 / value, saturated to FAR
+    ///
+    static inline T recip(T value) {
+        uint64_t bits = (uint64_t) value;
+        // value = mantissa * 2^(top - FRAC), with the mantissa's leading 1 moved to bit 63
+        int top = 63 - __builtin_clzll(bits);
+        uint64_t norm = bits << (63 - top);
+        uint32_t idx = (uint32_t) (norm >> (63 - RECIP_TABLE_BITS)) & (RECIP_TABLE_SIZE - 1);
+        uint64_t weight = (norm >> (63 - RECIP_TABLE_BITS - 16)) & 0xFFFF;
+        uint64_t lo = recipTable.entries[idx];
+        uint64_t r = lo - (((lo - recipTable.entries[idx + 1]) * weight) >> 16);
+
+        // r is 1 / mantissa as Q0.32, rescale to 1 / value in this format
+        int shift = 2 * FRAC - top - 32;
+        if (shift >= 0) {
+            if (shift >= 62 || r > ((uint64_t) FAR >> shift)) {
+                return FAR;
+            }
+            r <<= shift;
+        } else {
+            r = -shift >= 64 ? 0 : r >> -shift;
+        }
+        T estimate = (T) r;
+        return mul(estimate, 2 * ONE - mul(value, estimate));
+    }
+};
+
+typedef Fixed<int32_t, int64_t, 16> Fixed16;
+typedef Fixed<int64_t, __int128, 32> Fixed32;
+}
@@ -0,0 +1,716 @@
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "../../environment/world/World.cpp"
+#include "../partitioning/QSPTree.cpp"
+#include "../../logic/threading/WorkerPool.cpp"
+#include "../colour/FogTable.cpp"
+#include "../colour/Palette.cpp"
+#include "../texturing/TextureAtlas.cpp"
+#include "../texturing/ColumnSampler.hpp"
+#include "../viewmodel/Camera.hpp"
+#include "../Globals.hpp"
+#include "Ray.hpp"
+#include "DDA.hpp"
+#include "OccupancyGrid.cpp"
+#include "RayPacket.hpp"
+#include "SpriteQueue.cpp"
+#include "HiZBuffer.cpp"
+#include "ViewTables.cpp"
+#include "../buffering/PBO.cpp"
+
+#define SPRITE_U_DIV 1
+#define SPRITE_V_DIV 1
+#define SPRITE_V_MOVE 0.0
+
+#define DARK_SHADER 0x7F7F7F
+
+// Columns per strip boundary, keeps strip edges on cache line boundaries
+// for both the 4 byte PBO pixels and 8 byte z buffer entries
+#define RENDER_STRIP_ALIGN 16
+
+using namespace std;
+
+namespace Rendering {
+
+///
+/// Split the range [first, last) into one strip per worker, each a multiple of align long
+///
+/// @param int worker: Index of the worker
+/// @param int worker_count: Workers sharing the range
+/// @param int first: Start of the range (inclusive)
+/// @param int last: End of the range (exclusive)
+/// @param int align: Strip lengths are rounded up to a multiple of this
+/// @param int start: Receives the start of the worker's strip (inclusive)
+/// @param int end: Receives the end of the worker's strip (exclusive)
+///
+/// @return void
+///
+inline static void stripBounds(int worker, int worker_count, int first, int last, int align, int& start, int& end) {
+    int count = last - first;
+    int strip = (count + worker_count - 1) / worker_count;
+    strip = (strip + align - 1) / align * align;
+    start = min(last, first + worker * strip);
+    end = min(last, start + strip);
+}
+
+
+///
+/// Floor and ceiling rows of packed texels. Floors and ceilings are always
+/// shaded dark, then blended toward the fog of their row
+///
+struct TrueColourRows {
+    typedef uint32_t Pixel;
+
+    struct Shader {
+        const FogTable* fog;
+        uint32_t fog_weight;
+
+        inline uint32_t operator()(uint32_t texel) const {
+            uint32_t color = (texel >> 1) & DARK_SHADER;
+            return this->fog_weight ? this->fog->blend(color, this->fog_weight) : color;
+        }
+    };
+
+    TrueColourRows(const TextureAtlas& atlas, const FogTable& fog, PBO& target):
+        atlas(atlas),
+        fog(fog),
+        target(target)
+    {};
+
+    inline const uint32_t* texels(const AtlasEntry& tex) const {
+        return this->atlas.texels(tex, MORTON);
+    }
+
+    inline Shader shader(uint32_t fog_weight) const {
+        return Shader{&this->fog, fog_weight};
+    }
+
+    inline uint32_t* row(int y) const {
+        return this->target.row(y);
+    }
+
+    inline uint32_t* column(int x) const {
+        return this->target.column(x);
+    }
+
+    const TextureAtlas& atlas;
+    const FogTable& fog;
+    PBO& target;
+};
+
+///
+/// Floor and ceiling rows of palette indices, shaded dark and fogged by the
+/// colormap of their row
+///
+struct IndexedRows {
+    typedef uint8_t Pixel;
+
+    struct Shader {
+        const uint8_t* colormap;
+
+        inline uint8_t operator()(uint8_t index) const {
+            return this->colormap[index];
+        }
+    };
+
+    IndexedRows(const TextureAtlas& atlas, const Palette& palette, PBO& target):
+        atlas(atlas),
+        palette(palette),
+        target(target)
+    {};
+
+    inline const uint8_t* texels(const AtlasEntry& tex) const {
+        return this->atlas.indices(tex, MORTON);
+    }
+
+    inline Shader shader(uint32_t fog_weight) const {
+        return Shader{this->palette.colormap(PALETTE_SHADE_DARK, fog_weight)};
+    }
+
+    inline uint8_t* row(int y) const {
+        return this->target.indexedRow(y);
+    }
+
+    inline uint8_t* column(int x) const {
+        return this->target.indexedColumn(x);
+    }
+
+    const TextureAtlas& atlas;
+    const Palette& palette;
+    PBO& target;
+};
+
+///
+/// Per row terms of a strip of floor and ceiling rows, in the pixel format of Rows
+///
+template <typename Rows>
+struct RowScratch {
+    // World space fixed point position and step of each row
+    vector<uint32_t> x;
+    vector<uint32_t> y;
+    vector<uint32_t> step_x;
+    vector<uint32_t> step_y;
+    vector<typename Rows::Shader> shader;
+    // Mip levels of the floor and ceiling textures each row samples
+    vector<const AtlasEntry*> floor_tex;
+    vector<const AtlasEntry*> ceiling_tex;
+    vector<const typename Rows::Pixel*> floor_texels;
+    vector<const typename Rows::Pixel*> ceiling_texels;
+
+    void resize(int rows) {
+        this->x.resize(rows);
+        this->y.resize(rows);
+        this->step_x.resize(rows);
+        this->step_y.resize(rows);
+        this->shader.resize(rows);
+        this->floor_tex.resize(rows);
+        this->ceiling_tex.resize(rows);
+        this->floor_texels.resize(rows);
+        this->ceiling_texels.resize(rows);
+    }
+};
+
+///
+/// Working storage of one render worker, sized with the frame so that
+/// rendering a strip allocates nothing
+///
+struct FrameScratch {
+    // Wall column of a row major target, copied in once it is sampled
+    vector<uint32_t> column;
+    vector<uint8_t> indexed_column;
+    RowScratch<TrueColourRows> true_colour_rows;
+    RowScratch<IndexedRows> indexed_rows;
+    QSPTree::QueryScratch query;
+};
+
+///
+/// Stages of a frame on the software target: wall columns, then floor and
+/// ceiling rows, then sprites over them. Holds the per column and per row
+/// buffers the stages pass between them and each worker's scratch, sized by
+/// resize once the pool is started. The world, textures, target and worker
+/// pool belong to the caller and have to outlive the renderer
+///
+class FrameRenderer {
+    public:
+        FrameRenderer();
+
+        void resize(int width, int height);
+        void renderWallsFloorCeiling(const ViewModel::Camera& view);
+        void renderSprites(const ViewModel::Camera& view);
+
+        const World* world;
+        const TextureAtlas* atlas;
+        PBO* target;
+        WorkerPool* pool;
+
+        Palette palette;
+        FogTable fog;
+        OccupancyGrid occupancy;
+        // Walls are found by leaping through the occupancy grid's empty levels rather than in ray packets
+        bool skip_empty_space;
+        QSPTree qsp_tree;
+
+        // Pixels
+        int width;
+        int height;
+        RayBuffer rays;
+        vector<RayHit> ray_hits;
+        RayHitBuffer wall_hits;
+        // Wall distance of each column, the sprites are depth tested against it
+        ZBuffer z_buffer;
+        HiZBuffer hi_z;
+        SpanBuffer wall_span_top;
+        SpanBuffer wall_span_bottom;
+        ViewTables view_tables;
+        SpriteQueue sprite_queue;
+        // One per worker of the pool
+        vector<FrameScratch> scratch;
+    private:
+        void renderWallColumns(const ViewModel::Camera& view, FrameScratch& scratch, int x_start, int x_end);
+        template <typename Rows>
+        void renderFloorCeilingRows(const ViewModel::Camera& view, const Rows& out, RowScratch<Rows>& scratch, int y_start, int y_end);
+        void renderUnsampledRows();
+};
+
+FrameRenderer::FrameRenderer():
+    world(nullptr),
+    atlas(nullptr),
+    target(nullptr),
+    pool(nullptr),
+    skip_empty_space(false),
+    width(0),
+    height(0)
+{};
+
+///
+/// Size the per column and per row buffers, and the scratch of every worker of
+/// the pool, for frames of a new size. Shrinking and growing back reuses their storage
+///
+/// @param int width: Pixels
+/// @param int height: Pixels
+///
+/// @return void
+///
+void FrameRenderer::resize(int width, int height) {
+    this->width = width;
+    this->height = height;
+    this->rays.resize(width);
+    this->ray_hits.resize(width);
+    this->wall_hits.resize(width);
+    this->z_buffer.resize(width);
+    this->wall_span_top.resize(width);
+    this->wall_span_bottom.resize(width);
+    this->view_tables.rebuild(width, height);
+    // Workers get strips of at most all the columns, or all the rows below the horizon
+    this->scratch.resize(max(this->pool != nullptr ? this->pool->size() : 0, 1));
+    for (FrameScratch& worker : this->scratch) {
+        worker.column.resize(height);
+        worker.indexed_column.resize(height);
+        worker.true_colour_rows.resize(height - IDIV_2(height));
+        worker.indexed_rows.resize(height - IDIV_2(height));
+    }
+}
+
+///
+/// Trace and texture the wall columns [x_start, x_end), recording the depth
+/// and the rows covered by the wall in each
+///
+/// @param Camera view: Position, direction and camera plane of the frame
+/// @param FrameScratch scratch: Working storage of the worker rendering the strip
+/// @param int x_start: First column (inclusive)
+/// @param int x_end: Last column (exclusive)
+///
+/// @return void
+///
+void FrameRenderer::renderWallColumns(const ViewModel::Camera& view, FrameScratch& scratch, int x_start, int x_end) {
+    double ray_dir_x, ray_dir_y, perp_wall_dist, wall_x, step, tex_pos;
+    int side, line_height, draw_start_pos, draw_end_pos, span_height, tex_coord_x;
+    double camera_x;
+    const double max_dist = renderCfg.render_distance > 0 ? renderCfg.render_distance : numeric_limits<double>::infinity();
+    ColumnSpan span;
+    uint32_t* column_out = nullptr;
+    uint8_t* indexed_out = nullptr;
+    // Column major targets are written in place, otherwise through a scratch column
+    const bool column_major = this->target->isColumnMajor();
+    const bool indexed = this->target->isIndexed();
+    vector<uint32_t>& column = scratch.column;
+    vector<uint8_t>& indexed_column = scratch.indexed_column;
+    // The strip is traced up front into wall_hits, which the texturing pass below reads back
+    for (int x = x_start; x < x_end; x++) {
+        camera_x = this->view_tables.camera_x[x];
+        this->rays[x] = CameraRay{
+            view.x,
+            view.y,
+            view.frustrum.getFovX() + view.clip_plane_x * camera_x,
+            view.frustrum.getFovY() + view.clip_plane_y * camera_x
+        };
+    }
+    if (renderCfg.wall_query == ConfigSection::WallQuery::QSP) {
+        this->qsp_tree.queryWalls(this->rays, x_start, x_end, this->ray_hits, scratch.query, max_dist);
+        for (int x = x_start; x < x_end; x++) {
+            this->wall_hits.set(x, this->ray_hits[x]);
+        }
+    } else if (this->skip_empty_space) {
+        for (int x = x_start; x < x_end; x++) {
+            this->wall_hits.set(x, castRayHierarchical(this->rays[x].origin_x, this->rays[x].origin_y, this->rays[x].dir_x, this->rays[x].dir_y, this->occupancy, max_dist));
+        }
+    } else {
+        // Neighbouring columns mostly cross the same cells, so they are stepped together in packets
+        castRays(this->rays, x_start, x_end, this->occupancy, this->wall_hits, max_dist);
+        // Rays out through an open map edge stop on the cell past it, they leave the map as castRayHierarchical's do
+        for (int x = x_start; x < x_end; x++) {
+            if ((unsigned) this->wall_hits.map_x[x] >= (unsigned) this->world->map_width || (unsigned) this->wall_hits.map_y[x] >= (unsigned) this->world->map_height) {
+                this->wall_hits.in_range[x] = false;
+                this->wall_hits.perp_wall_dist[x] = max_dist;
+            }
+        }
+    }
+
+    for (int x = x_end - 1; x >= x_start; x--) {
+        ray_dir_x = this->rays[x].dir_x;
+        ray_dir_y = this->rays[x].dir_y;
+        side = this->wall_hits.side[x];
+        perp_wall_dist = this->wall_hits.perp_wall_dist[x];
+        this->z_buffer[x] = perp_wall_dist;
+        if (!renderCfg.render_walls) {
+            this->wall_span_top[x] = 0;
+            this->wall_span_bottom[x] = 0;
+            continue;
+        }
+        line_height = (int)(this->height / perp_wall_dist);
+
+        draw_start_pos = IDIV_2(-line_height) + IDIV_2(this->height);
+        if (draw_start_pos < 0) {
+            draw_start_pos = 0;
+        }
+        draw_end_pos = IDIV_2(line_height) + IDIV_2(this->height);
+        if (draw_end_pos >= this->height) {
+            draw_end_pos = this->height - 1;
+        }
+        this->wall_span_top[x] = draw_start_pos;
+        this->wall_span_bottom[x] = draw_end_pos;
+        span_height = draw_end_pos - draw_start_pos;
+        if (span_height <= 0) {
+            continue;
+        }
+        if (indexed) {
+            indexed_out = column_major ? this->target->indexedColumn(x) + draw_start_pos : indexed_column.data();
+        } else {
+            column_out = column_major ? this->target->column(x) + draw_start_pos : column.data();
+        }
+        if (!this->wall_hits.in_range[x]) {
+            // Nothing within the render distance, the column ends in a wall of solid fog
+            if (indexed) {
+                fill(indexed_out, indexed_out + span_height, this->palette.fogIndex());
+                if (!column_major) {
+                    this->target->writeIndexedColumn(x, draw_start_pos, span_height, indexed_column.data());
+                }
+                continue;
+            }
+            fill(column_out, column_out + span_height, this->fog.colour);
+            if (!column_major) {
+                this->target->writeColumn(x, draw_start_pos, span_height, column.data());
+            }
+            continue;
+        }
+
+        const Constructs::AABB& wall = this->world->getAt(this->wall_hits.map_x[x], this->wall_hits.map_y[x]);
+        // Far walls sample the mip level with about one texel row per pixel
+        const AtlasEntry& full_tex = this->atlas->entry(wall.wf_left.texture);
+        const AtlasEntry& wall_tex = this->atlas->level(wall.wf_left.texture,
+            TextureAtlas::mipLevel(full_tex, double(full_tex.height) / line_height));
+        // Column major, so the rows of a texture column are consecutive texels
+        const uint32_t* wall_texels = this->atlas->texels(wall_tex, COLUMN_MAJOR);
+
+        wall_x = side == 0 ? view.y + perp_wall_dist * ray_dir_y : view.x + perp_wall_dist * ray_dir_x;
+        wall_x -= floor((wall_x));
+
+        tex_coord_x = (int)(wall_x * double(wall_tex.width));
+        if (side == 0 && ray_dir_x > 0) {
+            tex_coord_x = wall_tex.width - tex_coord_x - 1;
+        }
+        if (side == 1 && ray_dir_y < 0) {
+            tex_coord_x = wall_tex.width - tex_coord_x - 1;
+        }
+
+        step = 1.0 * wall_tex.height / line_height;
+        tex_pos = (draw_start_pos - IDIV_2(this->height) + IDIV_2(line_height)) * step;
+
+        // The target is stored rotated, so the span is sampled bottom up from its last texel.
+        // Shading is folded into a shift and mask so the sampler has no branch
+        span.texels = wall_texels + (tex_coord_x << wall_tex.height_shift);
+        span.width_shift = 0;
+        span.row_shift = 32 - wall_tex.height_shift;
+        span.v_step = 0u - toColumnV(step, wall_tex.height_shift);
+        span.v = toColumnV(tex_pos, wall_tex.height_shift) - span.v_step * (span_height - 1);
+        span.shade_shift = side;
+        span.shade_mask = side == 1 ? DARK_SHADER : 0xFFFFFFFF;
+        if (indexed) {
+            // Side shading and fog are both in the colormap
+            sampleIndexedColumn(span, this->atlas->indices(wall_tex, COLUMN_MAJOR) + (tex_coord_x << wall_tex.height_shift),
+                this->palette.colormap(side == 1 ? PALETTE_SHADE_DARK : 0, this->fog.weight(perp_wall_dist)), indexed_out, span_height);
+            if (!column_major) {
+                this->target->writeIndexedColumn(x, draw_start_pos, span_height, indexed_column.data());
+            }
+            continue;
+        }
+        sampleColumn(span, column_out, span_height);
+        this->fog.blendSpan(column_out, span_height, this->fog.weight(perp_wall_dist));
+        if (!column_major) {
+            this->target->writeColumn(x, draw_start_pos, span_height, column.data());
+        }
+    }
+}
+
+///
+/// Sample a floor or ceiling texture at an 8.24 fixed point world position,
+/// only the fraction is used so positions may wrap. Texels are in Morton order
+/// so rows at any angle stay within a few cache lines
+///
+/// @param AtlasEntry tex: Texture dimensions
+/// @param uint32_t* swizzle: Morton swizzle tables of the texture, x then y
+/// @param Texel* texels: Texture texels in Morton order, packed colours or palette indices
+/// @param uint32_t world_x: X position in 8.24 world units
+/// @param uint32_t world_y: Y position in 8.24 world units
+///
+/// @return Texel: Texel at the position
+///
+template <typename Texel>
+inline static Texel sampleFlat(const AtlasEntry& tex, const uint32_t* swizzle, const Texel* texels, uint32_t world_x, uint32_t world_y) {
+    return texels[swizzle[(world_x >> (24 - tex.width_shift)) & tex.width_mask]
+        | swizzle[tex.width + ((world_y >> (24 - tex.height_shift)) & tex.height_mask)]];
+}
+
+///
+/// Render floor and ceiling as horizontal scanlines. Each row below the horizon
+/// has a constant distance, so its world step is computed once and the row is
+/// walked with 8.24 fixed point adds in world units. The ceiling is the same row
+/// mirrored about the horizon and may use a texture of a different size.
+/// Rows further away sample smaller mip levels of the textures.
+/// Pixels inside a column's wall span are skipped. Column major targets walk
+/// all rows of the strip a column at a time, so each column is written in order
+///
+/// @tparam Rows: TrueColourRows or IndexedRows, the pixel format of the frame
+/// @param Camera view: Position, direction and camera plane of the frame
+/// @param Rows out: Texels, shading and rows of the target in its pixel format
+/// @param RowScratch scratch: Per row terms of the worker rendering the strip
+/// @param int y_start: First row below the horizon to render (inclusive)
+/// @param int y_end: Last row to render (exclusive)
+///
+/// @return void
+///
+template <typename Rows>
+void FrameRenderer::renderFloorCeilingRows(const ViewModel::Camera& view, const Rows& out, RowScratch<Rows>& scratch, int y_start, int y_end) {
+    typedef typename Rows::Pixel Pixel;
+    const AtlasEntry& floor_full = this->atlas->entry(this->world->floor_texture);
+    const AtlasEntry& ceiling_full = this->atlas->entry(this->world->ceiling_texture);
+    const double ray_dir_x0 = view.frustrum.getFovX() - view.clip_plane_x;
+    const double ray_dir_y0 = view.frustrum.getFovY() - view.clip_plane_y;
+    const double ray_dir_x1 = view.frustrum.getFovX() + view.clip_plane_x;
+    const double ray_dir_y1 = view.frustrum.getFovY() + view.clip_plane_y;
+    const double row_span = hypot(ray_dir_x1 - ray_dir_x0, ray_dir_y1 - ray_dir_y0);
+    const int rows = y_end - y_start;
+    double dist, step_scale, footprint;
+    uint32_t world_x, world_y;
+    Pixel *ceiling_out, *floor_out;
+    int y, mirror_y;
+
+    // World space fixed point per row, only the fraction is sampled so wrapping is harmless.
+    // Each row is at one distance, so it also has a single fog weight and shader
+    vector<uint32_t> &row_x = scratch.x, &row_y = scratch.y, &row_step_x = scratch.step_x, &row_step_y = scratch.step_y;
+    vector<typename Rows::Shader>& row_shader = scratch.shader;
+    vector<const AtlasEntry*> &row_floor_tex = scratch.floor_tex, &row_ceiling_tex = scratch.ceiling_tex;
+    vector<const Pixel*> &row_floor_texels = scratch.floor_texels, &row_ceiling_texels = scratch.ceiling_texels;
+    for (int i = 0; i < rows; i++) {
+        dist = this->view_tables.row_distance[y_start + i];
+        row_shader[i] = out.shader(this->fog.weight(dist));
+        step_scale = this->view_tables.row_step_scale[y_start + i];
+        // A pixel covers step_scale * row_span world units across the row and 2 * dist * step_scale
+        // into the distance. The mip level is picked for about one texel per pixel of that area
+        footprint = step_scale * sqrt(2 * dist * row_span);
+        row_floor_tex[i] = &this->atlas->level(this->world->floor_texture,
+            TextureAtlas::mipLevel(floor_full, footprint * max(floor_full.width, floor_full.height)));
+        row_ceiling_tex[i] = &this->atlas->level(this->world->ceiling_texture,
+            TextureAtlas::mipLevel(ceiling_full, footprint * max(ceiling_full.width, ceiling_full.height)));
+        row_floor_texels[i] = out.texels(*row_floor_tex[i]);
+        row_ceiling_texels[i] = out.texels(*row_ceiling_tex[i]);
+        row_x[i] = (uint32_t)(int64_t)((view.x + dist * ray_dir_x0) * 16777216.0);
+        row_y[i] = (uint32_t)(int64_t)((view.y + dist * ray_dir_y0) * 16777216.0);
+        row_step_x[i] = (uint32_t)(int64_t)(step_scale * (ray_dir_x1 - ray_dir_x0) * 16777216.0);
+        row_step_y[i] = (uint32_t)(int64_t)(step_scale * (ray_dir_y1 - ray_dir_y0) * 16777216.0);
+    }
+
+    if (this->target->isColumnMajor()) {
+        for (int x = 0; x < this->width; x++) {
+            ceiling_out = floor_out = out.column(x);
+            for (int i = 0; i < rows; i++) {
+                y = y_start + i;
+                world_x = row_x[i];
+                world_y = row_y[i];
+                row_x[i] += row_step_x[i];
+                row_y[i] += row_step_y[i];
+                if (y >= this->wall_span_top[x] && y < this->wall_span_bottom[x]) {
+                    continue;
+                }
+                ceiling_out[y] = row_shader[i](sampleFlat(*row_ceiling_tex[i], this->atlas->swizzle(*row_ceiling_tex[i]),
+                    row_ceiling_texels[i], world_x, world_y));
+
+                mirror_y = this->height - y;
+                if (mirror_y >= this->wall_span_top[x] && mirror_y < this->wall_span_bottom[x]) {
+                    continue;
+                }
+                floor_out[mirror_y] = row_shader[i](sampleFlat(*row_floor_tex[i], this->atlas->swizzle(*row_floor_tex[i]),
+                    row_floor_texels[i], world_x, world_y));
+            }
+        }
+        return;
+    }
+
+    for (int i = rows - 1; i >= 0; i--) {
+        y = y_start + i;
+        mirror_y = this->height - y;
+        ceiling_out = out.row(y);
+        floor_out = out.row(mirror_y);
+        world_x = row_x[i];
+        world_y = row_y[i];
+        const typename Rows::Shader shade = row_shader[i];
+        const AtlasEntry& floor_tex = *row_floor_tex[i];
+        const AtlasEntry& ceiling_tex = *row_ceiling_tex[i];
+        const Pixel* floor_texels = row_floor_texels[i];
+        const Pixel* ceiling_texels = row_ceiling_texels[i];
+        const uint32_t* floor_swizzle = this->atlas->swizzle(floor_tex);
+        const uint32_t* ceiling_swizzle = this->atlas->swizzle(ceiling_tex);
+
+        for (int x = 0; x < this->width; x++, world_x += row_step_x[i], world_y += row_step_y[i]) {
+            if (y >= this->wall_span_top[x] && y < this->wall_span_bottom[x]) {
+                continue;
+            }
+            ceiling_out[x] = shade(sampleFlat(ceiling_tex, ceiling_swizzle, ceiling_texels, world_x, world_y));
+
+            // The mirrored row may be covered by the wall, which always wins
+            if (mirror_y >= this->wall_span_top[x] && mirror_y < this->wall_span_bottom[x]) {
+                continue;
+            }
+            floor_out[x] = shade(sampleFlat(floor_tex, floor_swizzle, floor_texels, world_x, world_y));
+        }
+    }
+}
+
+
+///
+/// Fill the two rows the floor and ceiling pass leaves out, the horizon and
+/// the edge row it would mirror from past the bottom of the frame, with solid
+/// fog where no wall covers them. Streamed frames reuse a buffer several
+/// frames old, so every pixel has to be written
+///
+/// @return void
+///
+void FrameRenderer::renderUnsampledRows() {
+    const int rows[2] = {0, IDIV_2(this->height)};
+    const bool indexed = this->target->isIndexed();
+    for (int y : rows) {
+        for (int x = 0; x < this->width; x++) {
+            if (y >= this->wall_span_top[x] && y < this->wall_span_bottom[x]) {
+                continue;
+            }
+            if (indexed) {
+                this->target->writeIndexed(x, y, this->palette.fogIndex());
+            } else {
+                this->target->write(x, y, this->fog.colour);
+            }
+        }
+    }
+}
+
+
+///
+/// Render the wall columns in contiguous strips of RENDER_STRIP_ALIGN aligned
+/// columns, one per worker, then the floor and ceiling rows split the same way
+///
+/// @param Camera view: Position, direction and camera plane of the frame
+///
+/// @return void
+///
+void FrameRenderer::renderWallsFloorCeiling(const ViewModel::Camera& view) {
+    this->pool->run([this, &view](int worker, int worker_count) {
+        int x_start, x_end;
+        stripBounds(worker, worker_count, 0, this->width, RENDER_STRIP_ALIGN, x_start, x_end);
+        if (x_start < x_end) {
+            this->renderWallColumns(view, this->scratch[worker], x_start, x_end);
+        }
+    });
+    this->hi_z.build(this->z_buffer);
+    if (!renderCfg.render_floor_ceiling) {
+        return;
+    }
+    this->renderUnsampledRows();
+    this->pool->run([this, &view](int worker, int worker_count) {
+        int y_start, y_end;
+        stripBounds(worker, worker_count, IDIV_2(this->height) + 1, this->height, 1, y_start, y_end);
+        if (y_start < y_end && this->target->isIndexed()) {
+            this->renderFloorCeilingRows(view, IndexedRows(*this->atlas, this->palette, *this->target),
+                this->scratch[worker].indexed_rows, y_start, y_end);
+        } else if (y_start < y_end) {
+            this->renderFloorCeilingRows(view, TrueColourRows(*this->atlas, this->fog, *this->target),
+                this->scratch[worker].true_colour_rows, y_start, y_end);
+        }
+    });
+}
+
+
+///
+/// Draw the sprites far to near over the walls, depth tested against the
+/// z buffer the walls left behind
+///
+/// @param Camera view: Position, direction and camera plane of the frame
+///
+/// @return void
+///
+void FrameRenderer::renderSprites(const ViewModel::Camera& view) {
+    // Sprites out of view are culled up front, the rest come far to near in runs of one texture
+    this->sprite_queue.update(this->world->sprites, view.x, view.y, view, this->width, this->height,
+        this->fog.enabled() ? this->fog.end : numeric_limits<double>::infinity());
+    const vector<SpriteDraw>& draws = this->sprite_queue.draws();
+
+    double transform_x, transform_y;
+    int sprite_screen_x, vert_move_screen, sprite_height, sprite_width, draw_start_pos_y, draw_end_pos_y, draw_start_pos_x, draw_end_pos_x, tex_coord_x, tex_coord_y, d;
+    uint32_t color, fog_weight;
+    uint8_t index;
+    const bool indexed = this->target->isIndexed();
+    for (const SpriteBatch& batch : this->sprite_queue.batches()) {
+        const AtlasEntry& tex = this->atlas->entry(batch.texture);
+        // Sprites are drawn a column at a time, from column major texels
+        const uint32_t* texels = this->atlas->texels(tex, COLUMN_MAJOR);
+        const uint8_t* indices = indexed ? this->atlas->indices(tex, COLUMN_MAJOR) : nullptr;
+        for (uint32_t i = batch.first; i < batch.first + batch.count; i++) {
+            transform_x = draws[i].transform_x;
+            transform_y = draws[i].transform_y;
+            fog_weight = this->fog.weight(transform_y);
+            const uint8_t* colormap = indexed ? this->palette.colormap(0, fog_weight) : nullptr;
+
+            sprite_screen_x = (int)(IDIV_2(this->width) * (1 + transform_x / transform_y));
+
+            vert_move_screen = (int)(SPRITE_V_MOVE / transform_y);
+
+            sprite_height = abs((int)(this->height / (transform_y))) / SPRITE_V_DIV;
+            draw_start_pos_y = -IDIV_2(sprite_height) + IDIV_2(this->height) + vert_move_screen;
+            // Rows are written mirrored as (height - y), so y = 0 would land outside the buffer
+            if (draw_start_pos_y < 1) {
+                draw_start_pos_y = 1;
+            }
+            draw_end_pos_y = IDIV_2(sprite_height) + IDIV_2(this->height) + vert_move_screen;
+            if (draw_end_pos_y >= this->height) {
+                draw_end_pos_y = this->height - 1;
+            }
+
+            sprite_width = abs((int)(this->height / (transform_y))) / SPRITE_U_DIV;
+            draw_start_pos_x = IDIV_2(-sprite_width) + sprite_screen_x;
+            // Column 0 is never drawn
+            if (draw_start_pos_x < 1) {
+                draw_start_pos_x = 1;
+            }
+            draw_end_pos_x = IDIV_2(sprite_width) + sprite_screen_x;
+            if (draw_end_pos_x >= this->width) {
+                draw_end_pos_x = this->width - 1;
+            }
+            // Drop the sprite if it is behind the walls throughout, otherwise trim the tiles at either end it is hidden in
+            if (!this->hi_z.visibleSpan(draw_start_pos_x, draw_end_pos_x, transform_y)) {
+                continue;
+            }
+            for (int pixel_row = draw_end_pos_x - 1; pixel_row >= draw_start_pos_x; pixel_row--) {
+                if (transform_y >= this->z_buffer[pixel_row]) {
+                    continue;
+                }
+                tex_coord_x = (int)IDIV_256((IMUL_256((pixel_row - (IDIV_2(-sprite_width) + sprite_screen_x))) * (int) tex.width / sprite_width));
+                if (indexed) {
+                    // Only black quantizes to the transparent index, so the same texels are skipped
+                    for (int pixel_column = draw_end_pos_y - 1; pixel_column >= draw_start_pos_y; pixel_column--) {
+                        d = IMUL_256((pixel_column - vert_move_screen)) - IMUL_128(this->height) + IMUL_128(sprite_height);
+                        tex_coord_y = IDIV_256((d * (int) tex.height) / sprite_height);
+                        index = indices[(tex_coord_x << tex.height_shift) + tex_coord_y];
+                        if (index != PALETTE_TRANSPARENT) {
+                            this->target->writeIndexed(pixel_row, this->height - pixel_column, colormap[index]);
+                        }
+                    }
+                    continue;
+                }
+                for (int pixel_column = draw_end_pos_y - 1; pixel_column >= draw_start_pos_y; pixel_column--) {
+                    d = IMUL_256((pixel_column - vert_move_screen)) - IMUL_128(this->height) + IMUL_128(sprite_height);
+                    tex_coord_y = IDIV_256((d * (int) tex.height) / sprite_height);
+                    color = texels[(tex_coord_x << tex.height_shift) + tex_coord_y];
+                    if ((color & 0x00FFFFFF) != 0) {
+                        this->target->write(pixel_row, this->height - pixel_column, fog_weight ? this->fog.blend(color, fog_weight) : color);
+                    }
+                }
+            }
+        }
+    }
+}
+}
@@ -0,0 +1,234 @@
+#pragma once
+
+#include <math.h>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "../Globals.hpp"
+
+using namespace std;
+
+namespace Rendering {
+
+// log2 of the screen columns per tile, 16 columns keeps tiles on the render strip boundaries
+#define HIZ_TILE_SHIFT 4
+
+///
+/// Hierarchical depth of the walls drawn in a frame. Level 0 holds the nearest and
+/// furthest wall of every tile of columns, each level above the nearest and furthest
+/// of two tiles of the level below. Any column range is covered by at most two tiles
+/// of one level, so checking whether something at a given depth is behind the walls
+/// across a range costs the same however wide it is. Answers are conservative: a
+/// range reported occluded is hidden in every column, but not every hidden range is
+/// reported. Rebuild after every wall pass
+///
+class HiZBuffer {
+    public:
+        HiZBuffer();
+
+        void build(const ZBuffer& depth, int tile_shift = HIZ_TILE_SHIFT);
+
+        inline double nearest(int x_start, int x_end) const;
+        inline double furthest(int x_start, int x_end) const;
+        inline bool occluded(int x_start, int x_end, double depth) const;
+        inline bool unoccluded(int x_start, int x_end, double depth) const;
+        bool visibleSpan(int& x_start, int& x_end, double depth) const;
+        inline bool visible(int x, double depth) const;
+        bool visible(double transform_x, double transform_y) const;
+        int levels() const;
+
+        // Screen columns
+        int width;
+        int tile_shift;
+    private:
+        inline int level(int tile_start, int tile_end) const;
+
+        vector<double> columns;
+        vector<vector<double> > near_levels;
+        vector<vector<double> > far_levels;
+};
+
+HiZBuffer::HiZBuffer():
+    width(0),
+    tile_shift(HIZ_TILE_SHIFT)
+{};
+
+///
+/// Rebuild every level from the wall distances of a frame
+///
+/// @param ZBuffer depth: Distance to the wall in every screen column, infinite where there is none
+/// @param int tile_shift: log2 of the columns per tile
+///
+/// @return void
+///
+void HiZBuffer::build(const ZBuffer& depth, int tile_shift) {
+    this->width = (int) depth.size();
+    this->tile_shift = tile_shift;
+    this->columns.assign(depth.begin(), depth.end());
+
+    int tiles = max((this->width + (1 << tile_shift) - 1) >> tile_shift, 1);
+    int level_count = 1;
+    while ((1 << (level_count - 1)) < tiles) {
+        level_count++;
+    }
+    this->near_levels.resize(level_count);
+    this->far_levels.resize(level_count);
+    this->near_levels[0].assign(tiles, numeric_limits<double>::infinity());
+    this->far_levels[0].assign(tiles, -numeric_limits<double>::infinity());
+    for (int x = 0; x < this->width; x++) {
+        double& near_depth = this->near_levels[0][x >> tile_shift];
+        double& far_depth = this->far_levels[0][x >> tile_shift];
+        near_depth = min(near_depth, depth[x]);
+        far_depth = max(far_depth, depth[x]);
+    }
+    for (int l = 1; l < level_count; l++) {
+        const vector<double>& near_below = this->near_levels[l - 1];
+        const vector<double>& far_below = this->far_levels[l - 1];
+        int count = ((int) near_below.size() + 1) / 2;
+        this->near_levels[l].resize(count);
+        this->far_levels[l].resize(count);
+        for (int i = 0; i < count; i++) {
+            bool pair = 2 * i + 1 < (int) near_below.size();
+            this->near_levels[l][i] = pair ? min(near_below[2 * i], near_below[2 * i + 1]) : near_below[2 * i];
+            this->far_levels[l][i] = pair ? max(far_below[2 * i], far_below[2 * i + 1]) : far_below[2 * i];
+        }
+    }
+};
+
+///
+/// Lowest level at which two tiles are at most one node apart
+///
+/// @param int tile_start: First tile of a range
+/// @param int tile_end: Last tile of a range, inclusive
+///
+/// @return int
+///
+inline int HiZBuffer::level(int tile_start, int tile_end) const {
+    // Above the highest bit the two differ in, both tiles share a node or sit in neighbouring ones
+    return tile_start == tile_end ? 0 : 31 - __builtin_clz((unsigned int) (tile_start ^ tile_end));
+}
+
+///
+/// @param int x_start: First column
+/// @param int x_end: One past the last column
+///
+/// @return double: At most the nearest wall in the columns, infinite for an empty range
+///
+inline double HiZBuffer::nearest(int x_start, int x_end) const {
+    x_start = max(x_start, 0);
+    x_end = min(x_end, this->width);
+    if (x_start >= x_end) {
+        return numeric_limits<double>::infinity();
+    }
+    int tile_start = x_start >> this->tile_shift;
+    int tile_end = (x_end - 1) >> this->tile_shift;
+    int l = this->level(tile_start, tile_end);
+    const vector<double>& nodes = this->near_levels[l];
+    return min(nodes[tile_start >> l], nodes[tile_end >> l]);
+}
+
+///
+/// @param int x_start: First column
+/// @param int x_end: One past the last column
+///
+/// @return double: At least the furthest wall in the columns, negative infinity for an empty range
+///
+inline double HiZBuffer::furthest(int x_start, int x_end) const {
+    x_start = max(x_start, 0);
+    x_end = min(x_end, this->width);
+    if (x_start >= x_end) {
+        return -numeric_limits<double>::infinity();
+    }
+    int tile_start = x_start >> this->tile_shift;
+    int tile_end = (x_end - 1) >> this->tile_shift;
+    int l = this->level(tile_start, tile_end);
+    const vector<double>& nodes = this->far_levels[l];
+    return max(nodes[tile_start >> l], nodes[tile_end >> l]);
+}
+
+///
+/// True if something at a depth is behind the walls in every column of a range,
+/// as the renderer's depth test (depth < zBuf[x]) would find
+///
+/// @param int x_start: First column
+/// @param int x_end: One past the last column
+/// @param double depth: Distance to the camera plane
+///
+/// @return bool
+///
+inline bool HiZBuffer::occluded(int x_start, int x_end, double depth) const {
+    return depth >= this->furthest(x_start, x_end);
+}
+
+///
+/// True if something at a depth is in front of the walls in every column of a range
+///
+/// @param int x_start: First column
+/// @param int x_end: One past the last column
+/// @param double depth: Distance to the camera plane
+///
+/// @return bool
+///
+inline bool HiZBuffer::unoccluded(int x_start, int x_end, double depth) const {
+    return depth < this->nearest(x_start, x_end);
+}
+
+///
+/// Narrow a column range by dropping whole tiles at either end that are
+/// behind the walls at a depth
+///
+/// @param int& x_start: First column, moved right past occluded tiles
+/// @param int& x_end: One past the last column, moved left past occluded tiles
+/// @param double depth: Distance to the camera plane
+///
+/// @return bool: False if nothing of the range is left
+///
+bool HiZBuffer::visibleSpan(int& x_start, int& x_end, double depth) const {
+    x_start = max(x_start, 0);
+    x_end = min(x_end, this->width);
+    const vector<double>& tiles = this->far_levels[0];
+    while (x_start < x_end && depth >= tiles[x_start >> this->tile_shift]) {
+        x_start = ((x_start >> this->tile_shift) + 1) << this->tile_shift;
+    }
+    while (x_start < x_end && depth >= tiles[(x_end - 1) >> this->tile_shift]) {
+        x_end = ((x_end - 1) >> this->tile_shift) << this->tile_shift;
+    }
+    return x_start < x_end;
+};
+
+///
+/// @param int x: Screen column
+/// @param double depth: Distance to the camera plane
+///
+/// @return bool: True if something at the depth is in front of the wall in the column
+///
+inline bool HiZBuffer::visible(int x, double depth) const {
+    return x >= 0 && x < this->width && depth < this->columns[x];
+}
+
+///
+/// Whether a point in camera space, as sprites are transformed to, shows in front
+/// of the walls. For line of sight checks from the player, hitscan or otherwise
+///
+/// @param double transform_x: Offset across the view, the screen edges are at -transform_y and transform_y
+/// @param double transform_y: Distance to the camera plane
+///
+/// @return bool
+///
+bool HiZBuffer::visible(double transform_x, double transform_y) const {
+    if (!(transform_y > 0) || fabs(transform_x) > transform_y) {
+        return false;
+    }
+    int x = (int) (this->width / 2 * (1 + transform_x / transform_y));
+    return this->visible(min(x, this->width - 1), transform_y);
+};
+
+///
+/// @return int: Levels built, including the tiles
+///
+int HiZBuffer::levels() const {
+    return (int) this->near_levels.size();
+};
+}
@@ -0,0 +1,264 @@
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "DDA.hpp"
+
+using namespace std;
+
+namespace Rendering {
+
+// Pyramid levels, level l marks 4^l * 4^l cell blocks holding any wall (1, 4 and 16 cells)
+#define OCCUPANCY_LEVELS 3
+// log2 of the cells per block side one level up
+#define OCCUPANCY_LEVEL_SHIFT 2
+
+///
+/// Mip-mapped occupancy bitmasks of a map. Level 0 has one bit per cell, each
+/// level above one bit per 4x4 block of the level below, set if any of them is.
+/// Rays leap across blocks that are clear at the coarsest level and only step
+/// cell by cell next to walls. Rebuild whenever the walls change
+///
+class OccupancyGrid {
+    public:
+        OccupancyGrid();
+
+        template <typename IsWall>
+        void rebuild(int width, int height, const IsWall& is_wall);
+
+        inline bool occupied(int level, int x, int y) const;
+        inline bool operator()(int x, int y) const;
+        inline const uint64_t* cells() const;
+        size_t bytes() const;
+
+        int width;
+        int height;
+    private:
+        vector<uint64_t> bits[OCCUPANCY_LEVELS];
+        int level_width[OCCUPANCY_LEVELS];
+        int level_height[OCCUPANCY_LEVELS];
+};
+
+OccupancyGrid::OccupancyGrid():
+    width(0),
+    height(0)
+{
+    fill(this->level_width, this->level_width + OCCUPANCY_LEVELS, 0);
+    fill(this->level_height, this->level_height + OCCUPANCY_LEVELS, 0);
+};
+
+///
+/// Rebuild every level from the cells of a map
+///
+/// @param int width: Map width in cells
+/// @param int height: Map height in cells
+/// @param IsWall is_wall: Callable (int x, int y) -> bool
+///
+/// @return void
+///
+template <typename IsWall>
+void OccupancyGrid::rebuild(int width, int height, const IsWall& is_wall) {
+    this->width = width;
+    this->height = height;
+    for (int level = 0; level < OCCUPANCY_LEVELS; level++) {
+        int block = 1 << (level * OCCUPANCY_LEVEL_SHIFT);
+        this->level_width[level] = (width + block - 1) / block;
+        this->level_height[level] = (height + block - 1) / block;
+        size_t count = (size_t) this->level_width[level] * this->level_height[level];
+        this->bits[level].assign((count + 63) / 64, 0);
+    }
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            if (!is_wall(x, y)) {
+                continue;
+            }
+            for (int level = 0; level < OCCUPANCY_LEVELS; level++) {
+                int shift = level * OCCUPANCY_LEVEL_SHIFT;
+                size_t i = (size_t) (y >> shift) * this->level_width[level] + (x >> shift);
+                this->bits[level][i >> 6] |= uint64_t(1) << (i & 63);
+            }
+        }
+    }
+};
+
+///
+/// @param int level: Pyramid level
+/// @param int x: Block column at that level
+/// @param int y: Block row at that level
+///
+/// @return bool: True if any cell of the block is a wall
+///
+inline bool OccupancyGrid::occupied(int level, int x, int y) const {
+    size_t i = (size_t) y * this->level_width[level] + x;
+    return (this->bits[level][i >> 6] >> (i & 63)) & 1;
+}
+
+///
+/// Cell lookup, so the grid can stand in for a map's walls when casting rays.
+/// Cells outside the map are walls, so rays out through an open edge stop on
+/// the first cell past it
+///
+/// @param int x: Cell column
+/// @param int y: Cell row
+///
+/// @return bool: True if the cell is a wall or outside the map
+///
+inline bool OccupancyGrid::operator()(int x, int y) const {
+    return (unsigned) x >= (unsigned) this->width || (unsigned) y >= (unsigned) this->height || this->occupied(0, x, y);
+}
+
+///
+/// @return uint64_t*: Level 0 bitmask, bit y * width + x set for a wall cell
+///
+inline const uint64_t* OccupancyGrid::cells() const {
+    return this->bits[0].data();
+}
+
+///
+/// @return size_t: Memory held by the bitmasks of every level
+///
+size_t OccupancyGrid::bytes() const {
+    size_t total = 0;
+    for (int level = 0; level < OCCUPANCY_LEVELS; level++) {
+        total += this->bits[level].size() * sizeof(uint64_t);
+    }
+    return total;
+};
+
+///
+/// Step a ray through an occupancy pyramid. From each cell it leaves the
+/// largest empty block containing it in one step, the exit is found from the
+/// block edges rather than by stepping the cells between. Next to walls this is
+/// the cell DDA, so hits match castRayDouble. Leaving the map is a miss
+///
+/// @param double origin_x: Ray origin in world units
+/// @param double origin_y: Ray origin in world units
+/// @param double dir_x: Ray direction, not normalised
+/// @param double dir_y: Ray direction, not normalised
+/// @param OccupancyGrid grid: Occupancy of the map
+/// @param double max_dist: Give up on walls further than this from the camera plane
+///
+/// @return RayHit
+///
+inline RayHit castRayHierarchical(double origin_x, double origin_y, double dir_x, double dir_y, const OccupancyGrid& grid,
+    double max_dist = numeric_limits<double>::infinity()) {
+    RayHit hit;
+    hit.map_x = (int) origin_x;
+    hit.map_y = (int) origin_y;
+    hit.side = 0;
+    hit.steps = 0;
+
+    const double inv_x = 1 / dir_x;
+    const double inv_y = 1 / dir_y;
+    const double delta_x = fabs(inv_x);
+    const double delta_y = fabs(inv_y);
+    const int step_x = copysign(1.0, dir_x);
+    const int step_y = copysign(1.0, dir_y);
+    const double inf = numeric_limits<double>::infinity();
+    int level = OCCUPANCY_LEVELS - 1;
+    int shift, block, block_x, block_y;
+    double exit_x, exit_y;
+
+    for (;;) {
+        if ((unsigned) hit.map_x >= (unsigned) grid.width || (unsigned) hit.map_y >= (unsigned) grid.height) {
+            hit.in_range = false;
+            hit.perp_wall_dist = max_dist;
+            return hit;
+        }
+        // Neighbours of an empty block are likely empty at the same level, so start one above it
+        level = min(level + 1, OCCUPANCY_LEVELS - 1);
+        while (level >= 0) {
+            if (!grid.occupied(level, hit.map_x >> (level * OCCUPANCY_LEVEL_SHIFT), hit.map_y >> (level * OCCUPANCY_LEVEL_SHIFT))) {
+                break;
+            }
+            level--;
+        }
+        if (level < 0) {
+            // As in the cell DDA the starting cell is never a hit, even if the camera is inside a wall
+            if (hit.steps > 0) {
+                break;
+            }
+            level = 0;
+        }
+        shift = level * OCCUPANCY_LEVEL_SHIFT;
+
+        // Distance along the ray to the far edges of the block on each axis
+        block = 1 << shift;
+        block_x = hit.map_x >> shift << shift;
+        block_y = hit.map_y >> shift << shift;
+        exit_x = dir_x == 0 ? inf : (block_x + (step_x > 0 ? block : 0) - origin_x) * inv_x;
+        exit_y = dir_y == 0 ? inf : (block_y + (step_y > 0 ? block : 0) - origin_y) * inv_y;
+
+        if (level == 0) {
+            // Next to a wall, step cells as the plain DDA does until a wall or the edge of the smallest block
+            block_x = hit.map_x >> OCCUPANCY_LEVEL_SHIFT;
+            block_y = hit.map_y >> OCCUPANCY_LEVEL_SHIFT;
+            for (;;) {
+                if (exit_x < exit_y) {
+                    if (exit_x > max_dist) {
+                        hit.in_range = false;
+                        hit.perp_wall_dist = max_dist;
+                        return hit;
+                    }
+                    exit_x += delta_x;
+                    hit.map_x += step_x;
+                    hit.side = 0;
+                } else {
+                    if (exit_y > max_dist) {
+                        hit.in_range = false;
+                        hit.perp_wall_dist = max_dist;
+                        return hit;
+                    }
+                    exit_y += delta_y;
+                    hit.map_y += step_y;
+                    hit.side = 1;
+                }
+                hit.steps++;
+                if ((hit.map_x >> OCCUPANCY_LEVEL_SHIFT) != block_x || (hit.map_y >> OCCUPANCY_LEVEL_SHIFT) != block_y
+                    || (unsigned) hit.map_x >= (unsigned) grid.width || (unsigned) hit.map_y >= (unsigned) grid.height) {
+                    break;
+                }
+                if (grid.occupied(0, hit.map_x, hit.map_y)) {
+                    goto found;
+                }
+            }
+            continue;
+        }
+
+        hit.steps++;
+        if (exit_x < exit_y) {
+            if (exit_x > max_dist) {
+                hit.in_range = false;
+                hit.perp_wall_dist = max_dist;
+                return hit;
+            }
+            hit.map_x = step_x > 0 ? block_x + block : block_x - 1;
+            hit.map_y = min(max((int) (origin_y + exit_x * dir_y), block_y), block_y + block - 1);
+            hit.side = 0;
+        } else {
+            if (exit_y > max_dist) {
+                hit.in_range = false;
+                hit.perp_wall_dist = max_dist;
+                return hit;
+            }
+            hit.map_y = step_y > 0 ? block_y + block : block_y - 1;
+            hit.map_x = min(max((int) (origin_x + exit_y * dir_x), block_x), block_x + block - 1);
+            hit.side = 1;
+        }
+    }
+
+found:
+    hit.in_range = true;
+    if (hit.side == 0) {
+        hit.perp_wall_dist = (hit.map_x - origin_x + (1 - step_x) / 2) / dir_x;
+    } else {
+        hit.perp_wall_dist = (hit.map_y - origin_y + (1 - step_y) / 2) / dir_y;
+    }
+    return hit;
+}
+}
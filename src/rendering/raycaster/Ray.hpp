@@ -31,4 +31,19 @@ Ray::Ray(float ax, float ay, float bx, float by, int line_width) {
     this->signX = (bx - ax < 0);
     this->signY = (by - ay < 0);
     this->line_width = line_width;
-};
\ No newline at end of file
+};
+
+namespace Rendering {
+
+///
+/// Ray through one screen column. The direction is the view direction plus an
+/// offset along the camera plane and is not normalised, so distances along it
+/// are perpendicular to the camera plane
+///
+struct CameraRay {
+    double origin_x;
+    double origin_y;
+    double dir_x;
+    double dir_y;
+};
+}
@@ -0,0 +1,553 @@
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+
+#include <limits>
+#include <vector>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__)) && !defined(RAY_PACKET_SCALAR)
+    #include <immintrin.h>
+    #define RAY_PACKET_X86 1
+#endif
+
+#include "DDA.hpp"
+#include "OccupancyGrid.cpp"
+#include "Ray.hpp"
+
+using namespace std;
+
+namespace Rendering {
+
+// Adjacent columns stepped in lockstep, one double lane each. Four fill an AVX2 register
+// of doubles, and their cells a 128 bit register of indices for the occupancy grid gather
+#define RAY_PACKET_WIDTH 4
+#define RAY_PACKET_LANES ((1 << RAY_PACKET_WIDTH) - 1)
+
+enum RayPacketLevel {
+    RAY_PACKET_NONE,
+    RAY_PACKET_SSE2,
+    RAY_PACKET_AVX2
+};
+
+///
+/// Wall hits of a row of screen columns, a field per array so the texturing
+/// pass reads each as a contiguous run. Step counts are not kept
+///
+struct RayHitBuffer {
+    vector<int> map_x;
+    vector<int> map_y;
+    vector<int> side;
+    vector<double> perp_wall_dist;
+    vector<uint8_t> in_range;
+
+    void resize(size_t count);
+    inline void set(size_t i, const RayHit& hit);
+    inline RayHit get(size_t i) const;
+};
+
+void RayHitBuffer::resize(size_t count) {
+    this->map_x.resize(count);
+    this->map_y.resize(count);
+    this->side.resize(count);
+    this->perp_wall_dist.resize(count);
+    this->in_range.resize(count);
+};
+
+inline void RayHitBuffer::set(size_t i, const RayHit& hit) {
+    this->map_x[i] = hit.map_x;
+    this->map_y[i] = hit.map_y;
+    this->side[i] = hit.side;
+    this->perp_wall_dist[i] = hit.perp_wall_dist;
+    this->in_range[i] = hit.in_range;
+}
+
+inline RayHit RayHitBuffer::get(size_t i) const {
+    RayHit hit;
+    hit.map_x = this->map_x[i];
+    hit.map_y = this->map_y[i];
+    hit.side = this->side[i];
+    hit.perp_wall_dist = this->perp_wall_dist[i];
+    hit.in_range = this->in_range[i] != 0;
+    hit.steps = 0;
+    return hit;
+}
+
+///
+/// Per lane DDA state of a packet, set up exactly as castRayDouble sets up one ray
+///
+struct RayPacketLanes {
+    alignas(32) double side_x[RAY_PACKET_WIDTH];
+    alignas(32) double side_y[RAY_PACKET_WIDTH];
+    alignas(32) double delta_x[RAY_PACKET_WIDTH];
+    alignas(32) double delta_y[RAY_PACKET_WIDTH];
+    alignas(16) int32_t map_x[RAY_PACKET_WIDTH];
+    alignas(16) int32_t map_y[RAY_PACKET_WIDTH];
+    alignas(16) int32_t step_x[RAY_PACKET_WIDTH];
+    alignas(16) int32_t step_y[RAY_PACKET_WIDTH];
+
+    RayPacketLanes() {
+    }
+
+    RayPacketLanes(const CameraRay* rays) {
+        for (int lane = 0; lane < RAY_PACKET_WIDTH; lane++) {
+            const CameraRay& ray = rays[lane];
+            int map_x = (int) ray.origin_x;
+            int map_y = (int) ray.origin_y;
+            this->map_x[lane] = map_x;
+            this->map_y[lane] = map_y;
+            this->delta_x[lane] = fabs(1 / ray.dir_x);
+            this->delta_y[lane] = fabs(1 / ray.dir_y);
+            this->step_x[lane] = (int) copysign(1.0, ray.dir_x);
+            this->step_y[lane] = (int) copysign(1.0, ray.dir_y);
+            this->side_x[lane] = this->delta_x[lane] * (ray.dir_x < 0 ? ray.origin_x - map_x : map_x + 1.0 - ray.origin_x);
+            this->side_y[lane] = this->delta_y[lane] * (ray.dir_y < 0 ? ray.origin_y - map_y : map_y + 1.0 - ray.origin_y);
+        }
+    }
+
+    ///
+    /// @param int lane: Lane to read
+    /// @param int sides: Bit per lane, set if its last crossing was a y facing edge
+    /// @param int steps: Cells stepped so far
+    ///
+    /// @return RayHit: The lane's cell, without a distance
+    ///
+    inline RayHit cell(int lane, int sides, int steps) const {
+        RayHit hit;
+        hit.map_x = this->map_x[lane];
+        hit.map_y = this->map_y[lane];
+        hit.side = (sides >> lane) & 1;
+        hit.steps = steps;
+        return hit;
+    }
+
+    ///
+    /// @return RayHit: The lane's current cell as a hit, distance as castRayDouble computes it
+    ///
+    inline RayHit wall(const CameraRay& ray, int lane, int sides, int steps) const {
+        RayHit hit = cell(lane, sides, steps);
+        hit.in_range = true;
+        if (hit.side == 0) {
+            hit.perp_wall_dist = (hit.map_x - ray.origin_x + (1 - this->step_x[lane]) / 2) / ray.dir_x;
+        } else {
+            hit.perp_wall_dist = (hit.map_y - ray.origin_y + (1 - this->step_y[lane]) / 2) / ray.dir_y;
+        }
+        return hit;
+    }
+
+    ///
+    /// @return RayHit: The lane's current cell as a miss at the maximum distance
+    ///
+    inline RayHit miss(int lane, int sides, int steps, double max_dist) const {
+        RayHit hit = cell(lane, sides, steps);
+        hit.in_range = false;
+        hit.perp_wall_dist = max_dist;
+        return hit;
+    }
+};
+
+#ifdef RAY_PACKET_X86
+///
+/// 32 bit lane masks by movemask bits, to apply a double compare to integer lanes
+///
+alignas(16) static const int32_t RAY_PACKET_MASKS[1 << RAY_PACKET_WIDTH][RAY_PACKET_WIDTH] = {
+    { 0,  0,  0,  0}, {-1,  0,  0,  0}, { 0, -1,  0,  0}, {-1, -1,  0,  0},
+    { 0,  0, -1,  0}, {-1,  0, -1,  0}, { 0, -1, -1,  0}, {-1, -1, -1,  0},
+    { 0,  0,  0, -1}, {-1,  0,  0, -1}, { 0, -1,  0, -1}, {-1, -1,  0, -1},
+    { 0,  0, -1, -1}, {-1,  0, -1, -1}, { 0, -1, -1, -1}, {-1, -1, -1, -1}
+};
+
+///
+/// Record the lanes that ran past the maximum distance as misses
+///
+/// @return int: Lanes still active
+///
+inline int missRayPacketLanes(const RayPacketLanes& lanes, int active, int beyond, int sides, int steps,
+    double max_dist, RayHitBuffer& hits, size_t first) {
+    for (int lane = 0; lane < RAY_PACKET_WIDTH; lane++) {
+        if (beyond >> lane & 1) {
+            hits.set(first + lane, lanes.miss(lane, sides, steps, max_dist));
+        }
+    }
+    return active & ~beyond;
+}
+
+///
+/// Look up the cell of every lane without branching. Lanes that are done stay
+/// on their last cell, so every lookup is in the map
+///
+/// @return int: Bit per lane, set if its cell is a wall
+///
+template <typename IsWall>
+inline int lookupRayPacketLanes(const RayPacketLanes& lanes, const IsWall& is_wall) {
+    return (int) is_wall(lanes.map_x[0], lanes.map_y[0])
+        | (int) is_wall(lanes.map_x[1], lanes.map_y[1]) << 1
+        | (int) is_wall(lanes.map_x[2], lanes.map_y[2]) << 2
+        | (int) is_wall(lanes.map_x[3], lanes.map_y[3]) << 3;
+}
+
+///
+/// Record the lanes that entered a wall as hits
+///
+/// @return int: Lanes still active
+///
+inline int retireRayPacketLanes(const CameraRay* rays, const RayPacketLanes& lanes, int active, int walls, int sides,
+    int steps, RayHitBuffer& hits, size_t first) {
+    for (int lane = 0; lane < RAY_PACKET_WIDTH; lane++) {
+        if (walls >> lane & 1) {
+            hits.set(first + lane, lanes.wall(rays[lane], lane, sides, steps));
+        }
+    }
+    return active & ~walls;
+}
+
+///
+/// Finish the last active lane of a packet alone, its neighbours have all hit.
+/// The lane's side distances must be stored back in lanes first
+///
+/// @return void
+///
+template <typename IsWall>
+inline void finishRayPacketLane(const CameraRay* rays, const RayPacketLanes& lanes, int active, int sides, int steps,
+    const IsWall& is_wall, double max_dist, RayHitBuffer& hits, size_t first) {
+    int lane = __builtin_ctz(active);
+    const CameraRay& ray = rays[lane];
+    hits.set(first + lane, continueRayDouble(ray.origin_x, ray.origin_y, ray.dir_x, ray.dir_y,
+        lanes.cell(lane, sides, steps), lanes.side_x[lane], lanes.side_y[lane], is_wall, max_dist));
+}
+
+///
+/// @param __m128d crossed_x: Compare masks of the two halves of an SSE2 packet, set where x was stepped
+///
+/// @return int: Bit per lane, set if its last crossing was a y facing edge
+///
+__attribute__((target("sse2")))
+inline int rayPacketSides(const __m128d* crossed_x) {
+    return RAY_PACKET_LANES & ~(_mm_movemask_pd(crossed_x[0]) | _mm_movemask_pd(crossed_x[1]) << 2);
+}
+
+///
+/// Step 4 rays in lockstep with SSE2, two lanes per double register. Every lane
+/// takes the same branch free step, masked to the axis it crosses, and hits match
+/// castRayDouble. Once only one lane is left the packet has split, so it finishes alone
+///
+/// @param CameraRay* rays: RAY_PACKET_WIDTH rays
+/// @param IsWall is_wall: Callable (int x, int y) -> bool
+/// @param double max_dist: Give up on walls further than this from the camera plane
+/// @param RayHitBuffer hits: Receives the hit of rays[lane] at first + lane
+/// @param size_t first: Index of the first ray's hit
+///
+/// @return void
+///
+template <typename IsWall>
+__attribute__((target("sse2")))
+inline void castRayPacketSSE2(const CameraRay* rays, const IsWall& is_wall, double max_dist, RayHitBuffer& hits, size_t first) {
+    RayPacketLanes lanes(rays);
+    const __m128d limit = _mm_set1_pd(max_dist);
+    __m128d side_x[2], side_y[2], delta_x[2], delta_y[2];
+    for (int h = 0; h < 2; h++) {
+        side_x[h] = _mm_load_pd(lanes.side_x + h * 2);
+        side_y[h] = _mm_load_pd(lanes.side_y + h * 2);
+        delta_x[h] = _mm_load_pd(lanes.delta_x + h * 2);
+        delta_y[h] = _mm_load_pd(lanes.delta_y + h * 2);
+    }
+    __m128i map_x = _mm_load_si128((const __m128i*) lanes.map_x);
+    __m128i map_y = _mm_load_si128((const __m128i*) lanes.map_y);
+    const __m128i step_x = _mm_load_si128((const __m128i*) lanes.step_x);
+    const __m128i step_y = _mm_load_si128((const __m128i*) lanes.step_y);
+    const bool bounded = max_dist < numeric_limits<double>::infinity();
+    __m128i active_mask = _mm_set1_epi32(-1);
+    // Lanes whose last crossing was an x facing edge, all of them before the first step as in castRayDouble
+    __m128d crossed_x[2];
+    crossed_x[0] = crossed_x[1] = _mm_castsi128_pd(_mm_set1_epi32(-1));
+    int active = RAY_PACKET_LANES;
+    int steps = 0;
+    for (;;) {
+        // Ties step y, as the scalar DDA does
+        __m128d x_first[2];
+        x_first[0] = _mm_cmplt_pd(side_x[0], side_y[0]);
+        x_first[1] = _mm_cmplt_pd(side_x[1], side_y[1]);
+        if (bounded) {
+            int beyond = 0;
+            for (int h = 0; h < 2; h++) {
+                __m128d nearest = _mm_or_pd(_mm_and_pd(x_first[h], side_x[h]), _mm_andnot_pd(x_first[h], side_y[h]));
+                beyond |= _mm_movemask_pd(_mm_cmpgt_pd(nearest, limit)) << (h * 2);
+            }
+            beyond &= active;
+            if (beyond != 0) {
+                if ((active = missRayPacketLanes(lanes, active, beyond, rayPacketSides(crossed_x), steps, max_dist, hits, first)) == 0) {
+                    return;
+                }
+                active_mask = _mm_load_si128((const __m128i*) RAY_PACKET_MASKS[active]);
+            }
+        }
+        for (int h = 0; h < 2; h++) {
+            side_x[h] = _mm_add_pd(side_x[h], _mm_and_pd(x_first[h], delta_x[h]));
+            side_y[h] = _mm_add_pd(side_y[h], _mm_andnot_pd(x_first[h], delta_y[h]));
+            crossed_x[h] = x_first[h];
+        }
+        // The low halves of the 64 bit compare masks are the 32 bit cell lanes. Lanes that are done stop moving
+        __m128i x_mask = _mm_castps_si128(_mm_shuffle_ps(_mm_castpd_ps(x_first[0]), _mm_castpd_ps(x_first[1]), _MM_SHUFFLE(2, 0, 2, 0)));
+        map_x = _mm_add_epi32(map_x, _mm_and_si128(_mm_and_si128(x_mask, active_mask), step_x));
+        map_y = _mm_add_epi32(map_y, _mm_and_si128(_mm_andnot_si128(x_mask, active_mask), step_y));
+        _mm_store_si128((__m128i*) lanes.map_x, map_x);
+        _mm_store_si128((__m128i*) lanes.map_y, map_y);
+        steps++;
+        int walls = lookupRayPacketLanes(lanes, is_wall) & active;
+        if (walls != 0) {
+            active = retireRayPacketLanes(rays, lanes, active, walls, rayPacketSides(crossed_x), steps, hits, first);
+            if ((active & (active - 1)) == 0) {
+                break;
+            }
+            active_mask = _mm_load_si128((const __m128i*) RAY_PACKET_MASKS[active]);
+        }
+    }
+    if (active != 0) {
+        for (int h = 0; h < 2; h++) {
+            _mm_store_pd(lanes.side_x + h * 2, side_x[h]);
+            _mm_store_pd(lanes.side_y + h * 2, side_y[h]);
+        }
+        finishRayPacketLane(rays, lanes, active, rayPacketSides(crossed_x), steps, is_wall, max_dist, hits, first);
+    }
+}
+
+///
+/// Load the rays of an AVX2 packet a field per register
+///
+/// @return void
+///
+__attribute__((target("avx2")))
+inline void transposeRayPacket(const CameraRay* rays, __m256d& origin_x, __m256d& origin_y, __m256d& dir_x, __m256d& dir_y) {
+    __m256d r0 = _mm256_loadu_pd(&rays[0].origin_x);
+    __m256d r1 = _mm256_loadu_pd(&rays[1].origin_x);
+    __m256d r2 = _mm256_loadu_pd(&rays[2].origin_x);
+    __m256d r3 = _mm256_loadu_pd(&rays[3].origin_x);
+    __m256d lo01 = _mm256_unpacklo_pd(r0, r1);
+    __m256d hi01 = _mm256_unpackhi_pd(r0, r1);
+    __m256d lo23 = _mm256_unpacklo_pd(r2, r3);
+    __m256d hi23 = _mm256_unpackhi_pd(r2, r3);
+    origin_x = _mm256_permute2f128_pd(lo01, lo23, 0x20);
+    origin_y = _mm256_permute2f128_pd(hi01, hi23, 0x20);
+    dir_x = _mm256_permute2f128_pd(lo01, lo23, 0x31);
+    dir_y = _mm256_permute2f128_pd(hi01, hi23, 0x31);
+}
+
+///
+/// Look up the cells of the lanes of an AVX2 packet, through the lanes' arrays
+///
+/// @return int: Bit per lane, set if its cell is a wall
+///
+template <typename IsWall>
+__attribute__((target("avx2")))
+inline int lookupRayPacketLanesAVX2(RayPacketLanes& lanes, __m128i map_x, __m128i map_y, const IsWall& is_wall) {
+    _mm_store_si128((__m128i*) lanes.map_x, map_x);
+    _mm_store_si128((__m128i*) lanes.map_y, map_y);
+    return lookupRayPacketLanes(lanes, is_wall);
+}
+
+///
+/// Look up the cells of the lanes of an AVX2 packet in an occupancy grid, one
+/// gather of the bitmask words holding them. Lanes outside the map are walls,
+/// as with the grid's own cell lookup, and gather cell 0 rather than past the grid
+///
+/// @return int: Bit per lane, set if its cell is a wall or outside the map
+///
+__attribute__((target("avx2")))
+inline int lookupRayPacketLanesAVX2(RayPacketLanes&, __m128i map_x, __m128i map_y, const OccupancyGrid& grid) {
+    __m128i none = _mm_set1_epi32(-1);
+    __m128i inside = _mm_and_si128(
+        _mm_and_si128(_mm_cmpgt_epi32(map_x, none), _mm_cmpgt_epi32(_mm_set1_epi32(grid.width), map_x)),
+        _mm_and_si128(_mm_cmpgt_epi32(map_y, none), _mm_cmpgt_epi32(_mm_set1_epi32(grid.height), map_y)));
+    __m128i cell = _mm_and_si128(_mm_add_epi32(_mm_mullo_epi32(map_y, _mm_set1_epi32(grid.width)), map_x), inside);
+    __m128i words = _mm_i32gather_epi32((const int*) grid.cells(), _mm_srli_epi32(cell, 5), 4);
+    __m128i bits = _mm_srlv_epi32(words, _mm_and_si128(cell, _mm_set1_epi32(31)));
+    int outside = ~_mm_movemask_ps(_mm_castsi128_ps(inside)) & RAY_PACKET_LANES;
+    return _mm_movemask_ps(_mm_castsi128_ps(_mm_slli_epi32(bits, 31))) | outside;
+}
+
+///
+/// Step 4 rays in lockstep with AVX2, all lanes in one register. Every lane takes
+/// the same branch free step, masked to the axis it crosses, and hits match
+/// castRayDouble. Once only one lane is left the packet has split, so it finishes alone
+///
+/// @param CameraRay* rays: RAY_PACKET_WIDTH rays
+/// @param IsWall is_wall: Callable (int x, int y) -> bool
+/// @param double max_dist: Give up on walls further than this from the camera plane
+/// @param RayHitBuffer hits: Receives the hit of rays[lane] at first + lane
+/// @param size_t first: Index of the first ray's hit
+///
+/// @return void
+///
+template <typename IsWall>
+__attribute__((target("avx2")))
+inline void castRayPacketAVX2(const CameraRay* rays, const IsWall& is_wall, double max_dist, RayHitBuffer& hits, size_t first) {
+    // Set up as castRayDouble does, the same operations a lane at a time so the results are identical
+    __m256d origin_x, origin_y, dir_x, dir_y;
+    transposeRayPacket(rays, origin_x, origin_y, dir_x, dir_y);
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    __m128i map_x = _mm256_cvttpd_epi32(origin_x);
+    __m128i map_y = _mm256_cvttpd_epi32(origin_y);
+    __m256d cell_x = _mm256_cvtepi32_pd(map_x);
+    __m256d cell_y = _mm256_cvtepi32_pd(map_y);
+    const __m256d delta_x = _mm256_andnot_pd(sign, _mm256_div_pd(one, dir_x));
+    const __m256d delta_y = _mm256_andnot_pd(sign, _mm256_div_pd(one, dir_y));
+    const __m128i step_x = _mm256_cvttpd_epi32(_mm256_or_pd(_mm256_and_pd(sign, dir_x), one));
+    const __m128i step_y = _mm256_cvttpd_epi32(_mm256_or_pd(_mm256_and_pd(sign, dir_y), one));
+    __m256d side_x = _mm256_mul_pd(delta_x, _mm256_blendv_pd(_mm256_sub_pd(_mm256_add_pd(cell_x, one), origin_x),
+        _mm256_sub_pd(origin_x, cell_x), _mm256_cmp_pd(dir_x, _mm256_setzero_pd(), _CMP_LT_OQ)));
+    __m256d side_y = _mm256_mul_pd(delta_y, _mm256_blendv_pd(_mm256_sub_pd(_mm256_add_pd(cell_y, one), origin_y),
+        _mm256_sub_pd(origin_y, cell_y), _mm256_cmp_pd(dir_y, _mm256_setzero_pd(), _CMP_LT_OQ)));
+    RayPacketLanes lanes;
+    _mm_store_si128((__m128i*) lanes.step_x, step_x);
+    _mm_store_si128((__m128i*) lanes.step_y, step_y);
+    const __m256d limit = _mm256_set1_pd(max_dist);
+    const bool bounded = max_dist < numeric_limits<double>::infinity();
+    // Narrows the 64 bit compare masks to the 32 bit cell lanes
+    const __m256i narrow = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+    __m128i active_mask = _mm_set1_epi32(-1);
+    // Lanes whose last crossing was an x facing edge, all of them before the first step as in castRayDouble
+    __m256d crossed_x = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+    int active = RAY_PACKET_LANES;
+    int steps = 0;
+    for (;;) {
+        // Ties step y, as the scalar DDA does
+        __m256d x_first = _mm256_cmp_pd(side_x, side_y, _CMP_LT_OQ);
+        if (bounded) {
+            __m256d nearest = _mm256_blendv_pd(side_y, side_x, x_first);
+            int beyond = _mm256_movemask_pd(_mm256_cmp_pd(nearest, limit, _CMP_GT_OQ)) & active;
+            if (beyond != 0) {
+                _mm_store_si128((__m128i*) lanes.map_x, map_x);
+                _mm_store_si128((__m128i*) lanes.map_y, map_y);
+                active = missRayPacketLanes(lanes, active, beyond, RAY_PACKET_LANES & ~_mm256_movemask_pd(crossed_x), steps,
+                    max_dist, hits, first);
+                if (active == 0) {
+                    return;
+                }
+                active_mask = _mm_load_si128((const __m128i*) RAY_PACKET_MASKS[active]);
+            }
+        }
+        side_x = _mm256_add_pd(side_x, _mm256_and_pd(x_first, delta_x));
+        side_y = _mm256_add_pd(side_y, _mm256_andnot_pd(x_first, delta_y));
+        crossed_x = x_first;
+        // Lanes that are done stop moving
+        __m128i x_mask = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(_mm256_castpd_si256(x_first), narrow));
+        map_x = _mm_add_epi32(map_x, _mm_and_si128(_mm_and_si128(x_mask, active_mask), step_x));
+        map_y = _mm_add_epi32(map_y, _mm_and_si128(_mm_andnot_si128(x_mask, active_mask), step_y));
+        steps++;
+        int walls = lookupRayPacketLanesAVX2(lanes, map_x, map_y, is_wall) & active;
+        if (walls != 0) {
+            _mm_store_si128((__m128i*) lanes.map_x, map_x);
+            _mm_store_si128((__m128i*) lanes.map_y, map_y);
+            active = retireRayPacketLanes(rays, lanes, active, walls, RAY_PACKET_LANES & ~_mm256_movemask_pd(crossed_x), steps,
+                hits, first);
+            if ((active & (active - 1)) == 0) {
+                break;
+            }
+            active_mask = _mm_load_si128((const __m128i*) RAY_PACKET_MASKS[active]);
+        }
+    }
+    if (active != 0) {
+        _mm256_store_pd(lanes.side_x, side_x);
+        _mm256_store_pd(lanes.side_y, side_y);
+        finishRayPacketLane(rays, lanes, active, RAY_PACKET_LANES & ~_mm256_movemask_pd(crossed_x), steps, is_wall,
+            max_dist, hits, first);
+    }
+}
+#endif
+
+///
+/// @param RayPacketLevel level: Packet tracer
+///
+/// @return bool: True if this build and CPU can run it
+///
+inline bool rayPacketLevelSupported(RayPacketLevel level) {
+#ifdef RAY_PACKET_X86
+    __builtin_cpu_init();
+    switch (level) {
+        case RAY_PACKET_SSE2:
+            return __builtin_cpu_supports("sse2");
+        case RAY_PACKET_AVX2:
+            return __builtin_cpu_supports("avx2");
+        default:
+            return true;
+    }
+#else
+    return level == RAY_PACKET_NONE;
+#endif
+}
+
+///
+/// Packet tracer to use on this CPU, the widest it supports. AVX2 packets look up
+/// the cells of all lanes with one gather from an occupancy grid. CPUs without AVX2
+/// fall back to SSE2 packets, which step two lanes per register and look their
+/// cells up lane by lane. Build with RAY_PACKET_SCALAR defined to trace every ray
+/// alone. Packets step in doubles, so builds with a fixed point DDA trace alone too
+///
+/// @return RayPacketLevel
+///
+inline RayPacketLevel selectRayPacketLevel() {
+#if RAYCAST_DDA_FIXED == 0
+    if (rayPacketLevelSupported(RAY_PACKET_AVX2)) {
+        return RAY_PACKET_AVX2;
+    }
+    if (rayPacketLevelSupported(RAY_PACKET_SSE2)) {
+        return RAY_PACKET_SSE2;
+    }
+#endif
+    return RAY_PACKET_NONE;
+}
+
+///
+/// Trace a run of camera rays, a packet of adjacent rays at a time. The rays left
+/// over at the end, or all of them without packets, are traced with castRay
+///
+/// @param vector<CameraRay> rays: Frame rays
+/// @param int first: First ray to trace (inclusive)
+/// @param int last: Last ray to trace (exclusive)
+/// @param IsWall is_wall: Callable (int x, int y) -> bool
+/// @param RayHitBuffer hits: Receives the hit of ray i at index i
+/// @param double max_dist: Give up on walls further than this from the camera plane
+/// @param RayPacketLevel level: Packet tracer to use
+///
+/// @return void
+///
+template <typename IsWall>
+inline void castRays(const vector<CameraRay>& rays, int first, int last, const IsWall& is_wall, RayHitBuffer& hits,
+    double max_dist, RayPacketLevel level) {
+    int i = first;
+#ifdef RAY_PACKET_X86
+    if (level == RAY_PACKET_AVX2) {
+        for (; i + RAY_PACKET_WIDTH <= last; i += RAY_PACKET_WIDTH) {
+            castRayPacketAVX2(&rays[i], is_wall, max_dist, hits, i);
+        }
+    } else if (level == RAY_PACKET_SSE2) {
+        for (; i + RAY_PACKET_WIDTH <= last; i += RAY_PACKET_WIDTH) {
+            castRayPacketSSE2(&rays[i], is_wall, max_dist, hits, i);
+        }
+    }
+#endif
+    for (; i < last; i++) {
+        hits.set(i, castRay(rays[i].origin_x, rays[i].origin_y, rays[i].dir_x, rays[i].dir_y, is_wall, max_dist));
+    }
+}
+
+///
+/// Trace a run of camera rays with the widest packets the CPU supports
+///
+/// @param vector<CameraRay> rays: Frame rays
+/// @param int first: First ray to trace (inclusive)
+/// @param int last: Last ray to trace (exclusive)
+/// @param IsWall is_wall: Callable (int x, int y) -> bool
+/// @param RayHitBuffer hits: Receives the hit of ray i at index i
+/// @param double max_dist: Give up on walls further than this from the camera plane
+///
+/// @return void
+///
+template <typename IsWall>
+inline void castRays(const vector<CameraRay>& rays, int first, int last, const IsWall& is_wall, RayHitBuffer& hits,
+    double max_dist = numeric_limits<double>::infinity()) {
+    static const RayPacketLevel level = selectRayPacketLevel();
+    castRays(rays, first, last, is_wall, hits, max_dist, level);
+}
+}
@@ -2,25 +2,22 @@
 
 #include "Raytracer.hpp"
 
-#define SPRITE_U_DIV 1
-#define SPRITE_V_DIV 1
-#define SPRITE_V_MOVE 0.0
-
-#define DARK_SHADER 0x7F7F7F
-
-#define __DEFAULT_DISPLAY_FUNC [](){}
-
 #define __DEFAULT_SCREEN_WIDTH 1024
 #define __DEFAULT_SCREEN_HEIGHT 512
+#define __DEFAULT_HEADLESS_FRAMES 100
+#define __DEFAULT_MAP MAPS_DIR + "map2.json"
 
 using namespace std;
 
-// Screen
+// Screen, the size frames are rendered at
 int screen_width = __DEFAULT_SCREEN_WIDTH;
 int screen_height = __DEFAULT_SCREEN_HEIGHT;
+// Window, frames are stretched over it when rendered at a lower resolution
+int window_width = __DEFAULT_SCREEN_WIDTH;
+int window_height = __DEFAULT_SCREEN_HEIGHT;
 
 ResourceManager::TextureLoader texLoader;
-map<string, Texture> textures;
+Rendering::TextureAtlas texAtlas;
 AStar astar;
 vector<Coords> *path = new vector<Coords>();
 // Player
@@ -32,228 +29,121 @@ ResourceManager::ConfigInit cfgInit;
 
 World world = World();
 
-double new_time = 0;
-double old_time = 0;
-
+// Seconds between the last two displayed frames
 double frame_time = 0;
+chrono::steady_clock::time_point last_display;
+
+// The world and player advance in fixed steps, frames are drawn from renderView,
+// which is interpolated between the player's views before and after the last step
+FixedTimestep simClock;
+ViewModel::Camera renderView;
+bitset<256> keysHeld;
+// Keys going up and down, stamped with the step they take effect from
+ResourceManager::InputRecording recording;
+ResourceManager::InputRecording replay;
 
 Rendering::PBO pixelBuffer;
-Rendering::RayBuffer rays;
-Rendering::ZBuffer zBuf;
+Rendering::ResolutionScaler resolutionScaler;
+// Frame stages, drawing the world into pixelBuffer on the render pool
+Rendering::FrameRenderer frameRenderer;
 
 GUI::Canvas canvas;
 
-inline static void renderWallsFloorCeiling() {
-    double ray_dir_x, ray_dir_y, side_dist_x, side_dist_y, delta_x, delta_y, perp_wall_dist, wall_x, step, tex_pos,
-        ray_dir_x0, ray_dir_y0, ray_dir_x1, ray_dir_y1, pos_z, dist, step_x_cf, step_y_cf, floor_x, floor_y;
-    int map_x, map_y, step_x, step_y, hit, side, line_height, draw_start_pos, draw_end_pos, tex_coord_x, tex_coord_y,
-        p, cell_x, cell_y, tex_coord_x_cf, tex_coord_y_cf;
-    string wall_tex;
-    uint32_t color;
-    Texture tex;
-    for (int x = screen_width - 1; x >= 0; x--) {
-        player.camera.x = 2 * x / double(screen_width) - 1;
-        ray_dir_x = player.camera.frustrum.getFovX() + player.camera.clip_plane_x * player.camera.x;
-        ray_dir_y = player.camera.frustrum.getFovY() + player.camera.clip_plane_y * player.camera.x;
-
-        map_x = (int)player.location.x;
-        map_y = (int)player.location.y;
-
-        delta_x = abs(1 / ray_dir_x);
-        delta_y = abs(1 / ray_dir_y);
-
-        hit = 0;
-        step_x = copysign(1.0, ray_dir_x);
-        side_dist_x = delta_x * (ray_dir_x < 0 ? player.location.x - map_x : map_x + 1.0 - player.location.x);
-        step_y = copysign(1.0, ray_dir_y);
-        side_dist_y = delta_y * (ray_dir_y < 0 ? player.location.y - map_y : map_y + 1.0 - player.location.y);
-
-        while (hit == 0) {
-            if (side_dist_x < side_dist_y) {
-                side_dist_x += delta_x;
-                map_x += step_x;
-                side = 0;
-            } else {
-                side_dist_y += delta_y;
-                map_y += step_y;
-                side = 1;
-            }
-            hit = world.getAt(map_x, map_y).type != Constructs::WallType::NONE;
-        }
-
-        if (side == 0) {
-            perp_wall_dist = (map_x - player.location.x + IDIV_2((1 - step_x))) / ray_dir_x;
-        } else {
-            perp_wall_dist = (map_y - player.location.y + IDIV_2((1 - step_y))) / ray_dir_y;
-        }
-        line_height = (int)(screen_height / perp_wall_dist);
-
-        draw_start_pos = IDIV_2(-line_height) + IDIV_2(screen_height);
-        if (draw_start_pos < 0) {
-            draw_start_pos = 0;
-        }
-        draw_end_pos = IDIV_2(line_height) + IDIV_2(screen_height);
-        if (draw_end_pos >= screen_height) {
-            draw_end_pos = screen_height - 1;
-        }
-        wall_tex = world.getAt(map_x, map_y).wf_left.texture;
-
-        wall_x = side == 0 ? player.location.y + perp_wall_dist * ray_dir_y : player.location.x + perp_wall_dist * ray_dir_x;
-        wall_x -= floor((wall_x));
-
-        tex_coord_x = (int)(wall_x * double(renderCfg.texture_width));
-        if (side == 0 && ray_dir_x > 0) {
-            tex_coord_x = renderCfg.texture_width - tex_coord_x - 1;
-        }
-        if (side == 1 && ray_dir_y < 0) {
-            tex_coord_x = renderCfg.texture_width - tex_coord_x - 1;
-        }
+WorkerPool renderPool;
 
-        step = 1.0 * renderCfg.texture_height / line_height;
-        tex_pos = (draw_start_pos - IDIV_2(screen_height) + IDIV_2(line_height)) * step;
-
-        ray_dir_x0 = player.camera.frustrum.getFovX() - player.camera.clip_plane_x;
-        ray_dir_y0 = player.camera.frustrum.getFovY() - player.camera.clip_plane_y;
-        ray_dir_x1 = player.camera.frustrum.getFovX() + player.camera.clip_plane_x;
-        ray_dir_y1 = player.camera.frustrum.getFovY() + player.camera.clip_plane_y;
-        
-        for (int y = screen_height - 1; y >= 0; y--) {
-            if (renderCfg.render_walls && y < draw_end_pos && y >= draw_start_pos) {
-                tex_coord_y = (int)tex_pos & (renderCfg.texture_height - 1);
-                tex_pos += step;
-                tex = textures[wall_tex];
-                color = tex.texture[renderCfg.texture_height * tex_coord_y + tex_coord_x];
-                if (side == 1) {
-                    color = (color >> 1) & DARK_SHADER;
-                }
-                pixelBuffer.pushToBuffer(x, y, Colour::INTtoRGB(color));
-            } else if (renderCfg.render_floor_ceiling && y >= IDIV_2(screen_height) + 1) {
-                // p = y - IDIV_2(screen_height);
-                // pos_z = 0.5 * screen_width;
-                // dist = pos_z / p;
-                dist = (0.5 * screen_width) / (y - IDIV_2(screen_height));
-
-                step_x_cf = dist * (ray_dir_x1 - ray_dir_x0) / screen_width;
-                step_y_cf = dist * (ray_dir_y1 - ray_dir_y0) / screen_width;
-
-                floor_x = (player.location.x + dist * ray_dir_x0) + (step_x_cf * x);
-                floor_y = (player.location.y + dist * ray_dir_y0) + (step_y_cf * x);
-
-                cell_x = (int)(floor_x);
-                cell_y = (int)(floor_y);
-
-                tex_coord_x_cf = (int)(renderCfg.texture_width * (floor_x - cell_x)) & (renderCfg.texture_width - 1);
-                tex_coord_y_cf = (int)(renderCfg.texture_height * (floor_y - cell_y)) & (renderCfg.texture_height - 1);
-
-                tex = textures[world.floor_texture];
-                color = tex.texture[renderCfg.texture_width * tex_coord_y_cf + tex_coord_x_cf];
-                color = (color >> 1) & DARK_SHADER;
-                pixelBuffer.pushToBuffer(x, screen_height - y, Colour::INTtoRGB(color));
-
-                tex = textures[world.ceiling_texture];
-                color = tex.texture[renderCfg.texture_width * tex_coord_y_cf + tex_coord_x_cf];
-                color = (color >> 1) & DARK_SHADER;
-                pixelBuffer.pushToBuffer(x, y, Colour::INTtoRGB(color));
-            }
-        }
-        zBuf[x] = perp_wall_dist;
+///
+/// Render at a new size within the window. The pixel buffer storage is sized
+/// for the window, and the per column and per row buffers keep their storage
+/// when shrinking, so scaling back up only reallocates past the largest size yet
+///
+/// @param int width: Pixels, at most the window width
+/// @param int height: Pixels, at most the window height
+///
+/// @return void
+///
+static void setRenderSize(int width, int height) {
+    screen_width = width;
+    screen_height = height;
+    frameRenderer.resize(width, height);
+    if (!pixelBuffer.setRenderSize(width, height)) {
+        pixelBuffer.resize(width, height);
     }
 }
 
-inline static void renderSprites() {
-    world.sortSprites(player.location);
-
-    double sprite_x, sprite_y, transform_x, transform_y;
-    int sprite_screen_x, vert_move_screen, sprite_height, sprite_width, draw_start_pos_y, draw_end_pos_y, draw_start_pos_x, draw_end_pos_x, tex_coord_x, tex_coord_y, d;
-    Texture tex;
-    uint32_t color;
-    double inverse_det = 1.0 / (player.camera.clip_plane_x * player.camera.frustrum.getFovY() - player.camera.frustrum.getFovX() * player.camera.clip_plane_y);
-    for (int i = world.sprites.size() - 1; i >= 0; i--) {
-        sprite_x = world.sprites[i].location.x - player.location.x;
-        sprite_y = world.sprites[i].location.y - player.location.y;
-
-        transform_x = inverse_det * (player.camera.frustrum.getFovY() * sprite_x - player.camera.frustrum.getFovX() * sprite_y);
-        transform_y = inverse_det * (-player.camera.clip_plane_y * sprite_x + player.camera.clip_plane_x * sprite_y);
-
-        sprite_screen_x = (int)(IDIV_2(screen_width) * (1 + transform_x / transform_y));
-
-        vert_move_screen = (int)(SPRITE_V_MOVE / transform_y);
-
-        sprite_height = abs((int)(screen_height / (transform_y))) / SPRITE_V_DIV;
-        draw_start_pos_y = -IDIV_2(sprite_height) + IDIV_2(screen_height) + vert_move_screen;
-        if (draw_start_pos_y < 0) {
-            draw_start_pos_y = 0;
-        }
-        draw_end_pos_y = IDIV_2(sprite_height) + IDIV_2(screen_height) + vert_move_screen;
-        if (draw_end_pos_y >= screen_height) {
-            draw_end_pos_y = screen_height - 1;
-        }
-
-        sprite_width = abs((int)(screen_height / (transform_y))) / SPRITE_U_DIV;
-        draw_start_pos_x = IDIV_2(-sprite_width) + sprite_screen_x;
-        if (draw_start_pos_x < 0) {
-            draw_start_pos_x = 0;
-        }
-        draw_end_pos_x = IDIV_2(sprite_width) + sprite_screen_x;
-        if (draw_end_pos_x >= screen_width) {
-            draw_end_pos_x = screen_width - 1;
-        }
-        tex = textures[world.sprites[i].texture];
-        for (int pixel_row = draw_end_pos_x - 1; pixel_row >= draw_start_pos_x; pixel_row--) {
-            tex_coord_x = (int)IDIV_256((IMUL_256((pixel_row - (IDIV_2(-sprite_width) + sprite_screen_x))) * renderCfg.texture_width / sprite_width));
-            if (!(transform_y > 0 && pixel_row > 0 && pixel_row < screen_width && transform_y < zBuf[pixel_row])) {
-                continue;
-            }
-            for (int pixel_column = draw_end_pos_y - 1; pixel_column >= draw_start_pos_y; pixel_column--) {
-                d = IMUL_256((pixel_column - vert_move_screen)) - IMUL_128(screen_height) + IMUL_128(sprite_height);
-                tex_coord_y = IDIV_256((d * renderCfg.texture_height) / sprite_height);
-                color = tex.texture[renderCfg.texture_width * tex_coord_y + tex_coord_x];
-                if ((color & 0x00FFFFFF) != 0) {
-                    pixelBuffer.pushToBuffer(pixel_row, screen_height - pixel_column, Colour::INTtoRGB(color));
-                }
-            }
+///
+/// Advance the world and the player by one fixed step, moving the player
+/// for each key held down
+///
+/// @return void
+///
+inline static void simulate() {
+    player.beginStep();
+    for (int key = 0; key < (int) keysHeld.size(); key++) {
+        if (keysHeld[key]) {
+            player.handleKeyPress((unsigned char) key, 0, 0, world);
         }
     }
-}
-
-inline static void updateTimeTick() {
-    old_time = new_time;
-    new_time = glutGet(GLUT_ELAPSED_TIME);
-    frame_time = (new_time - old_time) / 1000.0;
-
-    player.moveSpeed = frame_time * playerCfg.move_speed;
-    player.rotSpeed = frame_time * playerCfg.rotation_speed;
 
     global_tick++;
     world.updateSprites();
     player.update();
 }
 
+///
+/// Run the simulation steps due since the last frame on the monotonic
+/// clock, and place the view for the frame between the last two of them
+///
+/// @return void
+///
+inline static void updateTimeTick() {
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    frame_time = chrono::duration<double>(now - last_display).count();
+    last_display = now;
+
+    for (int steps = simClock.advance(frame_time); steps > 0; steps--) {
+        simulate();
+    }
+    renderView = player.interpolatedView(simClock.alpha());
+}
+
 static void __DISPLAY(void) {
+    updateTimeTick();
+    chrono::steady_clock::time_point frame_start = chrono::steady_clock::now();
+    pixelBuffer.beginFrame();
     if (!renderCfg.render_floor_ceiling) {
         pixelBuffer.blankOut();
     }
-    renderWallsFloorCeiling();
+    frameRenderer.renderWallsFloorCeiling(renderView);
 
     if (renderCfg.render_sprites) {
-        renderSprites();
+        frameRenderer.renderSprites(renderView);
     }
 
     pixelBuffer.swapBuffer();
-    updateTimeTick();
-    
+    double render_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - frame_start).count();
+
     canvas.render(frame_time);
     astar.renderPath(
         path, Colour::RGB_Blue,
-        screen_width, screen_height,
+        window_width, window_height,
         canvas.getMinimap().getScalingX(), canvas.getMinimap().getScalingY()
     );
     glutSwapBuffers();
+
+    // Only the time spent rendering counts against the budget, not waiting on the display
+    if (resolutionScaler.update(render_ms)) {
+        int width, height;
+        resolutionScaler.renderSize(window_width, window_height, width, height);
+        setRenderSize(width, height);
+        debugContext.logApiInfo("Rendering at " + to_string(width) + "*" + to_string(height) + ", frames averaging "
+            + to_string(resolutionScaler.smoothed_ms) + " ms of " + to_string(resolutionScaler.budget_ms) + " ms");
+    }
 }
 
 
 ///
-/// Initialise the display rendering and player position
+/// Initialise the world, player and software render targets.
+/// Makes no GL/GLUT calls so it is safe to use in headless mode
 ///
 /// @return void
 ///
@@ -263,64 +153,319 @@ void __INIT() {
     debugContext = GLDebugContext(&loggingCfg);
     debugContext.logAppInfo("Loaded debug context");
 
+    if (!launchCfg.replay_file.empty()) {
+        // The session is simulated again as it was recorded, whatever the map and config now
+        replay = ResourceManager::InputRecording::load(launchCfg.replay_file);
+        launchCfg.map_file = replay.map_file;
+        renderCfg.sim_rate = replay.sim_rate;
+        playerCfg.fov = replay.fov;
+        playerCfg.move_speed = replay.move_speed;
+        playerCfg.rotation_speed = replay.rotation_speed;
+        debugContext.logAppInfo("Loaded input recording of " + to_string(replay.length) + " steps and "
+            + to_string(replay.events.size()) + " events on " + replay.map_file);
+    }
+
+    map<string, Texture> textures;
     texLoader = ResourceManager::TextureLoader();
     texLoader.loadTextures(textures);
     debugContext.logAppInfo(string("Loaded " + to_string(textures.size()) + " textures"));
+    texAtlas.build(textures, renderCfg.texture_width, renderCfg.texture_height, renderCfg.mipmaps);
+
+    world.readMapFromJSON(launchCfg.map_file, texAtlas);
+
+    int render_threads = renderCfg.render_threads > 0
+        ? renderCfg.render_threads
+        : max(1, (int) thread::hardware_concurrency());
+    renderPool.start(render_threads);
+    debugContext.logAppInfo("Initialised render worker pool with " + to_string(renderPool.size()) + " workers");
+
+    // Ray packets look their cells up in the occupancy grid, so it is built for every map.
+    // Small maps are cheaper to step cell by cell than to leap through
+    frameRenderer.occupancy.rebuild(world.map_width, world.map_height, [](int x, int y) {
+        return world.getAt(x, y).type != Constructs::WallType::NONE;
+    });
+    frameRenderer.skip_empty_space = renderCfg.occupancy_grid_min_size > 0
+        && max(world.map_width, world.map_height) >= renderCfg.occupancy_grid_min_size;
+    debugContext.logAppInfo("Built occupancy grid, " + to_string(frameRenderer.occupancy.bytes()) + " bytes, empty space skipping "
+        + (frameRenderer.skip_empty_space ? "on" : "off"));
+    if (renderCfg.wall_query == ConfigSection::WallQuery::QSP) {
+        // A tree saved next to the map is mapped in as is, otherwise build one and save it for next time
+        string tree_file = QSPTree::pathFor(launchCfg.map_file);
+        if (!frameRenderer.qsp_tree.load(tree_file, world)) {
+            frameRenderer.qsp_tree = QSPTree(world);
+            frameRenderer.qsp_tree.buildTree(&renderPool);
+            frameRenderer.qsp_tree.save(tree_file);
+        }
+        debugContext.logAppInfo("Querying walls through the QSP tree, " + to_string(frameRenderer.qsp_tree.bytes()) + " bytes");
+    }
 
-    world.readMapFromJSON(MAPS_DIR + "map2.json");
-
-    rays = Rendering::RayBuffer(playerCfg.fov);
-    zBuf = Rendering::ZBuffer(screen_width);
+    frameRenderer.world = &world;
+    frameRenderer.atlas = &texAtlas;
+    frameRenderer.target = &pixelBuffer;
+    frameRenderer.pool = &renderPool;
+    frameRenderer.resize(screen_width, screen_height);
+    frameRenderer.fog = Rendering::FogTable(renderCfg.fog_start, renderCfg.render_distance, 0xFF000000 | (uint32_t) renderCfg.fog_colour);
+    debugContext.logAppInfo(renderCfg.render_distance > 0
+        ? "Render distance " + to_string(renderCfg.render_distance) + " cells, fog from " + to_string(renderCfg.fog_start)
+        : string("Render distance unbounded"));
+    if (renderCfg.indexed_colour) {
+        // Built once the fog is known, solid fog gets a palette entry and every fog level a colormap
+        frameRenderer.palette.build(texAtlas.allTexels().data(), texAtlas.allTexels().size(), frameRenderer.fog.colour);
+        texAtlas.quantize(frameRenderer.palette);
+        frameRenderer.palette.buildColormaps(frameRenderer.fog);
+    }
 
     astar = AStar(world);
     // path = astar.find(world.start, world.end);
 
-    player.moveSpeed = frame_time * playerCfg.move_speed;
-    player.rotSpeed = frame_time * playerCfg.rotation_speed;
-
-    gluOrtho2D(0, screen_width, screen_height, 0);
     player = Player(
         world.start.x,
         world.start.y,
         -playerCfg.fov,
         0.0,
         0);
+    // Speeds are per simulation step, which is always the same length
+    simClock = FixedTimestep(renderCfg.sim_rate);
+    player.moveSpeed = simClock.step * playerCfg.move_speed;
+    player.rotSpeed = simClock.step * playerCfg.rotation_speed;
+    player.beginStep();
+    renderView = player.view();
+    debugContext.logAppInfo("Simulating at " + to_string(renderCfg.sim_rate) + " steps per second");
     debugContext.logAppInfo("Initialised Player object [" + to_string(player.id) + "] at: " + ADDR_OF(player));
 
-    canvas.setMinimap(GUI::Minimap(&player, &world, screen_width, screen_height));
+    canvas.setMinimap(GUI::Minimap(&player, &world, window_width, window_height));
     debugContext.logAppInfo("Initialised Minimap object at: " + ADDR_OF(canvas.getMinimap()));
 
     canvas.setDebugOverlay(GUI::DebugOverlay(&player, &canvas.getMinimap(), &world, GLUT_BITMAP_HELVETICA_12));
     debugContext.logAppInfo("Initialised DebugOverlay object at: " + ADDR_OF(canvas.getDebugOverlay()));
 
-    canvas.setStatsBar(GUI::StatsBar(screen_width, screen_height,
+    canvas.setStatsBar(GUI::StatsBar(window_width, window_height,
         Colour::RGB_Blue, Colour::RGB_Navy, Colour::RGB_White));
     debugContext.logAppInfo("Initialised StatsBar object at: " + ADDR_OF(canvas.getStatsBar()));
 
     // canvas.addButton(new GUI::Button(138, 174, 120, 20, "Main Menu",
     //     Colour::RGB_White, Colour::RGB_Cyan, Colour::RGB_Yellow, [](int_id id){}));
 
-    pixelBuffer = Rendering::PBO(screen_width, screen_height);
-    pixelBuffer.init();
+    pixelBuffer = Rendering::PBO(screen_width, screen_height, renderCfg.column_major_target);
+    if (renderCfg.indexed_colour) {
+        pixelBuffer.setPalette(frameRenderer.palette.colours());
+    }
+
+    // Frames in the window are scaled to keep up with the refresh rate, headless frames stay at full size
+    if (renderCfg.dynamic_resolution && !(launchCfg.headless || renderCfg.headless_mode)) {
+        resolutionScaler = Rendering::ResolutionScaler(renderCfg.refresh_rate, renderCfg.min_render_scale, renderCfg.max_render_scale);
+        debugContext.logAppInfo("Dynamic resolution between " + to_string(resolutionScaler.min_scale) + " and "
+            + to_string(resolutionScaler.max_scale) + " of the window, " + to_string(resolutionScaler.budget_ms) + " ms per frame");
+        int width, height;
+        resolutionScaler.renderSize(window_width, window_height, width, height);
+        setRenderSize(width, height);
+    }
 
     global_tick = 0;
+    last_display = chrono::steady_clock::now();
     debugContext.logAppInfo("Initialised global tick");
 }
 
+///
+/// Initialise the GL state backing the display, requires a current GL context
+///
+/// @param ProcLoader loader: Entry point loader of the context's windowing system
+///
+/// @return void
+///
+void __GL_INIT(Rendering::GLExt::ProcLoader loader = Rendering::GLExt::platformLoader) {
+    gluOrtho2D(0, window_width, window_height, 0);
+    pixelBuffer.init(renderCfg.stream_buffers, loader);
+}
+
+///
+/// Render frames along a camera path straight into the PBO CPU buffer,
+/// without a window, reporting per-frame timings. With --headless-gl each
+/// frame is also presented through an offscreen GL context and read back
+///
+/// @return int: Process exit code
+///
+int __HEADLESS_MAIN() {
+#ifdef W3D_HAVE_EGL
+    Rendering::OffscreenContext offscreen;
+    bool present_gl = launchCfg.headless_gl && offscreen.create(screen_width, screen_height);
+    if (present_gl) {
+        __GL_INIT(Rendering::OffscreenContext::loader);
+    }
+    vector<uint32_t> presented;
+#else
+    bool present_gl = false;
+#endif
+    if (launchCfg.headless_gl && !present_gl) {
+        debugContext.glDebugMessageCallback(
+            GL_DEBUG_SOURCE::DEBUG_SOURCE_API,
+            GL_DEBUG_TYPE::DEBUG_TYPE_ERROR,
+            GL_DEBUG_SEVERITY::DEBUG_SEVERITY_MEDIUM,
+            "No offscreen GL context available, rendering in software only"
+        );
+    }
+
+    // A replay moves the player by its recorded keys, one step per frame, otherwise the camera follows a path
+    bool replaying = !launchCfg.replay_file.empty();
+    int frames = replaying ? max((int) replay.length, 1) : launchCfg.frames;
+    size_t next_event = 0;
+    ViewModel::CameraPath camera_path;
+    if (!replaying) {
+        camera_path = launchCfg.camera_path.empty()
+            ? ViewModel::CameraPath::spin(
+                player.location.x, player.location.y,
+                atan2(player.camera.frustrum.getFovY(), player.camera.frustrum.getFovX())
+            )
+            : ViewModel::CameraPath::fromFile(launchCfg.camera_path);
+        debugContext.logAppInfo("Loaded camera path with " + to_string(camera_path.size()) + " keyframes");
+    }
+
+    bool dump_frames = !launchCfg.dump_dir.empty();
+    if (dump_frames) {
+        mkdir(launchCfg.dump_dir.c_str(), 0777);
+    }
+
+    typedef chrono::steady_clock Clock;
+    double total_ms = 0;
+    double min_ms = numeric_limits<double>::max();
+    double max_ms = 0;
+    FrameStats stats({"walls/floor/ceiling", "sprites", "present", "total"});
+    printf("Headless render: %dx%d, %d frames, map [%s]%s%s\n",
+        screen_width, screen_height, frames, launchCfg.map_file.c_str(),
+        present_gl ? (pixelBuffer.isStreaming() ? ", GL streamed" : ", GL client upload") : "",
+        replaying ? (", replaying [" + launchCfg.replay_file + "]").c_str() : "");
+    for (int frame = 0; frame < frames; frame++) {
+        if (replaying) {
+            for (; next_event < replay.events.size() && replay.events[next_event].tick <= (uint64_t) frame; next_event++) {
+                keysHeld[replay.events[next_event].key] = replay.events[next_event].action == ResourceManager::KEY_DOWN;
+            }
+            simulate();
+        } else {
+            ViewModel::CameraPose pose = camera_path.sample(frame, frames);
+            player.setView(pose.x, pose.y, pose.angle);
+        }
+        renderView = player.view();
+
+        Clock::time_point frame_start = Clock::now();
+        pixelBuffer.beginFrame();
+        if (!renderCfg.render_floor_ceiling) {
+            pixelBuffer.blankOut();
+        }
+        frameRenderer.renderWallsFloorCeiling(renderView);
+        Clock::time_point walls_end = Clock::now();
+        if (renderCfg.render_sprites) {
+            frameRenderer.renderSprites(renderView);
+        }
+        Clock::time_point sprites_end = Clock::now();
+#ifdef W3D_HAVE_EGL
+        if (present_gl) {
+            pixelBuffer.swapBuffer();
+            glFinish();
+        } else {
+            pixelBuffer.resolve();
+        }
+#else
+        pixelBuffer.resolve();
+#endif
+        Clock::time_point frame_end = Clock::now();
+
+        double walls_ms = chrono::duration<double, milli>(walls_end - frame_start).count();
+        double sprites_ms = chrono::duration<double, milli>(sprites_end - walls_end).count();
+        double present_ms = chrono::duration<double, milli>(frame_end - sprites_end).count();
+        double frame_ms = walls_ms + sprites_ms + present_ms;
+        total_ms += frame_ms;
+        min_ms = min(min_ms, frame_ms);
+        max_ms = max(max_ms, frame_ms);
+        stats.add({walls_ms, sprites_ms, present_ms, frame_ms});
+        printf("[frame %4d] walls/floor/ceiling: %8.3f ms | sprites: %8.3f ms | present: %8.3f ms | total: %8.3f ms\n",
+            frame, walls_ms, sprites_ms, present_ms, frame_ms);
+
+        if (dump_frames) {
+            char frame_name[32];
+            snprintf(frame_name, sizeof(frame_name), "/frame_%04d.ppm", frame);
+            string filename = launchCfg.dump_dir + frame_name;
+            const uint32_t* pixels = pixelBuffer.data();
+            bool inverted = true;
+#ifdef W3D_HAVE_EGL
+            if (present_gl) {
+                offscreen.readPixels(presented);
+                pixels = presented.data();
+                inverted = false;
+            }
+#endif
+            if (ResourceManager::PPM::saveImage(filename, pixels, pixelBuffer.width, pixelBuffer.height, inverted)) {
+                debugContext.glDebugMessageCallback(
+                    GL_DEBUG_SOURCE::DEBUG_SOURCE_SYSTEM,
+                    GL_DEBUG_TYPE::DEBUG_TYPE_ERROR,
+                    GL_DEBUG_SEVERITY::DEBUG_SEVERITY_MEDIUM,
+                    "Unable to write frame dump: " + filename
+                );
+            }
+        }
+
+        if (!replaying) {
+            // One step per frame, as if frames were drawn at the simulation rate, so runs repeat exactly
+            simulate();
+        }
+    }
+    printf("%s", stats.report().c_str());
+    printf("Frames: %d | avg: %.3f ms | min: %.3f ms | max: %.3f ms | avg FPS: %.1f\n",
+        frames, total_ms / frames, min_ms, max_ms, 1000.0 * frames / total_ms);
+    return 0;
+}
+
 static void __WINDOW_RESHAPE(int width, int height) {
-    screen_width = width;
-    screen_height = height;
-    zBuf.resize(width);
+    window_width = width;
+    window_height = height;
+    glViewport(0, 0, width, height);
+    glLoadIdentity();
+    gluOrtho2D(0, width, height, 0);
+    // Storage is sized for the whole window, frames then render at the current scale within it
     pixelBuffer.resize(width, height);
+    int render_width, render_height;
+    resolutionScaler.renderSize(width, height, render_width, render_height);
+    setRenderSize(render_width, render_height);
 }
 
 static void __GLUT_IDLE(void) {
     glutPostRedisplay();
 }
 
-static void __KEY_HANDLER(unsigned char key, int x, int y) {
-    player.handleKeyPress(key, x, y, world);
-    glutPostRedisplay();
+///
+/// Hold a key down or let it go, recording the change if a recording is open
+///
+/// @param unsigned char key: Key that changed
+/// @param bool down: True if it is now held down
+///
+/// @return void
+///
+static void setKeyHeld(unsigned char key, bool down) {
+    if (keysHeld[key] == down) {
+        return;
+    }
+    keysHeld[key] = down;
+    // Steps run from the display callback only, so the change takes effect from the next one
+    if (recording.isOpen() && !recording.record(simClock.steps, key, down ? ResourceManager::KEY_DOWN : ResourceManager::KEY_UP)) {
+        debugContext.glDebugMessageCallback(
+            GL_DEBUG_SOURCE::DEBUG_SOURCE_SYSTEM,
+            GL_DEBUG_TYPE::DEBUG_TYPE_ERROR,
+            GL_DEBUG_SEVERITY::DEBUG_SEVERITY_MEDIUM,
+            "Unable to write input recording: " + launchCfg.record_file
+        );
+        recording.close(simClock.steps);
+    }
+}
+
+static void __KEY_HANDLER(unsigned char key, int, int) {
+    setKeyHeld(key, true);
+}
+
+static void __KEY_UP_HANDLER(unsigned char key, int, int) {
+    setKeyHeld(key, false);
+}
+
+static void __CLOSE_RECORDING(void) {
+    recording.close(simClock.steps);
 }
 
 static void __MOUSE_HANDLER(int button, int state, int x, int y) {
@@ -344,25 +489,84 @@ static void __PASSIVE_MOTION_HANDLER(int x, int y) {
 /// @return int
 ///
 int main(int argc, char* argv[]) {
+    launchCfg = ConfigSection::LaunchCfg{
+        false,
+        __DEFAULT_MAP,
+        __DEFAULT_SCREEN_WIDTH,
+        __DEFAULT_SCREEN_HEIGHT,
+        __DEFAULT_HEADLESS_FRAMES,
+        "",
+        "",
+        false,
+        "",
+        ""
+    };
+    ResourceManager::ArgParser argParser(argc, argv);
+    try {
+        argParser.parse(launchCfg);
+    } catch (const InvalidLaunchArgument& e) {
+        cerr << e.what() << endl << argParser.usage();
+        return 1;
+    }
+    screen_width = launchCfg.width;
+    screen_height = launchCfg.height;
+    window_width = launchCfg.width;
+    window_height = launchCfg.height;
+
+    try {
+        __INIT();
+    } catch (const InputRecordingFormatError& e) {
+        cerr << e.what() << endl;
+        return 1;
+    } catch (const MapLoadError& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    debugContext.logAppInfo("---- COMPLETED APPLICATION INIT PHASE ----");
+
+    if (launchCfg.headless || renderCfg.headless_mode) {
+        debugContext.logAppInfo("Running in headless mode, no GLUT window or GL context created");
+        try {
+            return __HEADLESS_MAIN();
+        } catch (const CameraPathFormatError& e) {
+            cerr << e.what() << endl;
+            return 1;
+        }
+    }
+
+    if (!launchCfg.record_file.empty()) {
+        recording = ResourceManager::InputRecording(launchCfg.map_file, renderCfg.sim_rate,
+            playerCfg.fov, playerCfg.move_speed, playerCfg.rotation_speed);
+        if (recording.open(launchCfg.record_file)) {
+            // GLUT leaves its main loop through exit(), which is the only chance to mark where the session ended
+            atexit(__CLOSE_RECORDING);
+            debugContext.logAppInfo("Recording input to " + launchCfg.record_file);
+        } else {
+            debugContext.glDebugMessageCallback(
+                GL_DEBUG_SOURCE::DEBUG_SOURCE_SYSTEM,
+                GL_DEBUG_TYPE::DEBUG_TYPE_ERROR,
+                GL_DEBUG_SEVERITY::DEBUG_SEVERITY_MEDIUM,
+                "Unable to write input recording: " + launchCfg.record_file
+            );
+        }
+    }
+
     glutInit(&argc, argv);
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB);
-    glutInitWindowSize(screen_width, screen_height);
+    glutInitWindowSize(window_width, window_height);
     glutCreateWindow("Ray Caster");
 
-    __INIT();
-    debugContext.logAppInfo("---- COMPLETED APPLICATION INIT PHASE ----");
-
-    if (renderCfg.headless_mode) {
-        debugContext.logAppInfo("Running in headless mode, glutDisplayFun not initialised");
-        glutDisplayFunc(__DEFAULT_DISPLAY_FUNC);
-    } else {
-        glutDisplayFunc(__DISPLAY);
-        debugContext.logApiInfo("Initialised glutDisplayFunc [__DISPLAY] at: " + ADDR_OF(__DISPLAY));
-    }
+    __GL_INIT();
+    glutDisplayFunc(__DISPLAY);
+    debugContext.logApiInfo("Initialised glutDisplayFunc [__DISPLAY] at: " + ADDR_OF(__DISPLAY));
     glutReshapeFunc(__WINDOW_RESHAPE);
     debugContext.logApiInfo("Initialised glutReshapeFunc [__WINDOW_RESHAPE] at: " + ADDR_OF(__WINDOW_RESHAPE));
     glutKeyboardFunc(__KEY_HANDLER);
     debugContext.logApiInfo("Initialised glutKeyboardFunc [__KEY_HANDLER] at: " + ADDR_OF(__KEY_HANDLER));
+    // Keys are held state, read by every simulation step, so repeats are not wanted
+    glutIgnoreKeyRepeat(1);
+    glutKeyboardUpFunc(__KEY_UP_HANDLER);
+    debugContext.logApiInfo("Initialised glutKeyboardUpFunc [__KEY_UP_HANDLER] at: " + ADDR_OF(__KEY_UP_HANDLER));
     glutMouseFunc(__MOUSE_HANDLER);
     debugContext.logApiInfo("Initialised glutMouseFunc [__MOUSE_HANDLER] at: " + ADDR_OF(__MOUSE_HANDLER));
     glutMotionFunc(__ACTIVE_MOTION_HANDLER);
@@ -377,4 +581,4 @@ int main(int argc, char* argv[]) {
     glutPostRedisplay();
     glutMainLoop();
     return 0;
-}
\ No newline at end of file
+}
@@ -16,6 +16,8 @@
 #include <stdlib.h>
 
 #include <algorithm>
+#include <bitset>
+#include <chrono>
 #include <exception>
 #include <iostream>
 #include <limits>
@@ -27,6 +29,7 @@
 #include <map>
 
 #include "../../io/configuration/ConfigInit.cpp"
+#include "../../io/configuration/ArgParser.cpp"
 #include "../drawing/DrawingUtils.hpp"
 #include "../drawing/RasterText.hpp"
 #include "../../environment/constructs/walls/AABB.cpp"
@@ -35,15 +38,26 @@
 #include "../../environment/world/World.cpp"
 #include "../partitioning/QSPTree.cpp"
 #include "../../logic/pathfinding/AStar.cpp"
+#include "../../logic/threading/WorkerPool.cpp"
+#include "../../logic/timing/FixedTimestep.cpp"
+#include "../../logic/timing/FrameStats.cpp"
 #include "../../environment/player/Player.cpp"
 #include "../colour/Colours.cpp"
+#include "../colour/FogTable.cpp"
 #include "../../io/resource_management/TextureLoader.cpp"
 #include "../texturing/texture.cpp"
+#include "../texturing/TextureAtlas.cpp"
+#include "../texturing/ColumnSampler.hpp"
 #include "../Globals.hpp"
-#include "Ray.hpp"
+#include "FrameRenderer.cpp"
 #include "../../io/resource_management/PNGReader.hpp"
+#include "../../io/resource_management/PPMWriter.hpp"
+#include "../../io/resource_management/InputRecording.cpp"
+#include "../viewmodel/CameraPath.hpp"
 #include "../../environment/constructs/sprites/Sprite.cpp"
 #include "../buffering/PBO.cpp"
+#include "../buffering/ResolutionScaler.cpp"
+#include "../buffering/OffscreenContext.cpp"
 #include "../../gui/minimap/Minimap.cpp"
 #include "../../gui/debug_overlay/DebugOverlay.cpp"
 #include "../../gui/stats_bar/StatsBar.cpp"
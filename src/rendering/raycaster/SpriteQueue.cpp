@@ -0,0 +1,212 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "../../environment/constructs/sprites/Sprite.cpp"
+#include "../viewmodel/Camera.hpp"
+
+using namespace std;
+
+namespace Rendering {
+
+// Sprites nearer the camera plane than this are culled. Closer up their projected size
+// overflows the int texture maths of the rasteriser for textures of up to 256 texels at 4K
+#define SPRITE_NEAR_PLANE 0.05
+// Pixels either side of a sprite's projected span that still count as on screen, covers the rasteriser's rounding
+#define SPRITE_CULL_SLACK 2
+// Moves per sprite the insertion sort may make before giving up and sorting from scratch
+#define SPRITE_SORT_MAX_SHIFTS 8
+// Low mantissa bits of the squared distance ignored when ordering. Sprites this close in distance
+// are drawn grouped by texture, within about 0.03% of the distance
+#define SPRITE_DEPTH_QUANTUM_BITS 12
+
+///
+/// Sprite left after culling, in camera space
+///
+struct SpriteDraw {
+    // Index in the world's sprites
+    uint32_t sprite;
+    TexHandle texture;
+    // Offset across the view, the screen edges are at -transform_y and transform_y
+    double transform_x;
+    // Distance to the camera plane
+    double transform_y;
+};
+
+///
+/// Run of consecutive draws sharing a texture
+///
+struct SpriteBatch {
+    uint32_t first;
+    uint32_t count;
+    TexHandle texture;
+};
+
+///
+/// Draw order of a world's sprites, kept from frame to frame. The sprites stay
+/// sorted far to near by squared distance, which turning doesn't change and a
+/// step only changes a little, so each frame's order is a few insertion sort
+/// moves away from the last. Sprites behind the camera, outside the view or
+/// beyond the maximum depth are then culled before any projection work
+///
+class SpriteQueue {
+    public:
+        SpriteQueue();
+
+        void update(const vector<Constructs::Sprite>& sprites, double origin_x, double origin_y,
+            const ViewModel::Camera& camera, int screen_width, int screen_height,
+            double max_depth = numeric_limits<double>::infinity());
+
+        const vector<SpriteDraw>& draws() const;
+        const vector<SpriteBatch>& batches() const;
+
+        // Sprites dropped by the last update
+        size_t culled;
+        // Insertion sort moves made by the last update
+        size_t shifts;
+        // True if the last update gave up on the insertion sort and sorted from scratch
+        bool resorted;
+    private:
+        struct Entry {
+            // Inverted quantised squared distance, then texture, so ascending keys run far to near
+            uint64_t key;
+            uint32_t sprite;
+
+            inline bool operator<(const Entry& other) const {
+                return this->key < other.key || (this->key == other.key && this->sprite < other.sprite);
+            }
+        };
+
+        void sortEntries();
+
+        vector<Entry> order;
+        vector<SpriteDraw> draw_list;
+        vector<SpriteBatch> batch_list;
+};
+
+SpriteQueue::SpriteQueue():
+    culled(0),
+    shifts(0),
+    resorted(false)
+{};
+
+///
+/// Re-sort the sprites for a camera position and collect the visible ones, far to near
+///
+/// @param vector<Sprite> sprites: World sprites, in a fixed order between updates
+/// @param double origin_x: Camera position in world units
+/// @param double origin_y: Camera position in world units
+/// @param Camera camera: View direction (frustrum) and camera plane
+/// @param int screen_width: Pixels
+/// @param int screen_height: Pixels
+/// @param double max_depth: Sprites further from the camera plane than this are culled
+///
+/// @return void
+///
+void SpriteQueue::update(const vector<Constructs::Sprite>& sprites, double origin_x, double origin_y,
+    const ViewModel::Camera& camera, int screen_width, int screen_height, double max_depth) {
+    if (this->order.size() != sprites.size()) {
+        // Sprites were added or removed, start again from load order
+        this->order.resize(sprites.size());
+        for (size_t i = 0; i < sprites.size(); i++) {
+            this->order[i].sprite = (uint32_t) i;
+        }
+    }
+
+    float distance;
+    uint32_t distance_bits;
+    double dx, dy;
+    for (Entry& entry : this->order) {
+        const Constructs::Sprite& sprite = sprites[entry.sprite];
+        dx = sprite.location.x - origin_x;
+        dy = sprite.location.y - origin_y;
+        // The bits of a positive float order as the float does
+        distance = (float) (dx * dx + dy * dy);
+        memcpy(&distance_bits, &distance, sizeof(distance_bits));
+        distance_bits = distance_bits >> SPRITE_DEPTH_QUANTUM_BITS << SPRITE_DEPTH_QUANTUM_BITS;
+        entry.key = (uint64_t) ~distance_bits << 32 | sprite.texture;
+    }
+    this->sortEntries();
+
+    const double dir_x = camera.frustrum.getFovX();
+    const double dir_y = camera.frustrum.getFovY();
+    const double inverse_det = 1.0 / (camera.clip_plane_x * dir_y - dir_x * camera.clip_plane_y);
+    // A sprite is as wide on screen as it is tall, screen_height / transform_y, so it is in view while
+    // screen_width * |transform_x| < screen_width * transform_y + screen_height, with the slack on each side
+    const double cull_width = screen_width + 2 * SPRITE_CULL_SLACK;
+    SpriteDraw draw;
+    this->draw_list.clear();
+    this->batch_list.clear();
+    for (const Entry& entry : this->order) {
+        const Constructs::Sprite& sprite = sprites[entry.sprite];
+        dx = sprite.location.x - origin_x;
+        dy = sprite.location.y - origin_y;
+        draw.transform_y = inverse_det * (-camera.clip_plane_y * dx + camera.clip_plane_x * dy);
+        if (!(draw.transform_y >= SPRITE_NEAR_PLANE && draw.transform_y <= max_depth)) {
+            continue;
+        }
+        draw.transform_x = inverse_det * (dir_y * dx - dir_x * dy);
+        if (fabs(draw.transform_x) * screen_width > draw.transform_y * cull_width + screen_height) {
+            continue;
+        }
+        draw.sprite = entry.sprite;
+        draw.texture = sprite.texture;
+        if (this->batch_list.empty() || this->batch_list.back().texture != draw.texture) {
+            this->batch_list.push_back(SpriteBatch{(uint32_t) this->draw_list.size(), 0, draw.texture});
+        }
+        this->batch_list.back().count++;
+        this->draw_list.push_back(draw);
+    }
+    this->culled = sprites.size() - this->draw_list.size();
+};
+
+///
+/// Insertion sort the entries from last frame's order, or sort them from
+/// scratch if they have moved too far for that to be cheap
+///
+/// @return void
+///
+void SpriteQueue::sortEntries() {
+    const size_t budget = this->order.size() * SPRITE_SORT_MAX_SHIFTS;
+    Entry entry;
+    size_t j;
+    this->shifts = 0;
+    this->resorted = false;
+    for (size_t i = 1; i < this->order.size(); i++) {
+        if (!(this->order[i] < this->order[i - 1])) {
+            continue;
+        }
+        entry = this->order[i];
+        for (j = i; j > 0 && entry < this->order[j - 1]; j--) {
+            this->order[j] = this->order[j - 1];
+        }
+        this->order[j] = entry;
+        this->shifts += i - j;
+        if (this->shifts > budget) {
+            sort(this->order.begin(), this->order.end());
+            this->resorted = true;
+            return;
+        }
+    }
+};
+
+///
+/// @return vector<SpriteDraw>: Sprites left by the last update, far to near
+///
+const vector<SpriteDraw>& SpriteQueue::draws() const {
+    return this->draw_list;
+};
+
+///
+/// @return vector<SpriteBatch>: The draws split into runs of one texture, in draw order
+///
+const vector<SpriteBatch>& SpriteQueue::batches() const {
+    return this->batch_list;
+};
+}
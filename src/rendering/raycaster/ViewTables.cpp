@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vector>
+
+#include "../Globals.hpp"
+
+using namespace std;
+
+namespace Rendering {
+
+///
+/// Per resolution terms of the projection that would otherwise be divided out
+/// again every frame. Only depends on the screen size, rebuild on reshape
+///
+class ViewTables {
+    public:
+        ViewTables();
+        ViewTables(int width, int height);
+
+        void rebuild(int width, int height);
+
+        int width;
+        int height;
+        // Column offset along the camera plane, -1 at the left edge to 1 at the right
+        vector<double> camera_x;
+        // Distance to the floor seen by row y below the horizon, 0 at and above it
+        vector<double> row_distance;
+        // row_distance / width, the world step between neighbouring columns per unit of camera plane
+        vector<double> row_step_scale;
+        // 1 / row_distance, 0 at and above the horizon
+        vector<double> row_inv_distance;
+};
+
+ViewTables::ViewTables():
+    width(0),
+    height(0)
+{};
+
+ViewTables::ViewTables(int width, int height) {
+    rebuild(width, height);
+};
+
+///
+/// Recompute every table for a new screen size
+///
+/// @param int width: Screen width
+/// @param int height: Screen height
+///
+/// @return void
+///
+void ViewTables::rebuild(int width, int height) {
+    this->width = width;
+    this->height = height;
+
+    this->camera_x.resize(width);
+    for (int x = 0; x < width; x++) {
+        this->camera_x[x] = 2 * x / double(width) - 1;
+    }
+
+    this->row_distance.assign(height, 0.0);
+    this->row_step_scale.assign(height, 0.0);
+    this->row_inv_distance.assign(height, 0.0);
+    for (int y = IDIV_2(height) + 1; y < height; y++) {
+        double dist = (0.5 * width) / (y - IDIV_2(height));
+        this->row_distance[y] = dist;
+        this->row_step_scale[y] = dist / width;
+        this->row_inv_distance[y] = 1 / dist;
+    }
+    debugContext.logApiInfo("Built view tables for " + to_string(width) + "*" + to_string(height));
+};
+}
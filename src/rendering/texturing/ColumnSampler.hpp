@@ -0,0 +1,182 @@
+#pragma once
+
+#include <stdint.h>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__)) && !defined(COLUMN_SAMPLER_SCALAR)
+    #include <immintrin.h>
+    #define COLUMN_SAMPLER_X86 1
+#endif
+
+using namespace std;
+
+namespace Rendering {
+
+///
+/// One vertical run of texels sampled from a single texture column.
+/// Texture v is an unsigned 0.32 fraction of the texture height, so stepping
+/// past the bottom wraps back to the top for free, as the & mask it replaces did
+///
+struct ColumnSpan {
+    // First texel of the texture column, rows are 1 << width_shift texels apart
+    const uint32_t* texels;
+    uint32_t width_shift;
+    // 32 - log2(texture height), turns v into a texel row
+    uint32_t row_shift;
+    // v of the first output pixel and the (wrapping) increment per output pixel
+    uint32_t v;
+    uint32_t v_step;
+    // Branch free side shading, out = (texel >> shade_shift) & shade_mask
+    uint32_t shade_shift;
+    uint32_t shade_mask;
+};
+
+///
+/// Convert a texel row position into 0.32 fixed point v
+///
+/// @param double row: Texture row, may be fractional or outside the texture
+/// @param uint32_t height_shift: log2 of the texture height
+///
+/// @return uint32_t: Wrapped v
+///
+inline uint32_t toColumnV(double row, uint32_t height_shift) {
+    return (uint32_t) (int64_t) (row * (double) (1ull << (32 - height_shift)));
+}
+
+///
+/// Reference sampler, one texel at a time
+///
+/// @param ColumnSpan span: Texture column and stepping
+/// @param uint32_t* out: Destination, count contiguous pixels
+/// @param int count: Pixels to write
+///
+/// @return void
+///
+inline void sampleColumnScalar(const ColumnSpan& span, uint32_t* out, int count) {
+    uint32_t v = span.v;
+    for (int i = 0; i < count; i++, v += span.v_step) {
+        uint32_t texel = span.texels[(uint32_t) ((uint64_t) v >> span.row_shift) << span.width_shift];
+        out[i] = (texel >> span.shade_shift) & span.shade_mask;
+    }
+}
+
+#ifdef COLUMN_SAMPLER_X86
+///
+/// SSE2 sampler, v and the texel offsets are computed 4 at a time, texels are
+/// fetched with scalar loads since SSE has no gather, then shaded and stored as a vector
+///
+/// @param ColumnSpan span: Texture column and stepping
+/// @param uint32_t* out: Destination, count contiguous pixels
+/// @param int count: Pixels to write
+///
+/// @return void
+///
+__attribute__((target("sse2")))
+inline void sampleColumnSSE2(const ColumnSpan& span, uint32_t* out, int count) {
+    const __m128i row_shift = _mm_cvtsi32_si128(span.row_shift);
+    const __m128i width_shift = _mm_cvtsi32_si128(span.width_shift);
+    const __m128i shade_shift = _mm_cvtsi32_si128(span.shade_shift);
+    const __m128i shade_mask = _mm_set1_epi32(span.shade_mask);
+    const __m128i v_step = _mm_set1_epi32(span.v_step * 4);
+    __m128i v = _mm_setr_epi32(span.v, span.v + span.v_step, span.v + span.v_step * 2, span.v + span.v_step * 3);
+    alignas(16) uint32_t offsets[4];
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        // Shifts of 32 or more give 0 in SSE, which is right for 1 texel high textures
+        _mm_store_si128((__m128i*) offsets, _mm_sll_epi32(_mm_srl_epi32(v, row_shift), width_shift));
+        __m128i texels = _mm_setr_epi32(
+            span.texels[offsets[0]], span.texels[offsets[1]], span.texels[offsets[2]], span.texels[offsets[3]]);
+        _mm_storeu_si128((__m128i*) (out + i), _mm_and_si128(_mm_srl_epi32(texels, shade_shift), shade_mask));
+        v = _mm_add_epi32(v, v_step);
+    }
+    ColumnSpan tail = span;
+    tail.v = span.v + span.v_step * i;
+    sampleColumnScalar(tail, out + i, count - i);
+}
+
+///
+/// AVX2 sampler, 8 pixels at a time with the texels fetched by a hardware gather
+///
+/// @param ColumnSpan span: Texture column and stepping
+/// @param uint32_t* out: Destination, count contiguous pixels
+/// @param int count: Pixels to write
+///
+/// @return void
+///
+__attribute__((target("avx2")))
+inline void sampleColumnAVX2(const ColumnSpan& span, uint32_t* out, int count) {
+    const __m128i row_shift = _mm_cvtsi32_si128(span.row_shift);
+    const __m128i width_shift = _mm_cvtsi32_si128(span.width_shift);
+    const __m128i shade_shift = _mm_cvtsi32_si128(span.shade_shift);
+    const __m256i shade_mask = _mm256_set1_epi32(span.shade_mask);
+    const __m256i v_step = _mm256_set1_epi32(span.v_step * 8);
+    __m256i v = _mm256_add_epi32(
+        _mm256_set1_epi32(span.v),
+        _mm256_mullo_epi32(_mm256_set1_epi32(span.v_step), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i offsets = _mm256_sll_epi32(_mm256_srl_epi32(v, row_shift), width_shift);
+        __m256i texels = _mm256_i32gather_epi32((const int*) span.texels, offsets, 4);
+        _mm256_storeu_si256((__m256i*) (out + i), _mm256_and_si256(_mm256_srl_epi32(texels, shade_shift), shade_mask));
+        v = _mm256_add_epi32(v, v_step);
+    }
+    ColumnSpan tail = span;
+    tail.v = span.v + span.v_step * i;
+    sampleColumnSSE2(tail, out + i, count - i);
+}
+#endif
+
+typedef void (*ColumnSampler)(const ColumnSpan& span, uint32_t* out, int count);
+
+///
+/// Pick the widest sampler the CPU supports, build with COLUMN_SAMPLER_SCALAR
+/// defined to force the reference sampler
+///
+/// @return ColumnSampler
+///
+inline ColumnSampler selectColumnSampler() {
+#ifdef COLUMN_SAMPLER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return sampleColumnAVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return sampleColumnSSE2;
+    }
+#endif
+    return sampleColumnScalar;
+}
+
+///
+/// Sample a texture column into count contiguous pixels with the best sampler for this CPU
+///
+/// @param ColumnSpan span: Texture column and stepping
+/// @param uint32_t* out: Destination, count contiguous pixels
+/// @param int count: Pixels to write
+///
+/// @return void
+///
+inline void sampleColumn(const ColumnSpan& span, uint32_t* out, int count) {
+    static const ColumnSampler sampler = selectColumnSampler();
+    sampler(span, out, count);
+}
+
+///
+/// Sample a texture column of palette indices, shading through a colormap.
+/// The span's addressing is the same as for packed texels, its texels and
+/// shade fields are unused
+///
+/// @param ColumnSpan span: Texture column and stepping
+/// @param uint8_t* texels: Palette index of the first texel of the texture column
+/// @param uint8_t* colormap: Shaded and fogged index of every palette index
+/// @param uint8_t* out: Destination, count contiguous pixels
+/// @param int count: Pixels to write
+///
+/// @return void
+///
+inline void sampleIndexedColumn(const ColumnSpan& span, const uint8_t* texels, const uint8_t* colormap, uint8_t* out, int count) {
+    uint32_t v = span.v;
+    for (int i = 0; i < count; i++, v += span.v_step) {
+        out[i] = colormap[texels[(uint32_t) ((uint64_t) v >> span.row_shift) << span.width_shift]];
+    }
+}
+}
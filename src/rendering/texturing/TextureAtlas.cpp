@@ -0,0 +1,486 @@
+#pragma once
+
+#include <math.h>
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../Globals.hpp"
+#include "../colour/Palette.cpp"
+#include "texture.cpp"
+#include "../../exceptions/textureLoader/TextureDimensionError.hpp"
+
+using namespace std;
+
+namespace Rendering {
+
+#define ATLAS_MISSING_COLOUR 0xFF00FF
+
+///
+/// Order of the texels of one texture level. Every layout holds each level at
+/// the same offset, only the order within it differs
+///
+enum TexelLayout {
+    // y * width + x, as loaded
+    ROW_MAJOR,
+    // x * height + y, for walls and sprites which are sampled a column at a time
+    COLUMN_MAJOR,
+    // Z order, x and y bits interleaved, for floors and ceilings which are walked in any direction
+    MORTON
+};
+
+struct AtlasEntry {
+    uint32_t offset;
+    uint32_t width;
+    uint32_t height;
+    uint32_t width_shift;
+    uint32_t width_mask;
+    uint32_t height_shift;
+    uint32_t height_mask;
+    // Mip levels including this one, and where level 1 is in the atlas' mip entries
+    uint32_t levels;
+    uint32_t mip_index;
+    // Where the Morton swizzle of x, then of y, is in the atlas' swizzle tables
+    uint32_t swizzle;
+};
+
+///
+/// All loaded textures packed end to end into one texel array, addressed by
+/// integer handles resolved once at load time. Handle 0 is always a generated
+/// placeholder used for texture names that could not be resolved.
+///
+/// Each texture is followed by its mip chain, every level a 2x2 box filtered
+/// half of the one before down to 1x1, so distant surfaces can sample a level
+/// with about one texel per pixel instead of striding across the full texture.
+///
+/// Texels are kept in a layout for each way they are sampled: row major as
+/// loaded, column major so a wall column reads consecutive texels, and Morton
+/// order so a floor row reads 4x4 blocks of texels per cache line whichever way
+/// the camera faces. Morton offsets are looked up per level in two swizzle
+/// tables, x and y, whose entries are or'd together.
+///
+/// For indexed colour rendering the atlas can also hold every texel quantized
+/// to a palette, in the same layouts and at the same offsets as the packed texels
+///
+class TextureAtlas {
+    public:
+        TextureAtlas();
+
+        void build(const map<string, Texture>& textures, int fallback_width, int fallback_height, bool mipmaps = true);
+        TexHandle handle(const string& name) const;
+        TexHandle require(const string& name) const;
+
+        inline const AtlasEntry& entry(TexHandle handle) const;
+        inline const AtlasEntry& level(TexHandle handle, uint32_t level) const;
+        inline const uint32_t* texels(TexHandle handle) const;
+        inline const uint32_t* texels(const AtlasEntry& entry, TexelLayout layout = ROW_MAJOR) const;
+        inline const uint32_t* swizzle(const AtlasEntry& entry) const;
+        inline uint32_t sample(TexHandle handle, uint32_t u, uint32_t v) const;
+        void quantize(const Palette& palette);
+        inline bool quantized() const;
+        inline const uint8_t* indices(TexHandle handle) const;
+        inline const uint8_t* indices(const AtlasEntry& entry, TexelLayout layout = ROW_MAJOR) const;
+        inline const vector<uint32_t>& allTexels() const;
+        static inline uint32_t mipLevel(const AtlasEntry& entry, double texels_per_pixel);
+        const string& name(TexHandle handle) const;
+        size_t size() const;
+    private:
+        bool add(const string& name, const PNGTex& texels, unsigned long width, unsigned long height);
+        void addMips(AtlasEntry& entry);
+        static uint32_t log2(unsigned long value);
+        static inline uint32_t average(uint32_t a, uint32_t b, uint32_t c, uint32_t d);
+        static uint32_t spread(uint32_t value, uint32_t interleaved_bits, uint32_t first_bit);
+        void addSwizzle(AtlasEntry& entry);
+        template <typename Texel>
+        void relayout(const vector<Texel>& rows, vector<Texel>& columns, vector<Texel>& morton) const;
+
+        bool mipmaps;
+        // Row major texels, and the same texels in the other layouts
+        vector<uint32_t> data;
+        vector<uint32_t> column_data;
+        vector<uint32_t> morton_data;
+        // Palette index of every texel in each layout, empty until quantized
+        vector<uint8_t> indexed;
+        vector<uint8_t> column_indexed;
+        vector<uint8_t> morton_indexed;
+        vector<uint32_t> swizzles;
+        vector<AtlasEntry> entries;
+        vector<AtlasEntry> mip_entries;
+        vector<string> names;
+        unordered_map<string, TexHandle> lookup;
+};
+
+TextureAtlas::TextureAtlas():
+    mipmaps(true)
+{};
+
+uint32_t TextureAtlas::log2(unsigned long value) {
+    uint32_t shift = 0;
+    while ((1UL << shift) < value) {
+        shift++;
+    }
+    return shift;
+};
+
+bool TextureAtlas::add(const string& name, const PNGTex& texels, unsigned long width, unsigned long height) {
+    if (width == 0 || height == 0 || (width & (width - 1)) != 0 || (height & (height - 1)) != 0) {
+        if (!loggingCfg.tex_skip_invalid) {
+            throw TextureDimensionError(name, width, height);
+        }
+        debugContext.glDebugMessageCallback(
+            GL_DEBUG_SOURCE::DEBUG_SOURCE_APPLICATION,
+            GL_DEBUG_TYPE::DEBUG_TYPE_ERROR,
+            GL_DEBUG_SEVERITY::DEBUG_SEVERITY_LOW,
+            "[" + name + "] Texture dimensions are not powers of two, skipping."
+        );
+        return false;
+    }
+    AtlasEntry entry;
+    entry.offset = this->data.size();
+    entry.width = width;
+    entry.height = height;
+    entry.width_shift = log2(width);
+    entry.width_mask = width - 1;
+    entry.height_shift = log2(height);
+    entry.height_mask = height - 1;
+    entry.levels = 1;
+    entry.mip_index = this->mip_entries.size();
+    size_t count = min(texels.size(), (size_t) (width * height));
+    this->data.insert(this->data.end(), texels.begin(), texels.begin() + count);
+    this->data.resize(entry.offset + width * height, 0);
+    if (this->mipmaps) {
+        addMips(entry);
+    }
+    this->lookup[name] = this->entries.size();
+    this->entries.push_back(entry);
+    this->names.push_back(name);
+    return true;
+};
+
+///
+/// Average four packed texels channel by channel, rounding to nearest
+///
+/// @return uint32_t: Packed texel
+///
+inline uint32_t TextureAtlas::average(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+    uint32_t out = 0;
+    for (uint32_t shift = 0; shift < 32; shift += 8) {
+        uint32_t sum = ((a >> shift) & 0xFF) + ((b >> shift) & 0xFF) + ((c >> shift) & 0xFF) + ((d >> shift) & 0xFF);
+        out |= ((sum + 2) >> 2) << shift;
+    }
+    return out;
+};
+
+///
+/// Append the mip chain of the texture just added, each level filtered from the
+/// one before. A side already 1 texel long stays 1 while the other halves
+///
+/// @param AtlasEntry& entry: Level 0 of the texture, its level count is filled in
+///
+/// @return void
+///
+void TextureAtlas::addMips(AtlasEntry& entry) {
+    AtlasEntry above = entry;
+    while (above.width > 1 || above.height > 1) {
+        AtlasEntry mip = above;
+        mip.width = max(above.width >> 1, 1u);
+        mip.height = max(above.height >> 1, 1u);
+        mip.width_shift = log2(mip.width);
+        mip.width_mask = mip.width - 1;
+        mip.height_shift = log2(mip.height);
+        mip.height_mask = mip.height - 1;
+        mip.offset = this->data.size();
+        mip.levels = 1;
+        this->data.resize(mip.offset + mip.width * mip.height);
+        const uint32_t* src = this->data.data() + above.offset;
+        uint32_t* dst = this->data.data() + mip.offset;
+        uint32_t dx = above.width > 1 ? 1 : 0;
+        uint32_t dy = above.height > 1 ? above.width : 0;
+        for (uint32_t y = 0; y < mip.height; y++) {
+            for (uint32_t x = 0; x < mip.width; x++) {
+                const uint32_t* quad = src + ((y * (dy ? 2 : 1)) << above.width_shift) + x * (dx + 1);
+                dst[(y << mip.width_shift) + x] = average(quad[0], quad[dx], quad[dy], quad[dx + dy]);
+            }
+        }
+        this->mip_entries.push_back(mip);
+        entry.levels++;
+        above = mip;
+    }
+};
+
+///
+/// Pack the loaded textures into the atlas, handles are assigned in map order
+///
+/// @param map<string, Texture> textures: Textures by name from the TextureLoader
+/// @param int fallback_width: Width of the generated placeholder texture
+/// @param int fallback_height: Height of the generated placeholder texture
+/// @param bool mipmaps: Build a mip chain for every texture, otherwise textures only have level 0
+///
+/// @return void
+///
+void TextureAtlas::build(const map<string, Texture>& textures, int fallback_width, int fallback_height, bool mipmaps) {
+    this->mipmaps = mipmaps;
+    this->data.clear();
+    this->indexed.clear();
+    this->column_indexed.clear();
+    this->morton_indexed.clear();
+    this->swizzles.clear();
+    this->entries.clear();
+    this->mip_entries.clear();
+    this->names.clear();
+    this->lookup.clear();
+
+    PNGTex missing(fallback_width * fallback_height);
+    for (int y = 0; y < fallback_height; y++) {
+        for (int x = 0; x < fallback_width; x++) {
+            missing[y * fallback_width + x] = ((x >> 3) ^ (y >> 3)) & 1 ? ATLAS_MISSING_COLOUR : 0;
+        }
+    }
+    add("", missing, fallback_width, fallback_height);
+    this->lookup.clear();
+
+    for (const pair<const string, Texture>& tex : textures) {
+        if (add(tex.first, tex.second.texture, tex.second.width, tex.second.height)) {
+            debugContext.logAppVerb("Packed texture [" + tex.first + "] as handle " + to_string(this->entries.size() - 1));
+        }
+    }
+    for (AtlasEntry& entry : this->entries) {
+        addSwizzle(entry);
+    }
+    for (AtlasEntry& entry : this->mip_entries) {
+        addSwizzle(entry);
+    }
+    relayout(this->data, this->column_data, this->morton_data);
+    debugContext.logAppInfo("Built texture atlas with " + to_string(this->entries.size()) + " entries ("
+        + to_string(this->data.size() * sizeof(uint32_t)) + " bytes per layout)");
+};
+
+///
+/// Spread the bits of a texel coordinate to its place in a Morton offset. The
+/// low bits of x and y alternate, the bits the longer side has over the shorter
+/// one go on top
+///
+/// @param uint32_t value: Texel x or y
+/// @param uint32_t interleaved_bits: log2 of the shorter side
+/// @param uint32_t first_bit: 0 for x, 1 for y
+///
+/// @return uint32_t: Offset bits of the coordinate
+///
+uint32_t TextureAtlas::spread(uint32_t value, uint32_t interleaved_bits, uint32_t first_bit) {
+    uint32_t out = (value >> interleaved_bits) << (2 * interleaved_bits);
+    for (uint32_t bit = 0; bit < interleaved_bits; bit++) {
+        out |= ((value >> bit) & 1) << (2 * bit + first_bit);
+    }
+    return out;
+};
+
+///
+/// Append the Morton swizzle tables of a level, width entries for x then height entries for y
+///
+/// @param AtlasEntry& entry: Level, its swizzle offset is filled in
+///
+/// @return void
+///
+void TextureAtlas::addSwizzle(AtlasEntry& entry) {
+    uint32_t interleaved_bits = min(entry.width_shift, entry.height_shift);
+    entry.swizzle = this->swizzles.size();
+    for (uint32_t x = 0; x < entry.width; x++) {
+        this->swizzles.push_back(spread(x, interleaved_bits, 0));
+    }
+    for (uint32_t y = 0; y < entry.height; y++) {
+        this->swizzles.push_back(spread(y, interleaved_bits, 1));
+    }
+};
+
+///
+/// Copy row major texels of every texture and level into the other layouts
+///
+/// @param vector<Texel> rows: Row major texels or indices
+/// @param vector<Texel>& columns: Resized and filled in column major
+/// @param vector<Texel>& morton: Resized and filled in Morton order
+///
+/// @return void
+///
+template <typename Texel>
+void TextureAtlas::relayout(const vector<Texel>& rows, vector<Texel>& columns, vector<Texel>& morton) const {
+    columns.resize(rows.size());
+    morton.resize(rows.size());
+    for (const vector<AtlasEntry>* levels : {&this->entries, &this->mip_entries}) {
+        for (const AtlasEntry& entry : *levels) {
+            const Texel* src = rows.data() + entry.offset;
+            const uint32_t* swizzle_x = this->swizzles.data() + entry.swizzle;
+            const uint32_t* swizzle_y = swizzle_x + entry.width;
+            for (uint32_t y = 0; y < entry.height; y++) {
+                for (uint32_t x = 0; x < entry.width; x++) {
+                    columns[entry.offset + (x << entry.height_shift) + y] = src[(y << entry.width_shift) + x];
+                    morton[entry.offset + (swizzle_x[x] | swizzle_y[y])] = src[(y << entry.width_shift) + x];
+                }
+            }
+        }
+    }
+};
+
+///
+/// Resolve a texture name to its handle. An empty name has no texture,
+/// unknown names resolve to the placeholder texture
+///
+/// @param string name: Texture name as used in map files
+///
+/// @return TexHandle
+///
+TexHandle TextureAtlas::handle(const string& name) const {
+    if (name.empty()) {
+        return TEX_HANDLE_NONE;
+    }
+    unordered_map<string, TexHandle>::const_iterator it = this->lookup.find(name);
+    if (it == this->lookup.end()) {
+        debugContext.glDebugMessageCallback(
+            GL_DEBUG_SOURCE::DEBUG_SOURCE_APPLICATION,
+            GL_DEBUG_TYPE::DEBUG_TYPE_ERROR,
+            GL_DEBUG_SEVERITY::DEBUG_SEVERITY_LOW,
+            "[" + name + "] Unknown texture, using placeholder."
+        );
+        return TEX_HANDLE_MISSING;
+    }
+    return it->second;
+};
+
+///
+/// Resolve a texture name for something that is always drawn, an empty
+/// name resolves to the placeholder texture instead of no texture
+///
+/// @param string name: Texture name as used in map files
+///
+/// @return TexHandle
+///
+TexHandle TextureAtlas::require(const string& name) const {
+    TexHandle ret_val = handle(name);
+    return ret_val == TEX_HANDLE_NONE ? TEX_HANDLE_MISSING : ret_val;
+};
+
+inline const AtlasEntry& TextureAtlas::entry(TexHandle handle) const {
+    return this->entries[handle];
+};
+
+///
+/// @param TexHandle handle: Texture
+/// @param uint32_t level: Mip level, 0 is full size, clamped to the smallest level
+///
+/// @return AtlasEntry: Dimensions and offset of the level
+///
+inline const AtlasEntry& TextureAtlas::level(TexHandle handle, uint32_t level) const {
+    const AtlasEntry& entry = this->entries[handle];
+    level = min(level, entry.levels - 1);
+    return level == 0 ? entry : this->mip_entries[entry.mip_index + level - 1];
+};
+
+inline const uint32_t* TextureAtlas::texels(TexHandle handle) const {
+    return this->data.data() + this->entries[handle].offset;
+};
+
+///
+/// @param AtlasEntry entry: Texture or one of its mip levels
+/// @param TexelLayout layout: Order of the texels
+///
+/// @return uint32_t*: First texel of the level
+///
+inline const uint32_t* TextureAtlas::texels(const AtlasEntry& entry, TexelLayout layout) const {
+    switch (layout) {
+        case COLUMN_MAJOR:
+            return this->column_data.data() + entry.offset;
+        case MORTON:
+            return this->morton_data.data() + entry.offset;
+        default:
+            return this->data.data() + entry.offset;
+    }
+};
+
+///
+/// Morton offset of texel (x, y) of a level is swizzle[x] | swizzle[width + y]
+///
+/// @param AtlasEntry entry: Texture or one of its mip levels
+///
+/// @return uint32_t*: Swizzle tables of the level
+///
+inline const uint32_t* TextureAtlas::swizzle(const AtlasEntry& entry) const {
+    return this->swizzles.data() + entry.swizzle;
+};
+
+///
+/// Mip level to sample for a surface drawn at a given density, the largest
+/// level that still has at least one texel per pixel
+///
+/// @param AtlasEntry entry: Level 0 of the texture
+/// @param double texels_per_pixel: Level 0 texels crossed per screen pixel
+///
+/// @return uint32_t: Level, 0 when magnified or with no mip chain
+///
+inline uint32_t TextureAtlas::mipLevel(const AtlasEntry& entry, double texels_per_pixel) {
+    if (!(texels_per_pixel >= 2)) {
+        return 0;
+    }
+    return min((uint32_t) ilogb(texels_per_pixel), entry.levels - 1);
+};
+
+inline uint32_t TextureAtlas::sample(TexHandle handle, uint32_t u, uint32_t v) const {
+    const AtlasEntry& e = this->entries[handle];
+    return this->data[e.offset + ((v & e.height_mask) << e.width_shift) + (u & e.width_mask)];
+};
+
+///
+/// Quantize every texel, mip levels included, to the nearest colour of a palette
+///
+/// @param Palette palette: Palette built for these texels
+///
+/// @return void
+///
+void TextureAtlas::quantize(const Palette& palette) {
+    this->indexed.resize(this->data.size());
+    palette.quantize(this->data.data(), this->data.size(), this->indexed.data());
+    relayout(this->indexed, this->column_indexed, this->morton_indexed);
+    debugContext.logAppInfo("Quantized texture atlas to " + to_string(palette.size()) + " colours ("
+        + to_string(this->indexed.size()) + " bytes per layout)");
+};
+
+inline bool TextureAtlas::quantized() const {
+    return !this->indexed.empty();
+};
+
+inline const uint8_t* TextureAtlas::indices(TexHandle handle) const {
+    return this->indexed.data() + this->entries[handle].offset;
+};
+
+///
+/// @param AtlasEntry entry: Texture or one of its mip levels
+/// @param TexelLayout layout: Order of the texels
+///
+/// @return uint8_t*: Palette index of the first texel of the level, only valid once quantized
+///
+inline const uint8_t* TextureAtlas::indices(const AtlasEntry& entry, TexelLayout layout) const {
+    switch (layout) {
+        case COLUMN_MAJOR:
+            return this->column_indexed.data() + entry.offset;
+        case MORTON:
+            return this->morton_indexed.data() + entry.offset;
+        default:
+            return this->indexed.data() + entry.offset;
+    }
+};
+
+///
+/// @return vector<uint32_t>: Every packed texel of every texture and level
+///
+inline const vector<uint32_t>& TextureAtlas::allTexels() const {
+    return this->data;
+};
+
+const string& TextureAtlas::name(TexHandle handle) const {
+    return this->names[handle];
+};
+
+size_t TextureAtlas::size() const {
+    return this->entries.size();
+};
+}
@@ -42,7 +42,7 @@ Texture::Texture(string filename, string name) {
     if (error) {
         throw ImageFileStreamError(filename);
     }
-    this->texture.resize(64 * 64);
+    this->texture.resize(this->width * this->height);
 };
 
 Texture::~Texture() {};
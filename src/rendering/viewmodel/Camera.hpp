@@ -1,5 +1,7 @@
 #pragma once
 
+#include <math.h>
+
 #include "Frustrum.hpp"
 
 using namespace std;
@@ -14,4 +16,30 @@ struct Camera {
     Frustrum frustrum;
 };
 
-}
\ No newline at end of file
+///
+/// Camera part of the way between two others. The position moves in a straight
+/// line and the direction and clip plane turn through the smaller angle between
+/// them, so their lengths, and the FOV, are kept
+///
+/// @param Camera from: Camera at alpha 0
+/// @param Camera to: Camera at alpha 1
+/// @param double alpha: Share of the way from one to the other
+///
+/// @return Camera
+///
+inline Camera interpolate(const Camera& from, const Camera& to, double alpha) {
+    double from_x = from.frustrum.getFovX(), from_y = from.frustrum.getFovY();
+    double to_x = to.frustrum.getFovX(), to_y = to.frustrum.getFovY();
+    double turn = alpha * atan2(from_x * to_y - from_y * to_x, from_x * to_x + from_y * to_y);
+    double turn_cos = cos(turn), turn_sin = sin(turn);
+    Camera camera = from;
+    camera.x = from.x + (to.x - from.x) * alpha;
+    camera.y = from.y + (to.y - from.y) * alpha;
+    camera.frustrum.setFovX(from_x * turn_cos - from_y * turn_sin);
+    camera.frustrum.setFovY(from_x * turn_sin + from_y * turn_cos);
+    camera.clip_plane_x = from.clip_plane_x * turn_cos - from.clip_plane_y * turn_sin;
+    camera.clip_plane_y = from.clip_plane_x * turn_sin + from.clip_plane_y * turn_cos;
+    return camera;
+}
+
+}
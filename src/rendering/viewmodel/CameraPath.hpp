@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../../exceptions/viewmodel/CameraPathFormatError.hpp"
+
+using namespace std;
+
+namespace ViewModel {
+
+#define CAMERA_PATH_COMMENT '#'
+
+struct CameraPose {
+    double x;
+    double y;
+    double angle;
+};
+
+class CameraPath {
+    public:
+        CameraPath();
+        CameraPath(vector<CameraPose> keyframes);
+
+        static CameraPath fromFile(const string& filename);
+        static CameraPath spin(double x, double y, double start_angle);
+
+        CameraPose sample(int frame, int frame_count) const;
+        size_t size() const;
+    private:
+        vector<CameraPose> keyframes;
+};
+
+CameraPath::CameraPath(){};
+
+CameraPath::CameraPath(vector<CameraPose> keyframes) {
+    this->keyframes = keyframes;
+};
+
+///
+/// Read a camera path, one keyframe per line as: x y angle
+/// with the angle in degrees. Blank lines and lines starting
+/// with '#' are ignored
+///
+/// @param string filename: Path to the camera path file
+///
+/// @return CameraPath
+///
+CameraPath CameraPath::fromFile(const string& filename) {
+    ifstream file(filename);
+    if (!file.is_open()) {
+        throw CameraPathFormatError(filename, "Unable to open file");
+    }
+    vector<CameraPose> poses;
+    string line;
+    int line_no = 0;
+    while (getline(file, line)) {
+        line_no++;
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == string::npos || line[first] == CAMERA_PATH_COMMENT) {
+            continue;
+        }
+        istringstream fields(line);
+        CameraPose pose;
+        if (!(fields >> pose.x >> pose.y >> pose.angle)) {
+            throw CameraPathFormatError(filename, "Expected 'x y angle' on line " + to_string(line_no));
+        }
+        pose.angle *= M_PI / 180.0;
+        poses.push_back(pose);
+    }
+    if (poses.empty()) {
+        throw CameraPathFormatError(filename, "No keyframes defined");
+    }
+    return CameraPath(poses);
+};
+
+CameraPath CameraPath::spin(double x, double y, double start_angle) {
+    return CameraPath(vector<CameraPose>{
+        CameraPose{x, y, start_angle},
+        CameraPose{x, y, start_angle + 2 * M_PI}
+    });
+};
+
+///
+/// Linearly interpolate the keyframes so that the full path
+/// is covered once over the given number of frames
+///
+/// @param int frame: Current frame index
+/// @param int frame_count: Total frames to cover the path in
+///
+/// @return CameraPose
+///
+CameraPose CameraPath::sample(int frame, int frame_count) const {
+    if (this->keyframes.size() == 1 || frame_count < 2) {
+        return this->keyframes.front();
+    }
+    double t = (double) frame / (frame_count - 1) * (this->keyframes.size() - 1);
+    size_t idx = min((size_t) t, this->keyframes.size() - 2);
+    double alpha = t - idx;
+    const CameraPose& a = this->keyframes[idx];
+    const CameraPose& b = this->keyframes[idx + 1];
+    return CameraPose{
+        a.x + (b.x - a.x) * alpha,
+        a.y + (b.y - a.y) * alpha,
+        a.angle + (b.angle - a.angle) * alpha
+    };
+};
+
+size_t CameraPath::size() const {
+    return this->keyframes.size();
+};
+}
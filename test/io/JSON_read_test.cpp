@@ -14,6 +14,7 @@
 #define NON_EXISTANT_JSON DIR_PREFIX + string("non_existant_test.json") 
 
 using namespace std;
+using namespace ResourceManager;
 
 RSJresource validJsonRes;
 RSJresource invalidJsonRes;
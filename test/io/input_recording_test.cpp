@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdio.h>
+
+#include <string>
+
+#include "../../src/io/resource_management/InputRecording.cpp"
+#include "../framework/catch.hpp"
+
+#define RECORDING_TEST_FILE string("input_recording_test.rec")
+#define RECORDING_TEST_INVALID string("test/resources/invalid_test.json")
+
+using namespace std;
+
+TEST_CASE("16.1: Input recordings read back as they were written", "[multi-file:16]") {
+    ResourceManager::InputRecording written("resources/maps/map2.json", 60, 1.0, 3.0, 1.5);
+    REQUIRE(written.open(RECORDING_TEST_FILE));
+    REQUIRE(written.isOpen());
+    // Deltas of one, two and three varint bytes, and two events on one step
+    REQUIRE(written.record(0, 'w', ResourceManager::KEY_DOWN));
+    REQUIRE(written.record(100, 'w', ResourceManager::KEY_UP));
+    REQUIRE(written.record(100, 'a', ResourceManager::KEY_DOWN));
+    REQUIRE(written.record(400, 'a', ResourceManager::KEY_UP));
+    REQUIRE(written.record(40000, 'd', ResourceManager::KEY_DOWN));
+
+    SECTION("16.1.1: Events, config and length match") {
+        written.close(40100);
+        REQUIRE_FALSE(written.isOpen());
+        ResourceManager::InputRecording read = ResourceManager::InputRecording::load(RECORDING_TEST_FILE);
+        REQUIRE(read.map_file == written.map_file);
+        REQUIRE(read.sim_rate == 60);
+        REQUIRE(read.fov == 1.0);
+        REQUIRE(read.move_speed == 3.0);
+        REQUIRE(read.rotation_speed == 1.5);
+        REQUIRE(read.length == 40100);
+        REQUIRE(read.events.size() == written.events.size());
+        for (size_t i = 0; i < read.events.size(); i++) {
+            REQUIRE(read.events[i].tick == written.events[i].tick);
+            REQUIRE(read.events[i].key == written.events[i].key);
+            REQUIRE(read.events[i].action == written.events[i].action);
+        }
+    }
+    SECTION("16.1.2: A recording that was never closed ends with its last event") {
+        ResourceManager::InputRecording read = ResourceManager::InputRecording::load(RECORDING_TEST_FILE);
+        REQUIRE(read.events.size() == 5);
+        REQUIRE(read.length == 40000);
+        written.close(40000);
+    }
+    remove(RECORDING_TEST_FILE.c_str());
+}
+
+TEST_CASE("16.2: Files that are not input recordings are rejected", "[multi-file:16]") {
+    REQUIRE_THROWS_AS(ResourceManager::InputRecording::load(RECORDING_TEST_INVALID), InputRecordingFormatError);
+}
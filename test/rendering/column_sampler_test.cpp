@@ -0,0 +1,75 @@
+#pragma once
+
+#include <vector>
+
+#include "../../src/rendering/texturing/ColumnSampler.hpp"
+#include "../framework/catch.hpp"
+
+using namespace std;
+
+#define SAMPLER_TEX_SHIFT 6
+#define SAMPLER_TEX_SIZE (1 << SAMPLER_TEX_SHIFT)
+
+///
+/// Sample every column height in [1, max_height] with the given sampler,
+/// both shades and starting part way into the texture
+///
+static vector<uint32_t> sampleAllHeights(Rendering::ColumnSampler sampler, const vector<uint32_t>& texels, int max_height) {
+    vector<uint32_t> out;
+    vector<uint32_t> column(max_height);
+    for (int height = 1; height <= max_height; height++) {
+        for (uint32_t side = 0; side < 2; side++) {
+            Rendering::ColumnSpan span;
+            span.texels = texels.data() + (height & (SAMPLER_TEX_SIZE - 1));
+            span.width_shift = SAMPLER_TEX_SHIFT;
+            span.row_shift = 32 - SAMPLER_TEX_SHIFT;
+            span.v_step = 0u - Rendering::toColumnV(double(SAMPLER_TEX_SIZE) / height, SAMPLER_TEX_SHIFT);
+            span.v = Rendering::toColumnV(0.37 * height, SAMPLER_TEX_SHIFT);
+            span.shade_shift = side;
+            span.shade_mask = side == 1 ? 0x7F7F7F : 0xFFFFFFFF;
+            sampler(span, column.data(), height);
+            out.insert(out.end(), column.begin(), column.begin() + height);
+        }
+    }
+    return out;
+}
+
+TEST_CASE("6.1: Column samplers match the scalar reference", "[multi-file:6]") {
+    vector<uint32_t> texels(SAMPLER_TEX_SIZE * SAMPLER_TEX_SIZE);
+    for (size_t i = 0; i < texels.size(); i++) {
+        texels[i] = 0xFF000000 | (uint32_t) (i * 2654435761u);
+    }
+    vector<uint32_t> reference = sampleAllHeights(Rendering::sampleColumnScalar, texels, 300);
+
+    SECTION("6.1.1: Selected sampler") {
+        REQUIRE(sampleAllHeights(Rendering::selectColumnSampler(), texels, 300) == reference);
+    }
+#ifdef COLUMN_SAMPLER_X86
+    SECTION("6.1.2: SSE2 sampler") {
+        REQUIRE(sampleAllHeights(Rendering::sampleColumnSSE2, texels, 300) == reference);
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        SECTION("6.1.3: AVX2 sampler") {
+            REQUIRE(sampleAllHeights(Rendering::sampleColumnAVX2, texels, 300) == reference);
+        }
+    }
+#endif
+}
+
+TEST_CASE("6.2: Column v wraps around the texture", "[multi-file:6]") {
+    vector<uint32_t> texels(SAMPLER_TEX_SIZE * SAMPLER_TEX_SIZE);
+    for (size_t i = 0; i < texels.size(); i++) {
+        texels[i] = (uint32_t) (i >> SAMPLER_TEX_SHIFT);
+    }
+    Rendering::ColumnSpan span;
+    span.texels = texels.data();
+    span.width_shift = SAMPLER_TEX_SHIFT;
+    span.row_shift = 32 - SAMPLER_TEX_SHIFT;
+    span.v = Rendering::toColumnV(SAMPLER_TEX_SIZE - 2, SAMPLER_TEX_SHIFT);
+    span.v_step = Rendering::toColumnV(1, SAMPLER_TEX_SHIFT);
+    span.shade_shift = 0;
+    span.shade_mask = 0xFFFFFFFF;
+    vector<uint32_t> column(4);
+    Rendering::sampleColumn(span, column.data(), 4);
+    REQUIRE(column == vector<uint32_t>{SAMPLER_TEX_SIZE - 2, SAMPLER_TEX_SIZE - 1, 0, 1});
+}
@@ -0,0 +1,313 @@
+#pragma once
+
+#include <math.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "../../src/rendering/raycaster/DDA.hpp"
+#include "../../src/rendering/raycaster/OccupancyGrid.cpp"
+#include "../../src/rendering/raycaster/RayPacket.hpp"
+#include "../framework/catch.hpp"
+
+using namespace std;
+
+#define DDA_TEST_MAP_SIZE 64
+#define DDA_TEST_RAYS 100000
+
+///
+/// Bordered grid with 10% of the inner cells solid
+///
+struct DDATestGrid {
+    vector<char> cells;
+
+    DDATestGrid(mt19937& gen) : cells(DDA_TEST_MAP_SIZE * DDA_TEST_MAP_SIZE) {
+        uniform_real_distribution<double> unit(0, 1);
+        for (int y = 0; y < DDA_TEST_MAP_SIZE; y++) {
+            for (int x = 0; x < DDA_TEST_MAP_SIZE; x++) {
+                bool border = x == 0 || y == 0 || x == DDA_TEST_MAP_SIZE - 1 || y == DDA_TEST_MAP_SIZE - 1;
+                this->cells[y * DDA_TEST_MAP_SIZE + x] = border || unit(gen) < 0.1;
+            }
+        }
+    }
+
+    inline bool operator()(int x, int y) const {
+        return this->cells[y * DDA_TEST_MAP_SIZE + x] != 0;
+    }
+};
+
+struct DDAAccuracy {
+    int mismatched_cells;
+    double p99_relative_error;
+    double max_relative_error;
+};
+
+///
+/// Cast the same random rays with doubles and fixed point F, counting rays that
+/// end in a different cell or side and the distance error of the rest
+///
+template <typename F>
+static DDAAccuracy measureDDA() {
+    mt19937 gen(1234);
+    uniform_real_distribution<double> unit(0, 1);
+    DDATestGrid grid(gen);
+    DDAAccuracy accuracy{0, 0, 0};
+    vector<double> errors;
+    for (int i = 0; i < DDA_TEST_RAYS; i++) {
+        double x, y;
+        do {
+            x = 1 + unit(gen) * (DDA_TEST_MAP_SIZE - 2);
+            y = 1 + unit(gen) * (DDA_TEST_MAP_SIZE - 2);
+        } while (grid((int) x, (int) y));
+        // Camera rays are the view direction plus up to the camera plane length
+        double angle = unit(gen) * 2 * M_PI;
+        double length = 1 + unit(gen) * 0.66;
+        double dir_x = cos(angle) * length;
+        double dir_y = sin(angle) * length;
+
+        Rendering::RayHit expected = Rendering::castRayDouble(x, y, dir_x, dir_y, grid);
+        Rendering::RayHit actual = Rendering::castRayFixed<F>(x, y, dir_x, dir_y, grid);
+        if (expected.map_x != actual.map_x || expected.map_y != actual.map_y || expected.side != actual.side) {
+            accuracy.mismatched_cells++;
+            continue;
+        }
+        errors.push_back(fabs(actual.perp_wall_dist - expected.perp_wall_dist) / expected.perp_wall_dist);
+    }
+    sort(errors.begin(), errors.end());
+    accuracy.p99_relative_error = errors[errors.size() * 99 / 100];
+    accuracy.max_relative_error = errors.back();
+    return accuracy;
+}
+
+TEST_CASE("7.1: Fixed point reciprocal", "[multi-file:7]") {
+    const double values[] = {0.001, 0.3, 1.0, 1.7, 100.0};
+    for (double value : values) {
+        SECTION("7.1.1: 16.16 reciprocal of " + to_string(value)) {
+            double result = Rendering::Fixed16::toDouble(Rendering::Fixed16::recip(Rendering::Fixed16::fromDouble(value)));
+            REQUIRE(fabs(result - 1 / value) <= 1 / value * 1e-2 + 1e-4);
+        }
+        SECTION("7.1.2: 32.32 reciprocal of " + to_string(value)) {
+            double result = Rendering::Fixed32::toDouble(Rendering::Fixed32::recip(Rendering::Fixed32::fromDouble(value)));
+            REQUIRE(fabs(result - 1 / value) <= 1 / value * 1e-6);
+        }
+    }
+}
+
+TEST_CASE("7.2: Fixed point DDA matches the double DDA", "[multi-file:7]") {
+    SECTION("7.2.1: 32.32 hits the same cells") {
+        DDAAccuracy accuracy = measureDDA<Rendering::Fixed32>();
+        REQUIRE(accuracy.mismatched_cells == 0);
+        REQUIRE(accuracy.max_relative_error < 1e-4);
+    }
+    SECTION("7.2.2: 16.16 hits the same cells for all but near axis rays") {
+        DDAAccuracy accuracy = measureDDA<Rendering::Fixed16>();
+        REQUIRE(accuracy.mismatched_cells < DDA_TEST_RAYS / 1000);
+        REQUIRE(accuracy.p99_relative_error < 1e-3);
+    }
+}
+
+TEST_CASE("7.3: Rays give up past the maximum distance", "[multi-file:7]") {
+    // Open 64x64 room, walls only on the border
+    vector<char> cells(DDA_TEST_MAP_SIZE * DDA_TEST_MAP_SIZE, 0);
+    for (int i = 0; i < DDA_TEST_MAP_SIZE; i++) {
+        cells[i] = cells[(DDA_TEST_MAP_SIZE - 1) * DDA_TEST_MAP_SIZE + i] = 1;
+        cells[i * DDA_TEST_MAP_SIZE] = cells[i * DDA_TEST_MAP_SIZE + DDA_TEST_MAP_SIZE - 1] = 1;
+    }
+    auto is_wall = [&](int x, int y) {
+        return cells[y * DDA_TEST_MAP_SIZE + x] != 0;
+    };
+
+    SECTION("7.3.1: Wall beyond the limit is a miss") {
+        Rendering::RayHit hit = Rendering::castRayDouble(32.5, 32.5, 1.0, 0.1, is_wall, 10.0);
+        REQUIRE_FALSE(hit.in_range);
+        REQUIRE(hit.perp_wall_dist == 10.0);
+        REQUIRE_FALSE(Rendering::castRayFixed<Rendering::Fixed16>(32.5, 32.5, 1.0, 0.1, is_wall, 10.0).in_range);
+        REQUIRE_FALSE(Rendering::castRayFixed<Rendering::Fixed32>(32.5, 32.5, 1.0, 0.1, is_wall, 10.0).in_range);
+    }
+    SECTION("7.3.2: Wall within the limit is a hit") {
+        Rendering::RayHit hit = Rendering::castRayDouble(32.5, 32.5, 1.0, 0.1, is_wall, 40.0);
+        REQUIRE(hit.in_range);
+        REQUIRE(hit.map_x == DDA_TEST_MAP_SIZE - 1);
+        REQUIRE(Rendering::castRayFixed<Rendering::Fixed16>(32.5, 32.5, 1.0, 0.1, is_wall, 40.0).in_range);
+        REQUIRE(Rendering::castRayFixed<Rendering::Fixed32>(32.5, 32.5, 1.0, 0.1, is_wall, 40.0).in_range);
+    }
+}
+
+TEST_CASE("7.4: Occupancy pyramid traversal matches the cell DDA", "[multi-file:7]") {
+    mt19937 gen(99);
+    uniform_real_distribution<double> unit(0, 1);
+    // Sparse enough that rays cross whole empty blocks
+    vector<char> cells(DDA_TEST_MAP_SIZE * DDA_TEST_MAP_SIZE);
+    for (int y = 0; y < DDA_TEST_MAP_SIZE; y++) {
+        for (int x = 0; x < DDA_TEST_MAP_SIZE; x++) {
+            bool border = x == 0 || y == 0 || x == DDA_TEST_MAP_SIZE - 1 || y == DDA_TEST_MAP_SIZE - 1;
+            cells[y * DDA_TEST_MAP_SIZE + x] = border || unit(gen) < 0.01;
+        }
+    }
+    auto is_wall = [&](int x, int y) {
+        return cells[y * DDA_TEST_MAP_SIZE + x] != 0;
+    };
+    Rendering::OccupancyGrid grid;
+    grid.rebuild(DDA_TEST_MAP_SIZE, DDA_TEST_MAP_SIZE, is_wall);
+
+    int mismatched = 0;
+    long cell_steps = 0, pyramid_steps = 0;
+    for (int i = 0; i < DDA_TEST_RAYS; i++) {
+        double x, y;
+        do {
+            x = 1 + unit(gen) * (DDA_TEST_MAP_SIZE - 2);
+            y = 1 + unit(gen) * (DDA_TEST_MAP_SIZE - 2);
+        } while (is_wall((int) x, (int) y));
+        double angle = unit(gen) * 2 * M_PI;
+        double dir_x = cos(angle);
+        double dir_y = sin(angle);
+        Rendering::RayHit expected = Rendering::castRayDouble(x, y, dir_x, dir_y, is_wall, 10);
+        Rendering::RayHit actual = Rendering::castRayHierarchical(x, y, dir_x, dir_y, grid, 10);
+        cell_steps += expected.steps;
+        pyramid_steps += actual.steps;
+        if (expected.in_range != actual.in_range || fabs(expected.perp_wall_dist - actual.perp_wall_dist) > 1e-9) {
+            mismatched++;
+            continue;
+        }
+        if (expected.in_range && (expected.map_x != actual.map_x || expected.map_y != actual.map_y || expected.side != actual.side)) {
+            mismatched++;
+        }
+    }
+
+    SECTION("7.4.1: Same cells and distances") {
+        REQUIRE(mismatched == 0);
+    }
+    SECTION("7.4.2: Fewer steps") {
+        REQUIRE(pyramid_steps * 2 < cell_steps);
+    }
+    SECTION("7.4.3: Misses past the maximum distance") {
+        REQUIRE_FALSE(Rendering::castRayHierarchical(32.5, 32.5, 1.0, 0.1, grid, 0.25).in_range);
+    }
+    SECTION("7.4.4: The starting cell is never hit, even inside a wall") {
+        Rendering::RayHit expected = Rendering::castRayDouble(0.5, 32.5, 1.0, 0.3, is_wall);
+        Rendering::RayHit actual = Rendering::castRayHierarchical(0.5, 32.5, 1.0, 0.3, grid);
+        REQUIRE(actual.map_x == expected.map_x);
+        REQUIRE(actual.map_y == expected.map_y);
+        REQUIRE(actual.perp_wall_dist > 0);
+    }
+}
+
+///
+/// Trace fans of camera rays from random open cells in packets and count the
+/// columns whose hit differs from castRayDouble in any way. The packets look up
+/// cells in the grid, or in an occupancy grid built from it
+///
+static int countPacketMismatches(Rendering::RayPacketLevel level, double max_dist, bool through_occupancy) {
+    mt19937 gen(4321);
+    uniform_real_distribution<double> unit(0, 1);
+    DDATestGrid grid(gen);
+    Rendering::OccupancyGrid occupancy;
+    occupancy.rebuild(DDA_TEST_MAP_SIZE, DDA_TEST_MAP_SIZE, grid);
+    const int columns = 67;
+    vector<Rendering::CameraRay> rays(columns);
+    Rendering::RayHitBuffer hits;
+    hits.resize(columns);
+    int mismatched = 0;
+    for (int view = 0; view < 500; view++) {
+        double x, y;
+        do {
+            x = 1 + unit(gen) * (DDA_TEST_MAP_SIZE - 2);
+            y = 1 + unit(gen) * (DDA_TEST_MAP_SIZE - 2);
+        } while (grid((int) x, (int) y));
+        // Every fourth view looks straight along an axis, so the centre column has a zero direction component
+        double angle = unit(gen) * 2 * M_PI;
+        double view_x = cos(angle);
+        double view_y = sin(angle);
+        if (view % 4 == 0) {
+            const int axis[4][2] = {{1, 0}, {0, 1}, {-1, 0}, {0, -1}};
+            view_x = axis[view / 4 % 4][0];
+            view_y = axis[view / 4 % 4][1];
+        }
+        for (int column = 0; column < columns; column++) {
+            double camera_x = 2 * column / double(columns - 1) - 1;
+            rays[column] = Rendering::CameraRay{x, y, view_x - view_y * 0.66 * camera_x, view_y + view_x * 0.66 * camera_x};
+        }
+        if (through_occupancy) {
+            Rendering::castRays(rays, 0, columns, occupancy, hits, max_dist, level);
+        } else {
+            Rendering::castRays(rays, 0, columns, grid, hits, max_dist, level);
+        }
+        for (int column = 0; column < columns; column++) {
+            const Rendering::CameraRay& ray = rays[column];
+            Rendering::RayHit expected = Rendering::castRayDouble(ray.origin_x, ray.origin_y, ray.dir_x, ray.dir_y, grid, max_dist);
+            Rendering::RayHit actual = hits.get(column);
+            if (expected.in_range != actual.in_range || expected.perp_wall_dist != actual.perp_wall_dist
+                || expected.map_x != actual.map_x || expected.map_y != actual.map_y || expected.side != actual.side) {
+                mismatched++;
+            }
+        }
+    }
+    return mismatched;
+}
+
+TEST_CASE("7.5: Ray packets match the scalar DDA", "[multi-file:7]") {
+    const Rendering::RayPacketLevel levels[] = {
+        Rendering::RayPacketLevel::RAY_PACKET_NONE,
+        Rendering::RayPacketLevel::RAY_PACKET_SSE2,
+        Rendering::RayPacketLevel::RAY_PACKET_AVX2
+    };
+    for (Rendering::RayPacketLevel level : levels) {
+        if (!Rendering::rayPacketLevelSupported(level)) {
+            continue;
+        }
+        SECTION("7.5.1: Unbounded rays, packet level " + to_string(level)) {
+            REQUIRE(countPacketMismatches(level, numeric_limits<double>::infinity(), false) == 0);
+        }
+        SECTION("7.5.2: Rays capped at 6 cells, packet level " + to_string(level)) {
+            REQUIRE(countPacketMismatches(level, 6.0, false) == 0);
+        }
+        SECTION("7.5.3: Cells looked up in an occupancy grid, packet level " + to_string(level)) {
+            REQUIRE(countPacketMismatches(level, numeric_limits<double>::infinity(), true) == 0);
+            REQUIRE(countPacketMismatches(level, 6.0, true) == 0);
+        }
+    }
+}
+
+TEST_CASE("7.6: Cells outside an occupancy grid are walls", "[multi-file:7]") {
+    // No walls at all, every ray leaves through an open edge
+    Rendering::OccupancyGrid occupancy;
+    occupancy.rebuild(8, 8, [](int, int) { return false; });
+    REQUIRE_FALSE(occupancy(0, 0));
+    REQUIRE_FALSE(occupancy(7, 7));
+    REQUIRE(occupancy(-1, 3));
+    REQUIRE(occupancy(8, 3));
+    REQUIRE(occupancy(3, -1));
+    REQUIRE(occupancy(3, 8));
+
+    const int columns = 16;
+    vector<Rendering::CameraRay> rays(columns);
+    for (int column = 0; column < columns; column++) {
+        double angle = 2 * M_PI * column / columns;
+        rays[column] = Rendering::CameraRay{4.5, 4.5, cos(angle), sin(angle)};
+    }
+    const Rendering::RayPacketLevel levels[] = {
+        Rendering::RayPacketLevel::RAY_PACKET_NONE,
+        Rendering::RayPacketLevel::RAY_PACKET_SSE2,
+        Rendering::RayPacketLevel::RAY_PACKET_AVX2
+    };
+    for (Rendering::RayPacketLevel level : levels) {
+        if (!Rendering::rayPacketLevelSupported(level)) {
+            continue;
+        }
+        Rendering::RayHitBuffer hits;
+        hits.resize(columns);
+        Rendering::castRays(rays, 0, columns, occupancy, hits, numeric_limits<double>::infinity(), level);
+        for (int column = 0; column < columns; column++) {
+            const Rendering::CameraRay& ray = rays[column];
+            Rendering::RayHit expected = Rendering::castRayDouble(ray.origin_x, ray.origin_y, ray.dir_x, ray.dir_y, occupancy,
+                numeric_limits<double>::infinity());
+            Rendering::RayHit actual = hits.get(column);
+            REQUIRE(actual.in_range);
+            REQUIRE((actual.map_x == -1 || actual.map_x == 8 || actual.map_y == -1 || actual.map_y == 8));
+            REQUIRE(actual.map_x == expected.map_x);
+            REQUIRE(actual.map_y == expected.map_y);
+            REQUIRE(actual.perp_wall_dist == expected.perp_wall_dist);
+        }
+    }
+}
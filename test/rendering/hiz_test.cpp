@@ -0,0 +1,114 @@
+#pragma once
+
+#include <math.h>
+
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "../../src/rendering/raycaster/HiZBuffer.cpp"
+#include "../framework/catch.hpp"
+
+using namespace std;
+
+#define HIZ_TEST_WIDTHS 5
+#define HIZ_TEST_QUERIES 20000
+
+///
+/// Wall distances across a screen in runs, as walls of one face give, with
+/// gaps of open sky where no wall is in range
+///
+static Rendering::ZBuffer hiZTestDepth(mt19937& gen, int width) {
+    uniform_real_distribution<double> unit(0, 1);
+    Rendering::ZBuffer depth(width);
+    double distance = 1;
+    double slope = 0;
+    for (int x = 0; x < width; x++) {
+        if (unit(gen) < 0.03) {
+            distance = unit(gen) < 0.1 ? numeric_limits<double>::infinity() : 0.5 + unit(gen) * 20;
+            slope = (unit(gen) - 0.5) * 0.05;
+        }
+        depth[x] = isinf(distance) ? distance : max(distance + slope * x / 10, 0.2);
+    }
+    return depth;
+}
+
+TEST_CASE("10.1: Hi-Z queries never report a visible column as occluded", "[multi-file:10]") {
+    const int widths[HIZ_TEST_WIDTHS] = {1, 15, 320, 641, 1920};
+    mt19937 gen(5);
+    uniform_real_distribution<double> unit(0, 1);
+    int wrong_occluded = 0;
+    int wrong_unoccluded = 0;
+    int wrong_spans = 0;
+    int occluded = 0;
+    for (int width : widths) {
+        Rendering::ZBuffer depth = hiZTestDepth(gen, width);
+        Rendering::HiZBuffer hiZ;
+        hiZ.build(depth);
+        for (int q = 0; q < HIZ_TEST_QUERIES; q++) {
+            int x_start = (int) (unit(gen) * width);
+            int x_end = min(x_start + 1 + (int) (unit(gen) * unit(gen) * width), width);
+            double d = 0.2 + unit(gen) * 22;
+            double nearest = numeric_limits<double>::infinity();
+            double furthest = -numeric_limits<double>::infinity();
+            for (int x = x_start; x < x_end; x++) {
+                nearest = min(nearest, depth[x]);
+                furthest = max(furthest, depth[x]);
+            }
+            wrong_occluded += hiZ.occluded(x_start, x_end, d) && d < furthest;
+            wrong_unoccluded += hiZ.unoccluded(x_start, x_end, d) && d >= nearest;
+            occluded += hiZ.occluded(x_start, x_end, d);
+
+            int span_start = x_start;
+            int span_end = x_end;
+            bool any = hiZ.visibleSpan(span_start, span_end, d);
+            // Columns trimmed off must be hidden, and an empty span means all of them were
+            for (int x = x_start; x < x_end; x++) {
+                bool trimmed = !any || x < span_start || x >= span_end;
+                wrong_spans += trimmed && d < depth[x];
+            }
+        }
+    }
+    REQUIRE(wrong_occluded == 0);
+    REQUIRE(wrong_unoccluded == 0);
+    REQUIRE(wrong_spans == 0);
+    REQUIRE(occluded > 0);
+}
+
+TEST_CASE("10.2: Hi-Z queries are exact on whole tiles and single columns", "[multi-file:10]") {
+    mt19937 gen(11);
+    int width = 1000;
+    Rendering::ZBuffer depth = hiZTestDepth(gen, width);
+    Rendering::HiZBuffer hiZ;
+    hiZ.build(depth);
+    int tile = 1 << HIZ_TILE_SHIFT;
+    REQUIRE(hiZ.levels() == 7);
+
+    SECTION("10.2.1: Single tiles and sibling pairs of tiles") {
+        int wrong = 0;
+        for (int span = 1; span <= 2; span++) {
+            // A pair of tiles is read from their parent, which covers just those two when it starts on an even tile
+            for (int x_start = 0; x_start < width; x_start += span * tile) {
+                int x_end = min(x_start + span * tile, width);
+                double nearest = numeric_limits<double>::infinity();
+                double furthest = -numeric_limits<double>::infinity();
+                for (int x = x_start; x < x_end; x++) {
+                    nearest = min(nearest, depth[x]);
+                    furthest = max(furthest, depth[x]);
+                }
+                wrong += hiZ.nearest(x_start, x_end) != nearest || hiZ.furthest(x_start, x_end) != furthest;
+            }
+        }
+        REQUIRE(wrong == 0);
+    }
+    SECTION("10.2.2: Camera space points") {
+        int wrong = 0;
+        for (int x = 0; x < width; x++) {
+            double transform_x = (x + 0.5) * 2.0 / width - 1;
+            wrong += hiZ.visible(transform_x * 3, 3.0) != (3.0 < depth[x]);
+        }
+        REQUIRE(wrong == 0);
+        REQUIRE_FALSE(hiZ.visible(0.0, -1.0));
+        REQUIRE_FALSE(hiZ.visible(2.0, 1.0));
+    }
+}
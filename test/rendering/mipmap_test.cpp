@@ -0,0 +1,93 @@
+#pragma once
+
+#include <map>
+#include <string>
+
+#include "../../src/rendering/texturing/TextureAtlas.cpp"
+#include "../framework/catch.hpp"
+
+using namespace std;
+
+///
+/// Texture of 2x2 blocks alternating between two colours, so every texel of
+/// level 1 averages two of each
+///
+static Texture mipTestTexture(const string& name, unsigned long width, unsigned long height) {
+    Texture tex;
+    tex.name = name;
+    tex.width = width;
+    tex.height = height;
+    tex.texture.resize(width * height);
+    for (unsigned long y = 0; y < height; y++) {
+        for (unsigned long x = 0; x < width; x++) {
+            tex.texture[y * width + x] = (x + y) & 1 ? 0xFF204060 : 0xFF60A0E0;
+        }
+    }
+    return tex;
+}
+
+TEST_CASE("12.1: Texture atlas builds a box filtered mip chain", "[multi-file:12]") {
+    map<string, Texture> textures;
+    textures["square"] = mipTestTexture("square", 64, 64);
+    textures["wide"] = mipTestTexture("wide", 64, 16);
+    Rendering::TextureAtlas atlas;
+    atlas.build(textures, 8, 8);
+    Rendering::TexHandle square = atlas.handle("square");
+    Rendering::TexHandle wide = atlas.handle("wide");
+
+    SECTION("12.1.1: Levels halve down to 1x1") {
+        REQUIRE(atlas.entry(square).levels == 7);
+        REQUIRE(atlas.entry(wide).levels == 7);
+        const Rendering::AtlasEntry& wide_4 = atlas.level(wide, 4);
+        REQUIRE(wide_4.width == 4);
+        REQUIRE(wide_4.height == 1);
+        REQUIRE(wide_4.height_mask == 0);
+        REQUIRE(atlas.level(wide, 6).width == 1);
+        // Past the end clamps to the smallest level
+        REQUIRE(&atlas.level(square, 20) == &atlas.level(square, 6));
+        REQUIRE(&atlas.level(square, 0) == &atlas.entry(square));
+    }
+    SECTION("12.1.2: Every texel below level 0 is the rounded average of the four above it") {
+        int wrong = 0;
+        for (uint32_t l = 1; l < atlas.entry(square).levels; l++) {
+            const Rendering::AtlasEntry& mip = atlas.level(square, l);
+            const uint32_t* texels = atlas.texels(mip);
+            for (uint32_t i = 0; i < mip.width * mip.height; i++) {
+                wrong += texels[i] != 0xFF4070A0;
+            }
+        }
+        REQUIRE(wrong == 0);
+    }
+    SECTION("12.1.3: Levels don't overlap each other or the next texture") {
+        for (Rendering::TexHandle handle : {square, wide}) {
+            const Rendering::AtlasEntry& full = atlas.entry(handle);
+            uint32_t end = full.offset + full.width * full.height;
+            for (uint32_t l = 1; l < full.levels; l++) {
+                const Rendering::AtlasEntry& mip = atlas.level(handle, l);
+                REQUIRE(mip.offset >= end);
+                end = mip.offset + mip.width * mip.height;
+            }
+        }
+        // Packed in name order, the whole chain of one texture comes before the next
+        REQUIRE(atlas.level(square, 6).offset < atlas.entry(wide).offset);
+    }
+    SECTION("12.1.4: Level selection keeps at least a texel per pixel") {
+        const Rendering::AtlasEntry& full = atlas.entry(square);
+        REQUIRE(Rendering::TextureAtlas::mipLevel(full, 0.25) == 0);
+        REQUIRE(Rendering::TextureAtlas::mipLevel(full, 1.99) == 0);
+        REQUIRE(Rendering::TextureAtlas::mipLevel(full, 2.0) == 1);
+        REQUIRE(Rendering::TextureAtlas::mipLevel(full, 7.9) == 2);
+        REQUIRE(Rendering::TextureAtlas::mipLevel(full, 1e9) == 6);
+    }
+}
+
+TEST_CASE("12.2: Texture atlas without mipmaps only has level 0", "[multi-file:12]") {
+    map<string, Texture> textures;
+    textures["square"] = mipTestTexture("square", 64, 64);
+    Rendering::TextureAtlas atlas;
+    atlas.build(textures, 8, 8, false);
+    const Rendering::AtlasEntry& full = atlas.entry(atlas.handle("square"));
+    REQUIRE(full.levels == 1);
+    REQUIRE(&atlas.level(atlas.handle("square"), 3) == &full);
+    REQUIRE(Rendering::TextureAtlas::mipLevel(full, 100.0) == 0);
+}
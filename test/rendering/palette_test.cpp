@@ -0,0 +1,141 @@
+#pragma once
+
+#include <vector>
+
+#include "../../src/rendering/buffering/PBO.cpp"
+#include "../../src/rendering/colour/FogTable.cpp"
+#include "../../src/rendering/colour/Palette.cpp"
+#include "../framework/catch.hpp"
+
+using namespace std;
+
+///
+/// Colours both the median cut and the exact path can keep, with their dark
+/// shades, and a near black that must not become transparent
+///
+static vector<uint32_t> paletteTestTexels() {
+    vector<uint32_t> texels;
+    for (uint32_t i = 0; i < 64; i++) {
+        texels.push_back(0xFF000000 | (i * 4) << 16 | (255 - i * 4) << 8 | (i * 2));
+    }
+    texels.push_back(0xFF000000);
+    texels.push_back(0xFF020202);
+    return texels;
+}
+
+TEST_CASE("13.1: Palette quantizes texels to the nearest of 256 colours", "[multi-file:13]") {
+    SECTION("13.1.1: Colours that fit are kept exactly, shades included") {
+        vector<uint32_t> texels = paletteTestTexels();
+        Rendering::Palette palette;
+        palette.build(texels.data(), texels.size(), 0xFF000000);
+        REQUIRE(palette.size() <= PALETTE_SIZE);
+        int inexact = 0;
+        for (uint32_t texel : texels) {
+            inexact += palette.colours()[palette.quantize(texel)] != (0xFF000000 | texel);
+            inexact += palette.colours()[palette.quantize((texel >> 1) & 0x7F7F7F)] != (0xFF000000 | ((texel >> 1) & 0x7F7F7F));
+        }
+        REQUIRE(inexact == 0);
+    }
+    SECTION("13.1.2: Only black is transparent") {
+        vector<uint32_t> texels = paletteTestTexels();
+        Rendering::Palette palette;
+        palette.build(texels.data(), texels.size(), 0xFF000000);
+        REQUIRE(palette.quantize(0xFF000000) == PALETTE_TRANSPARENT);
+        REQUIRE(palette.quantize(0xFF000100) != PALETTE_TRANSPARENT);
+        REQUIRE(palette.quantize(0xFF000100, true) == PALETTE_TRANSPARENT);
+    }
+    SECTION("13.1.3: Median cut keeps more colours than fit close") {
+        vector<uint32_t> texels;
+        for (uint32_t i = 0; i < 4096; i++) {
+            texels.push_back(0xFF000000 | (i & 63) * 4 << 16 | (i >> 6) * 4 << 8 | (uint32_t) (i * 2654435761u) >> 28);
+        }
+        Rendering::Palette palette;
+        palette.build(texels.data(), texels.size(), 0xFF000000);
+        REQUIRE(palette.size() == PALETTE_SIZE);
+        vector<uint8_t> indices(texels.size());
+        palette.quantize(texels.data(), texels.size(), indices.data());
+        int worst = 0;
+        for (size_t i = 0; i < texels.size(); i++) {
+            uint32_t colour = palette.colours()[indices[i]];
+            for (int shift = 0; shift < 24; shift += 8) {
+                worst = max(worst, abs((int) ((colour >> shift) & 0xFF) - (int) ((texels[i] >> shift) & 0xFF)));
+            }
+        }
+        REQUIRE(worst <= 32);
+    }
+}
+
+TEST_CASE("13.2: Palette colormaps shade and fog indices", "[multi-file:13]") {
+    vector<uint32_t> texels = paletteTestTexels();
+    Rendering::FogTable fog(2, 10, 0xFF4080C0);
+    Rendering::Palette palette;
+    palette.build(texels.data(), texels.size(), fog.colour);
+    palette.buildColormaps(fog);
+
+    SECTION("13.2.1: The fog colour has an entry of its own") {
+        REQUIRE(palette.colours()[palette.fogIndex()] == fog.colour);
+    }
+    SECTION("13.2.2: No shade and no fog leaves every index as it is") {
+        const uint8_t* colormap = palette.colormap(0, 0);
+        int changed = 0;
+        for (int i = 0; i < palette.size(); i++) {
+            changed += colormap[i] != i;
+        }
+        REQUIRE(changed == 0);
+    }
+    SECTION("13.2.3: The dark shade halves every channel") {
+        const uint8_t* colormap = palette.colormap(PALETTE_SHADE_DARK, 0);
+        for (uint32_t texel : texels) {
+            REQUIRE(palette.colours()[colormap[palette.quantize(texel)]] == (0xFF000000 | ((texel >> 1) & 0x7F7F7F)));
+        }
+    }
+    SECTION("13.2.4: Solid fog maps everything to the fog colour") {
+        for (uint32_t shade = 0; shade < PALETTE_SHADES; shade++) {
+            const uint8_t* colormap = palette.colormap(shade, fog.weight(100));
+            for (int i = 0; i < PALETTE_SIZE; i++) {
+                REQUIRE(colormap[i] == palette.fogIndex());
+            }
+        }
+    }
+}
+
+TEST_CASE("13.3: Indexed frames expand to the same colours in either layout", "[multi-file:13]") {
+    vector<uint32_t> texels = paletteTestTexels();
+    Rendering::Palette palette;
+    palette.build(texels.data(), texels.size(), 0xFF000000);
+
+    vector<uint8_t> indices(37);
+    vector<uint32_t> expected(indices.size()), expanded(indices.size());
+    for (size_t i = 0; i < indices.size(); i++) {
+        indices[i] = (uint8_t) (i * 7 % palette.size());
+        expected[i] = palette.colours()[indices[i]];
+    }
+    Rendering::expandPalette(indices.data(), expanded.data(), indices.size(), palette.colours());
+    REQUIRE(expanded == expected);
+
+    const int width = 13, height = 7;
+    Rendering::PBO row_major(width, height, false);
+    Rendering::PBO column_major(width, height, true);
+    row_major.setPalette(palette.colours());
+    column_major.setPalette(palette.colours());
+    REQUIRE(row_major.isIndexed());
+    vector<uint8_t> column(height);
+    for (int x = 0; x < width; x++) {
+        for (int y = 0; y < height; y++) {
+            column[y] = (uint8_t) ((x * height + y) % palette.size());
+            row_major.writeIndexed(x, y, column[y]);
+        }
+        column_major.writeIndexedColumn(x, 0, height, column.data());
+    }
+    row_major.resolve();
+    column_major.resolve();
+    int wrong = 0;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            uint32_t colour = palette.colours()[(x * height + y) % palette.size()];
+            wrong += row_major.data()[y * width + x] != colour;
+            wrong += column_major.data()[y * width + x] != colour;
+        }
+    }
+    REQUIRE(wrong == 0);
+}
@@ -0,0 +1,269 @@
+#pragma once
+
+#include <math.h>
+#include <stdio.h>
+
+#include <random>
+#include <vector>
+
+#include "../../src/environment/world/World.cpp"
+#include "../../src/rendering/partitioning/QSPTree.cpp"
+#include "../../src/rendering/raycaster/DDA.hpp"
+#include "../framework/catch.hpp"
+
+using namespace std;
+
+#define QSP_TEST_MAP_SIZE 32
+#define QSP_TEST_VIEWS 200
+#define QSP_TEST_COLUMNS 64
+
+///
+/// Tree building logs, give it a context that drops the info messages
+///
+static void quietQSPLogging() {
+    loggingCfg.hide_infos = true;
+    debugContext = GLDebugContext(&loggingCfg);
+}
+
+///
+/// Bordered map with the given fraction of inner cells solid
+///
+static World qspTestWorld(mt19937& gen, double density) {
+    uniform_real_distribution<double> unit(0, 1);
+    vector<Constructs::AABB> walls;
+    for (int y = 0; y < QSP_TEST_MAP_SIZE; y++) {
+        for (int x = 0; x < QSP_TEST_MAP_SIZE; x++) {
+            bool border = x == 0 || y == 0 || x == QSP_TEST_MAP_SIZE - 1 || y == QSP_TEST_MAP_SIZE - 1;
+            walls.push_back(Constructs::AABB(x, y, TEX_HANDLE_MISSING,
+                border || unit(gen) < density ? Constructs::WallType::WALL : Constructs::WallType::NONE));
+        }
+    }
+    return World(walls, QSP_TEST_MAP_SIZE, QSP_TEST_MAP_SIZE);
+}
+
+///
+/// Query fans of camera rays from random open cells through the tree and count
+/// the rays whose hit differs from the DDA's
+///
+static int countQSPMismatches(double density, double max_dist) {
+    mt19937 gen(2024);
+    uniform_real_distribution<double> unit(0, 1);
+    World world = qspTestWorld(gen, density);
+    QSPTree tree(world);
+    tree.buildTree();
+    auto is_wall = [&](int x, int y) {
+        return world.getAt(x, y).type != Constructs::WallType::NONE;
+    };
+
+    int mismatched = 0;
+    Rendering::RayBuffer rays(QSP_TEST_COLUMNS);
+    vector<Rendering::RayHit> hits(QSP_TEST_COLUMNS);
+    for (int view = 0; view < QSP_TEST_VIEWS; view++) {
+        double x, y;
+        do {
+            x = 1 + unit(gen) * (QSP_TEST_MAP_SIZE - 2);
+            y = 1 + unit(gen) * (QSP_TEST_MAP_SIZE - 2);
+        } while (is_wall((int) x, (int) y));
+        double angle = unit(gen) * 2 * M_PI;
+        for (int column = 0; column < QSP_TEST_COLUMNS; column++) {
+            double camera_x = 2 * column / double(QSP_TEST_COLUMNS) - 1;
+            rays[column] = Rendering::CameraRay{
+                x, y,
+                cos(angle) - sin(angle) * 0.66 * camera_x,
+                sin(angle) + cos(angle) * 0.66 * camera_x
+            };
+        }
+        tree.queryWalls(rays, 0, QSP_TEST_COLUMNS, hits, max_dist);
+        for (int column = 0; column < QSP_TEST_COLUMNS; column++) {
+            const Rendering::CameraRay& ray = rays[column];
+            Rendering::RayHit expected = Rendering::castRayDouble(ray.origin_x, ray.origin_y, ray.dir_x, ray.dir_y, is_wall, max_dist);
+            const Rendering::RayHit& actual = hits[column];
+            if (expected.in_range != actual.in_range || expected.perp_wall_dist != actual.perp_wall_dist
+                || (expected.in_range && (expected.map_x != actual.map_x || expected.map_y != actual.map_y || expected.side != actual.side))) {
+                mismatched++;
+            }
+        }
+    }
+    return mismatched;
+}
+
+TEST_CASE("8.1: QSP wall queries match the DDA", "[multi-file:8]") {
+    quietQSPLogging();
+    SECTION("8.1.1: Sparse map") {
+        REQUIRE(countQSPMismatches(0.02, numeric_limits<double>::infinity()) == 0);
+    }
+    SECTION("8.1.2: Dense map") {
+        REQUIRE(countQSPMismatches(0.3, numeric_limits<double>::infinity()) == 0);
+    }
+    SECTION("8.1.3: Bounded by a maximum distance") {
+        REQUIRE(countQSPMismatches(0.02, 6.0) == 0);
+    }
+}
+
+TEST_CASE("8.2: QSP tree over a map of only boundary walls", "[multi-file:8]") {
+    quietQSPLogging();
+    vector<Constructs::AABB> walls;
+    for (int y = 0; y < 8; y++) {
+        for (int x = 0; x < 8; x++) {
+            bool border = x == 0 || y == 0 || x == 7 || y == 7;
+            walls.push_back(Constructs::AABB(x, y, TEX_HANDLE_MISSING, border ? Constructs::WallType::WALL : Constructs::WallType::NONE));
+        }
+    }
+    World world(walls, 8, 8);
+    QSPTree tree(world);
+    tree.buildTree();
+    Rendering::RayBuffer rays{Rendering::CameraRay{4.5, 4.5, 1.0, 0.0}};
+    vector<Rendering::RayHit> hits(1);
+    tree.queryWalls(rays, 0, 1, hits);
+    REQUIRE(hits[0].in_range);
+    REQUIRE(hits[0].map_x == 7);
+    REQUIRE(hits[0].map_y == 4);
+    REQUIRE(hits[0].perp_wall_dist == 2.5);
+}
+
+TEST_CASE("8.3: Saved QSP trees load back only for their own map", "[multi-file:8]") {
+    quietQSPLogging();
+    const string filename = "qsp_test_tree" QSP_FILE_EXTENSION;
+    mt19937 gen(7);
+    World world = qspTestWorld(gen, 0.1);
+    QSPTree built(world);
+    built.buildTree();
+    REQUIRE(built.size() > 0);
+    REQUIRE(built.save(filename));
+
+    SECTION("8.3.1: Loaded tree answers queries as the built one does") {
+        QSPTree loaded;
+        REQUIRE(loaded.load(filename, world));
+        REQUIRE(loaded.size() == built.size());
+        Rendering::RayBuffer rays;
+        for (int column = 0; column < QSP_TEST_COLUMNS; column++) {
+            double angle = 2 * M_PI * column / QSP_TEST_COLUMNS;
+            rays.push_back(Rendering::CameraRay{QSP_TEST_MAP_SIZE / 2 + 0.5, QSP_TEST_MAP_SIZE / 2 + 0.5, cos(angle), sin(angle)});
+        }
+        vector<Rendering::RayHit> expected(QSP_TEST_COLUMNS), actual(QSP_TEST_COLUMNS);
+        built.queryWalls(rays, 0, QSP_TEST_COLUMNS, expected);
+        loaded.queryWalls(rays, 0, QSP_TEST_COLUMNS, actual);
+        for (int column = 0; column < QSP_TEST_COLUMNS; column++) {
+            REQUIRE(actual[column].in_range == expected[column].in_range);
+            REQUIRE(actual[column].map_x == expected[column].map_x);
+            REQUIRE(actual[column].map_y == expected[column].map_y);
+            REQUIRE(actual[column].perp_wall_dist == expected[column].perp_wall_dist);
+        }
+    }
+    SECTION("8.3.2: Tree saved for other walls is rejected") {
+        World other = qspTestWorld(gen, 0.1);
+        QSPTree loaded;
+        REQUIRE_FALSE(loaded.load(filename, other));
+        REQUIRE(loaded.size() == 0);
+    }
+    SECTION("8.3.3: Truncated file is rejected") {
+        FILE* file = fopen(filename.c_str(), "rb");
+        REQUIRE(file != nullptr);
+        vector<char> blob(sizeof(QSPFileHeader) + built.bytes());
+        REQUIRE(fread(blob.data(), 1, blob.size(), file) == blob.size());
+        fclose(file);
+        file = fopen(filename.c_str(), "wb");
+        fwrite(blob.data(), 1, blob.size() - sizeof(QuadNode), file);
+        fclose(file);
+        QSPTree loaded;
+        REQUIRE_FALSE(loaded.load(filename, world));
+    }
+    SECTION("8.3.4: File with a child link out of the tree is rejected") {
+        FILE* file = fopen(filename.c_str(), "rb");
+        REQUIRE(file != nullptr);
+        vector<char> blob(sizeof(QSPFileHeader) + built.bytes());
+        REQUIRE(fread(blob.data(), 1, blob.size(), file) == blob.size());
+        fclose(file);
+        QuadNode* nodes = (QuadNode*) (blob.data() + sizeof(QSPFileHeader));
+        for (int32_t child : {(int32_t) built.size(), (int32_t) 0, (int32_t) -5}) {
+            nodes[0].child[2] = child;
+            file = fopen(filename.c_str(), "wb");
+            fwrite(blob.data(), 1, blob.size(), file);
+            fclose(file);
+            QSPTree loaded;
+            REQUIRE_FALSE(loaded.load(filename, world));
+            REQUIRE(loaded.size() == 0);
+        }
+    }
+    SECTION("8.3.5: File with a node outside the map or on another cell's wall is rejected") {
+        FILE* file = fopen(filename.c_str(), "rb");
+        REQUIRE(file != nullptr);
+        vector<char> blob(sizeof(QSPFileHeader) + built.bytes());
+        REQUIRE(fread(blob.data(), 1, blob.size(), file) == blob.size());
+        fclose(file);
+        QuadNode* nodes = (QuadNode*) (blob.data() + sizeof(QSPFileHeader));
+        const QuadNode original = nodes[0];
+        // Cells past each edge, and a wall index that stays in the map but belongs to another cell
+        const int16_t cells[][2] = {{-1, 0}, {QSP_TEST_MAP_SIZE, 0}, {0, -1}, {0, QSP_TEST_MAP_SIZE}};
+        for (int corruption = 0; corruption < 5; corruption++) {
+            nodes[0] = original;
+            if (corruption < 4) {
+                nodes[0].x = cells[corruption][0];
+                nodes[0].y = cells[corruption][1];
+            } else {
+                nodes[0].wall = (original.wall + 1) % (QSP_TEST_MAP_SIZE * QSP_TEST_MAP_SIZE);
+            }
+            file = fopen(filename.c_str(), "wb");
+            fwrite(blob.data(), 1, blob.size(), file);
+            fclose(file);
+            QSPTree loaded;
+            REQUIRE_FALSE(loaded.load(filename, world));
+            REQUIRE(loaded.size() == 0);
+        }
+    }
+    remove(filename.c_str());
+}
+
+TEST_CASE("8.4: Bulk loaded QSP trees are balanced and independent of the worker count", "[multi-file:8]") {
+    quietQSPLogging();
+    SECTION("8.4.1: Walls along a diagonal stay shallow") {
+        // Inserted in map order these formed one long chain
+        const int size = 1024;
+        vector<Constructs::AABB> walls;
+        for (int y = 0; y < size; y++) {
+            for (int x = 0; x < size; x++) {
+                walls.push_back(Constructs::AABB(x, y, TEX_HANDLE_MISSING, x == y ? Constructs::WallType::WALL : Constructs::WallType::NONE));
+            }
+        }
+        World world(walls, size, size);
+        QSPTree tree(world);
+        tree.buildTree();
+        REQUIRE(tree.size() == size);
+        REQUIRE(tree.depth() <= 12);
+    }
+    SECTION("8.4.2: Pooled build lays out the same nodes as a single threaded one") {
+        const int size = 512;
+        mt19937 gen(11);
+        uniform_real_distribution<double> unit(0, 1);
+        vector<Constructs::AABB> walls;
+        for (int y = 0; y < size; y++) {
+            for (int x = 0; x < size; x++) {
+                walls.push_back(Constructs::AABB(x, y, TEX_HANDLE_MISSING, unit(gen) < 0.4 ? Constructs::WallType::WALL : Constructs::WallType::NONE));
+            }
+        }
+        World world(walls, size, size);
+        QSPTree serial(world);
+        serial.buildTree();
+        WorkerPool pool;
+        pool.start(4);
+        QSPTree pooled(world);
+        pooled.buildTree(&pool);
+
+        const string serial_file = "qsp_test_serial" QSP_FILE_EXTENSION;
+        const string pooled_file = "qsp_test_pooled" QSP_FILE_EXTENSION;
+        REQUIRE(serial.save(serial_file));
+        REQUIRE(pooled.save(pooled_file));
+        vector<char> blobs[2];
+        for (int i = 0; i < 2; i++) {
+            FILE* file = fopen((i == 0 ? serial_file : pooled_file).c_str(), "rb");
+            REQUIRE(file != nullptr);
+            blobs[i].resize(sizeof(QSPFileHeader) + serial.bytes());
+            blobs[i].resize(fread(blobs[i].data(), 1, blobs[i].size(), file));
+            fclose(file);
+        }
+        remove(serial_file.c_str());
+        remove(pooled_file.c_str());
+        REQUIRE(blobs[0].size() == sizeof(QSPFileHeader) + serial.bytes());
+        REQUIRE(blobs[0] == blobs[1]);
+    }
+}
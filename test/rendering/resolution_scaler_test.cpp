@@ -0,0 +1,81 @@
+#pragma once
+
+#include <math.h>
+
+#include <random>
+
+#include "../../src/rendering/buffering/ResolutionScaler.cpp"
+#include "../framework/catch.hpp"
+
+using namespace std;
+
+#define RESOLUTION_TEST_FRAMES 600
+
+///
+/// Feed a scaler frames whose cost goes with the pixel count, with some noise,
+/// and count the scale changes made in the last half of them
+///
+/// @return int: Changes after the first half of the frames
+///
+static int driveResolutionScaler(Rendering::ResolutionScaler& scaler, double full_scale_ms, mt19937& gen) {
+    normal_distribution<double> noise(1.0, 0.05);
+    int late_changes = 0;
+    for (int frame = 0; frame < RESOLUTION_TEST_FRAMES; frame++) {
+        double frame_ms = full_scale_ms * scaler.scale * scaler.scale * noise(gen);
+        late_changes += scaler.update(frame_ms) && frame >= RESOLUTION_TEST_FRAMES / 2;
+    }
+    return late_changes;
+}
+
+TEST_CASE("11.1: Resolution scaler settles within the frame budget", "[multi-file:11]") {
+    mt19937 gen(3);
+
+    SECTION("11.1.1: Heavy frames scale down until they fit, then hold") {
+        Rendering::ResolutionScaler scaler(60, 0.25, 1.0);
+        int late_changes = driveResolutionScaler(scaler, 40.0, gen);
+        double settled_ms = 40.0 * scaler.scale * scaler.scale;
+        REQUIRE(scaler.scale < 1.0);
+        REQUIRE(settled_ms <= scaler.budget_ms);
+        REQUIRE(settled_ms >= scaler.budget_ms * RESOLUTION_HEADROOM * 0.9);
+        REQUIRE(late_changes == 0);
+    }
+    SECTION("11.1.2: Frames heavier than the minimum scale can fix stay at the minimum") {
+        Rendering::ResolutionScaler scaler(60, 0.5, 1.0);
+        driveResolutionScaler(scaler, 200.0, gen);
+        REQUIRE(scaler.scale == 0.5);
+    }
+    SECTION("11.1.3: Light frames scale back up to the maximum") {
+        Rendering::ResolutionScaler scaler(60, 0.25, 0.875);
+        driveResolutionScaler(scaler, 40.0, gen);
+        REQUIRE(scaler.scale < 0.875);
+        int late_changes = driveResolutionScaler(scaler, 4.0, gen);
+        REQUIRE(scaler.scale == 0.875);
+        REQUIRE(late_changes == 0);
+    }
+    SECTION("11.1.4: Without a refresh rate or a range the scale is fixed") {
+        Rendering::ResolutionScaler unbounded(0, 0.25, 1.0);
+        Rendering::ResolutionScaler fixed(60, 0.5, 0.5);
+        driveResolutionScaler(unbounded, 40.0, gen);
+        driveResolutionScaler(fixed, 40.0, gen);
+        REQUIRE(unbounded.scale == 1.0);
+        REQUIRE(fixed.scale == 0.5);
+        REQUIRE_FALSE(fixed.enabled());
+    }
+}
+
+TEST_CASE("11.2: Resolution scaler render sizes stay within the window", "[multi-file:11]") {
+    int width, height;
+    Rendering::ResolutionScaler scaler(60, 0.5, 2.0);
+    REQUIRE(scaler.max_scale == 1.0);
+    scaler.renderSize(1280, 800, width, height);
+    REQUIRE(width == 1280);
+    REQUIRE(height == 800);
+    scaler.scale = 0.5;
+    scaler.renderSize(1281, 801, width, height);
+    REQUIRE(width == 641);
+    REQUIRE(height == 401);
+    scaler.scale = 0.0625;
+    scaler.renderSize(8, 8, width, height);
+    REQUIRE(width == 1);
+    REQUIRE(height == 1);
+}
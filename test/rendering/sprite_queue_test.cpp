@@ -0,0 +1,158 @@
+#pragma once
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <random>
+#include <vector>
+
+#include "../../src/environment/world/World.cpp"
+#include "../../src/rendering/raycaster/SpriteQueue.cpp"
+#include "../framework/catch.hpp"
+
+using namespace std;
+
+#define SPRITE_TEST_MAP_SIZE 64
+#define SPRITE_TEST_SPRITES 2000
+#define SPRITE_TEST_FRAMES 300
+#define SPRITE_TEST_WIDTH 640
+#define SPRITE_TEST_HEIGHT 400
+
+///
+/// Sprites scattered over a map, a few textures between them
+///
+static vector<Constructs::Sprite> spriteTestSprites(mt19937& gen) {
+    uniform_real_distribution<double> unit(0, 1);
+    vector<Constructs::Sprite> sprites;
+    for (int i = 0; i < SPRITE_TEST_SPRITES; i++) {
+        sprites.push_back(Constructs::Sprite(unit(gen) * SPRITE_TEST_MAP_SIZE, unit(gen) * SPRITE_TEST_MAP_SIZE, gen() % 6));
+    }
+    return sprites;
+}
+
+///
+/// Camera looking along an angle, with the renderer's 0.66 camera plane
+///
+static ViewModel::Camera spriteTestCamera(double angle) {
+    ViewModel::Camera camera;
+    camera.frustrum.setFovX(cos(angle));
+    camera.frustrum.setFovY(sin(angle));
+    camera.clip_plane_x = -0.66 * sin(angle);
+    camera.clip_plane_y = 0.66 * cos(angle);
+    return camera;
+}
+
+///
+/// Walk and turn a camera around the map, teleporting now and then, and
+/// update a queue for every frame
+///
+template <typename Check>
+static void walkSpriteQueue(double max_depth, Check check) {
+    mt19937 gen(99);
+    uniform_real_distribution<double> unit(0, 1);
+    vector<Constructs::Sprite> sprites = spriteTestSprites(gen);
+    Rendering::SpriteQueue queue;
+    double x = SPRITE_TEST_MAP_SIZE / 2.0;
+    double y = SPRITE_TEST_MAP_SIZE / 2.0;
+    double angle = 0;
+    for (int frame = 0; frame < SPRITE_TEST_FRAMES; frame++) {
+        if (frame % 100 == 99) {
+            x = unit(gen) * SPRITE_TEST_MAP_SIZE;
+            y = unit(gen) * SPRITE_TEST_MAP_SIZE;
+        } else {
+            angle += (unit(gen) - 0.3) * 0.1;
+            x = min(max(x + cos(angle) * 0.1, 1.0), SPRITE_TEST_MAP_SIZE - 1.0);
+            y = min(max(y + sin(angle) * 0.1, 1.0), SPRITE_TEST_MAP_SIZE - 1.0);
+        }
+        ViewModel::Camera camera = spriteTestCamera(angle);
+        queue.update(sprites, x, y, camera, SPRITE_TEST_WIDTH, SPRITE_TEST_HEIGHT, max_depth);
+        check(sprites, queue, x, y, camera, frame);
+    }
+}
+
+TEST_CASE("9.1: Sprite queue draws far to near in batches of one texture", "[multi-file:9]") {
+    int out_of_order = 0;
+    int bad_batches = 0;
+    int coherent_resorts = 0;
+    int teleport_resorts = 0;
+    walkSpriteQueue(numeric_limits<double>::infinity(), [&](const vector<Constructs::Sprite>& sprites,
+        const Rendering::SpriteQueue& queue, double x, double y, const ViewModel::Camera&, int frame) {
+        const vector<Rendering::SpriteDraw>& draws = queue.draws();
+        double last = numeric_limits<double>::infinity();
+        for (const Rendering::SpriteDraw& draw : draws) {
+            double dx = sprites[draw.sprite].location.x - x;
+            double dy = sprites[draw.sprite].location.y - y;
+            double distance = dx * dx + dy * dy;
+            // Sprites within the depth quantum of each other may come in either order
+            if (distance > last * 1.001) {
+                out_of_order++;
+            }
+            last = distance;
+        }
+        size_t next = 0;
+        for (const Rendering::SpriteBatch& batch : queue.batches()) {
+            bad_batches += batch.first != next || batch.count == 0;
+            for (uint32_t i = batch.first; i < batch.first + batch.count && i < draws.size(); i++) {
+                bad_batches += draws[i].texture != batch.texture;
+            }
+            next = batch.first + batch.count;
+        }
+        bad_batches += next != draws.size();
+        // Only the first frame and the teleports should have to sort from scratch
+        coherent_resorts += queue.resorted && frame != 0 && frame % 100 != 99;
+        teleport_resorts += queue.resorted && frame % 100 == 99;
+    });
+    REQUIRE(out_of_order == 0);
+    REQUIRE(bad_batches == 0);
+    REQUIRE(coherent_resorts == 0);
+    REQUIRE(teleport_resorts > 0);
+}
+
+TEST_CASE("9.2: Sprite culling keeps every sprite the rasteriser draws", "[multi-file:9]") {
+    SECTION("9.2.1: Unbounded depth") {
+        int dropped = 0;
+        int kept_invisible = 0;
+        size_t culled = 0;
+        walkSpriteQueue(numeric_limits<double>::infinity(), [&](const vector<Constructs::Sprite>& sprites,
+            const Rendering::SpriteQueue& queue, double x, double y, const ViewModel::Camera& camera, int) {
+            vector<bool> kept(sprites.size(), false);
+            for (const Rendering::SpriteDraw& draw : queue.draws()) {
+                kept[draw.sprite] = true;
+                kept_invisible += draw.transform_y < SPRITE_NEAR_PLANE;
+            }
+            double dir_x = camera.frustrum.getFovX();
+            double dir_y = camera.frustrum.getFovY();
+            double inverse_det = 1.0 / (camera.clip_plane_x * dir_y - dir_x * camera.clip_plane_y);
+            for (size_t i = 0; i < sprites.size(); i++) {
+                double dx = sprites[i].location.x - x;
+                double dy = sprites[i].location.y - y;
+                double transform_x = inverse_det * (dir_y * dx - dir_x * dy);
+                double transform_y = inverse_det * (-camera.clip_plane_y * dx + camera.clip_plane_x * dy);
+                if (transform_y < SPRITE_NEAR_PLANE) {
+                    continue;
+                }
+                // Columns the rasteriser would draw
+                int screen_x = (int) (SPRITE_TEST_WIDTH / 2 * (1 + transform_x / transform_y));
+                int width = abs((int) (SPRITE_TEST_HEIGHT / transform_y));
+                int start = max(-width / 2 + screen_x, 1);
+                int end = min(width / 2 + screen_x, SPRITE_TEST_WIDTH - 1);
+                dropped += start < end && !kept[i];
+            }
+            culled += queue.culled;
+        });
+        REQUIRE(dropped == 0);
+        REQUIRE(kept_invisible == 0);
+        // Most of the map is outside a 67 degree view
+        REQUIRE(culled > SPRITE_TEST_FRAMES * SPRITE_TEST_SPRITES / 2);
+    }
+    SECTION("9.2.2: Bounded depth") {
+        int beyond = 0;
+        walkSpriteQueue(8.0, [&](const vector<Constructs::Sprite>&, const Rendering::SpriteQueue& queue,
+            double, double, const ViewModel::Camera&, int) {
+            for (const Rendering::SpriteDraw& draw : queue.draws()) {
+                beyond += draw.transform_y > 8.0;
+            }
+        });
+        REQUIRE(beyond == 0);
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../../src/rendering/texturing/TextureAtlas.cpp"
+#include "../framework/catch.hpp"
+
+using namespace std;
+
+///
+/// Texture whose every texel is distinct, so a texel read from the wrong place shows
+///
+static Texture layoutTestTexture(unsigned long width, unsigned long height) {
+    Texture tex;
+    tex.width = width;
+    tex.height = height;
+    tex.texture.resize(width * height);
+    for (unsigned long i = 0; i < tex.texture.size(); i++) {
+        tex.texture[i] = 0xFF000000 | (uint32_t) i;
+    }
+    return tex;
+}
+
+TEST_CASE("14.1: Texture atlas layouts hold the same texels", "[multi-file:14]") {
+    map<string, Texture> textures;
+    textures["square"] = layoutTestTexture(32, 32);
+    textures["tall"] = layoutTestTexture(4, 64);
+    textures["wide"] = layoutTestTexture(64, 2);
+    Rendering::TextureAtlas atlas;
+    atlas.build(textures, 8, 8);
+
+    SECTION("14.1.1: Every level has each texel at its place in every layout") {
+        int wrong = 0;
+        for (const char* name : {"square", "tall", "wide"}) {
+            Rendering::TexHandle handle = atlas.handle(name);
+            for (uint32_t l = 0; l < atlas.entry(handle).levels; l++) {
+                const Rendering::AtlasEntry& level = atlas.level(handle, l);
+                const uint32_t* rows = atlas.texels(level);
+                const uint32_t* columns = atlas.texels(level, Rendering::COLUMN_MAJOR);
+                const uint32_t* morton = atlas.texels(level, Rendering::MORTON);
+                const uint32_t* swizzle = atlas.swizzle(level);
+                for (uint32_t y = 0; y < level.height; y++) {
+                    for (uint32_t x = 0; x < level.width; x++) {
+                        uint32_t texel = rows[(y << level.width_shift) + x];
+                        wrong += columns[(x << level.height_shift) + y] != texel;
+                        wrong += morton[swizzle[x] | swizzle[level.width + y]] != texel;
+                    }
+                }
+            }
+        }
+        REQUIRE(wrong == 0);
+    }
+    SECTION("14.1.2: Morton offsets cover the level once each") {
+        for (const char* name : {"square", "tall", "wide"}) {
+            const Rendering::AtlasEntry& level = atlas.entry(atlas.handle(name));
+            const uint32_t* swizzle = atlas.swizzle(level);
+            vector<int> hits(level.width * level.height, 0);
+            for (uint32_t y = 0; y < level.height; y++) {
+                for (uint32_t x = 0; x < level.width; x++) {
+                    uint32_t offset = swizzle[x] | swizzle[level.width + y];
+                    REQUIRE(offset < hits.size());
+                    hits[offset]++;
+                }
+            }
+            REQUIRE(count(hits.begin(), hits.end(), 1) == (int) hits.size());
+        }
+    }
+    SECTION("14.1.3: A 4x4 block of texels is one run of 16 in Morton order") {
+        const Rendering::AtlasEntry& level = atlas.entry(atlas.handle("square"));
+        const uint32_t* swizzle = atlas.swizzle(level);
+        for (uint32_t by = 0; by < level.height; by += 4) {
+            for (uint32_t bx = 0; bx < level.width; bx += 4) {
+                uint32_t first = swizzle[bx] | swizzle[level.width + by];
+                REQUIRE(first % 16 == 0);
+                for (uint32_t y = by; y < by + 4; y++) {
+                    for (uint32_t x = bx; x < bx + 4; x++) {
+                        REQUIRE((swizzle[x] | swizzle[level.width + y]) - first < 16);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("14.2: Quantized texels follow the same layouts", "[multi-file:14]") {
+    map<string, Texture> textures;
+    textures["square"] = layoutTestTexture(16, 16);
+    Rendering::TextureAtlas atlas;
+    atlas.build(textures, 8, 8);
+    Rendering::Palette palette;
+    palette.build(atlas.allTexels().data(), atlas.allTexels().size(), 0xFF000000);
+    atlas.quantize(palette);
+    const Rendering::AtlasEntry& level = atlas.level(atlas.handle("square"), 1);
+    const uint8_t* rows = atlas.indices(level);
+    const uint8_t* columns = atlas.indices(level, Rendering::COLUMN_MAJOR);
+    const uint8_t* morton = atlas.indices(level, Rendering::MORTON);
+    const uint32_t* swizzle = atlas.swizzle(level);
+    int wrong = 0;
+    for (uint32_t y = 0; y < level.height; y++) {
+        for (uint32_t x = 0; x < level.width; x++) {
+            uint8_t index = rows[(y << level.width_shift) + x];
+            wrong += columns[(x << level.height_shift) + y] != index;
+            wrong += morton[swizzle[x] | swizzle[level.width + y]] != index;
+        }
+    }
+    REQUIRE(wrong == 0);
+}
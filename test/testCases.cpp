@@ -1,4 +1,6 @@
 #define CATCH_CONFIG_MAIN
+// The alternate signal stack is sized from MINSIGSTKSZ, which newer glibc no longer makes a constant
+#define CATCH_CONFIG_NO_POSIX_SIGNALS
 
 #include "framework/catch.hpp"
 
@@ -9,7 +11,19 @@
 // #include "io/BMP_read_test.cpp"
 #include "io/INI_read_test.cpp"
 #include "io/JSON_read_test.cpp"
+#include "io/input_recording_test.cpp"
 // #include "pathfinding/AStar_test.cpp"
+#include "rendering/column_sampler_test.cpp"
+#include "rendering/dda_test.cpp"
+#include "rendering/qsp_test.cpp"
+#include "rendering/sprite_queue_test.cpp"
+#include "rendering/hiz_test.cpp"
+#include "rendering/resolution_scaler_test.cpp"
+#include "rendering/mipmap_test.cpp"
+#include "rendering/palette_test.cpp"
+#include "rendering/texture_layout_test.cpp"
+#include "timing/fixed_timestep_test.cpp"
+#include "timing/frame_stats_test.cpp"
 
 TEST_CASE("All test cases reside in other .cpp files (empty)", "[multi-file:1]") {
 }
\ No newline at end of file
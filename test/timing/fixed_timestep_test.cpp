@@ -0,0 +1,97 @@
+#pragma once
+
+#include <math.h>
+
+#include <random>
+
+#include "../../src/logic/timing/FixedTimestep.cpp"
+#include "../../src/rendering/viewmodel/Camera.hpp"
+#include "../framework/catch.hpp"
+
+using namespace std;
+
+///
+/// Run a second of frames at about a frame rate, with some jitter
+///
+/// @return uint64_t: Steps run over the second
+///
+static uint64_t stepsInASecond(FixedTimestep& clock, double frame_rate, mt19937& gen) {
+    uniform_real_distribution<double> jitter(0.5, 1.5);
+    uint64_t start = clock.steps;
+    double elapsed = 0;
+    while (elapsed < 1.0) {
+        double frame = min(jitter(gen) / frame_rate, 1.0 - elapsed);
+        elapsed += frame;
+        clock.advance(frame);
+    }
+    return clock.steps - start;
+}
+
+static ViewModel::Camera timestepTestCamera(double x, double y, double angle) {
+    ViewModel::Camera camera{x, y, -0.66 * sin(angle), 0.66 * cos(angle), ViewModel::Frustrum()};
+    camera.frustrum.setFovX(cos(angle));
+    camera.frustrum.setFovY(sin(angle));
+    return camera;
+}
+
+TEST_CASE("15.1: Fixed timestep runs the same steps at any frame rate", "[multi-file:15]") {
+    mt19937 gen(7);
+
+    SECTION("15.1.1: A second is 60 steps at 20, 60, 144 and 500 frames per second") {
+        for (double frame_rate : {20.0, 60.0, 144.0, 500.0}) {
+            FixedTimestep clock(60);
+            uint64_t steps = stepsInASecond(clock, frame_rate, gen);
+            REQUIRE(steps >= 59);
+            REQUIRE(steps <= 60);
+            REQUIRE(clock.alpha() >= 0.0);
+            REQUIRE(clock.alpha() < 1.0);
+        }
+    }
+    SECTION("15.1.2: Time short of a step carries over to the next frame") {
+        FixedTimestep clock(10);
+        REQUIRE(clock.advance(0.04) == 0);
+        REQUIRE(clock.alpha() == Approx(0.4));
+        REQUIRE(clock.advance(0.08) == 1);
+        REQUIRE(clock.alpha() == Approx(0.2));
+    }
+    SECTION("15.1.3: A stall runs at most the step limit, then keeps pace") {
+        FixedTimestep clock(60, 4);
+        REQUIRE(clock.advance(2.0) == 4);
+        REQUIRE(clock.alpha() < 1.0);
+        REQUIRE(stepsInASecond(clock, 100.0, gen) >= 59);
+    }
+}
+
+TEST_CASE("15.2: Views are interpolated between simulation steps", "[multi-file:15]") {
+    ViewModel::Camera from = timestepTestCamera(2, 3, 0.5);
+    ViewModel::Camera to = timestepTestCamera(4, 2, 0.9);
+
+    SECTION("15.2.1: The ends are the two views") {
+        ViewModel::Camera start = ViewModel::interpolate(from, to, 0);
+        ViewModel::Camera end = ViewModel::interpolate(from, to, 1);
+        REQUIRE(start.x == from.x);
+        REQUIRE(start.frustrum.getFovX() == from.frustrum.getFovX());
+        REQUIRE(start.clip_plane_y == from.clip_plane_y);
+        REQUIRE(end.x == Approx(to.x));
+        REQUIRE(end.y == Approx(to.y));
+        REQUIRE(end.frustrum.getFovX() == Approx(to.frustrum.getFovX()));
+        REQUIRE(end.frustrum.getFovY() == Approx(to.frustrum.getFovY()));
+        REQUIRE(end.clip_plane_x == Approx(to.clip_plane_x));
+        REQUIRE(end.clip_plane_y == Approx(to.clip_plane_y));
+    }
+    SECTION("15.2.2: Halfway turns half the angle and keeps the FOV") {
+        ViewModel::Camera half = ViewModel::interpolate(from, to, 0.5);
+        ViewModel::Camera expected = timestepTestCamera(3, 2.5, 0.7);
+        REQUIRE(half.x == Approx(expected.x));
+        REQUIRE(half.y == Approx(expected.y));
+        REQUIRE(half.frustrum.getFovX() == Approx(expected.frustrum.getFovX()));
+        REQUIRE(half.frustrum.getFovY() == Approx(expected.frustrum.getFovY()));
+        REQUIRE(half.clip_plane_x == Approx(expected.clip_plane_x));
+        REQUIRE(half.clip_plane_y == Approx(expected.clip_plane_y));
+    }
+    SECTION("15.2.3: Turning across facing -x takes the short way round") {
+        ViewModel::Camera half = ViewModel::interpolate(timestepTestCamera(0, 0, M_PI - 0.1), timestepTestCamera(0, 0, -M_PI + 0.1), 0.5);
+        REQUIRE(half.frustrum.getFovX() == Approx(-1.0));
+        REQUIRE(half.frustrum.getFovY() == Approx(0.0).margin(1e-9));
+    }
+}
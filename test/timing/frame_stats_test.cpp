@@ -0,0 +1,28 @@
+#pragma once
+
+#include <vector>
+
+#include "../../src/logic/timing/FrameStats.cpp"
+#include "../framework/catch.hpp"
+
+using namespace std;
+
+TEST_CASE("17.1: Frame stats report nearest rank percentiles per stage", "[multi-file:17]") {
+    FrameStats stats({"walls", "sprites"});
+    // Added out of order, sprites take a tenth of the walls
+    for (int i = 0; i < 100; i++) {
+        double ms = (i * 37) % 100 + 1;
+        stats.add({ms, ms / 10});
+    }
+    REQUIRE(stats.frames() == 100);
+    REQUIRE(stats.percentile(0, 50) == 50);
+    REQUIRE(stats.percentile(0, 95) == 95);
+    REQUIRE(stats.percentile(0, 99) == 99);
+    REQUIRE(stats.percentile(0, 100) == 100);
+    REQUIRE(stats.percentile(0, 0) == 1);
+    REQUIRE(stats.percentile(1, 95) == Approx(9.5));
+    REQUIRE(stats.report().find("sprites") != string::npos);
+
+    FrameStats empty({"walls"});
+    REQUIRE(empty.percentile(0, 50) == 0);
+}